@@ -0,0 +1,82 @@
+#include "src/gf4.h"
+#include "src/scaling.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+
+/*
+ * Scaling benchmark: measures the kernels of standard_scaling_kernels over a geometric range of block sizes,
+ * fits their complexity exponents and optionally compares them with a stored report.
+ *
+ * usage: mdpc_gf4_benchmark [--min N] [--max N] [--steps K] [--seconds S] [--out report.json]
+ *                           [--baseline report.json] [--reference N] [--exponent-tolerance E] [--time-tolerance F]
+ * The predicted times are compared at the reference size, which defaults to the largest measured size.
+ * Exits with 1 if a kernel moved compared to the baseline (see compare_scaling).
+ */
+int main(int argc, char** argv) {
+    size_t min_n = 1000;
+    size_t max_n = 16000;
+    size_t steps = 5;
+    double seconds = 0.2;
+    size_t reference_n = 0;
+    double exponent_tolerance = 0.15;
+    double time_tolerance = 1.5;
+    std::string out_path;
+    std::string baseline_path;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--min") {
+            min_n = std::stoul(value);
+        } else if (option == "--max") {
+            max_n = std::stoul(value);
+        } else if (option == "--steps") {
+            steps = std::stoul(value);
+        } else if (option == "--seconds") {
+            seconds = std::stod(value);
+        } else if (option == "--out") {
+            out_path = value;
+        } else if (option == "--baseline") {
+            baseline_path = value;
+        } else if (option == "--reference") {
+            reference_n = std::stoul(value);
+        } else if (option == "--exponent-tolerance") {
+            exponent_tolerance = std::stod(value);
+        } else if (option == "--time-tolerance") {
+            time_tolerance = std::stod(value);
+        } else {
+            std::cerr << "unknown option " << option << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<size_t> sizes = geometric_sizes(min_n, max_n, steps);
+    if (reference_n == 0) {
+        reference_n = sizes.back();
+    }
+    auto fits = run_scaling(standard_scaling_kernels<GF4>(), sizes, seconds);
+    for (const auto& fit: fits) {
+        std::cout << fit.name << ": n^" << fit.exponent << ", " << fit.predict((double)reference_n) << " s at n = " << reference_n << std::endl;
+    }
+    if (!out_path.empty()) {
+        std::ofstream out{out_path};
+        write_scaling_report(out, fits);
+    }
+    if (!baseline_path.empty()) {
+        std::ifstream in{baseline_path};
+        auto baseline = read_scaling_report(in);
+        if (!baseline) {
+            std::cerr << "cannot read " << baseline_path << std::endl;
+            return 2;
+        }
+        auto regressions = compare_scaling(baseline.value(), fits, (double)reference_n, exponent_tolerance, time_tolerance);
+        for (const auto& regression: regressions) {
+            std::cout << "MOVED " << regression.name << ": n^" << regression.baseline_exponent << " -> n^" << regression.exponent
+                      << ", time at n = " << reference_n << " x" << regression.time_ratio << std::endl;
+        }
+        return regressions.empty() ? 0 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "src/gf4.h"
+#include "src/key_file.h"
+#include "src/parameter_sets.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+
+/*
+ * Key provisioning: fills a key file (see key_file.h) with freshly generated key pairs using all cores.
+ * Running it again on an interrupted file generates only the missing key pairs.
+ *
+ * usage: mdpc_gf4_provision keys.bin --count N [--parameter-set name | --block-size n --block-weight w] [--threads K]
+ */
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " keys.bin --count N [options]" << std::endl;
+        return 2;
+    }
+    size_t count = 0;
+    size_t block_size = 2339;
+    size_t block_weight = 37;
+    size_t num_threads = 0;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--count") {
+            count = std::stoul(value);
+        } else if (option == "--parameter-set") {
+            try {
+                const ParameterSet& set = get_parameter_set(value);
+                block_size = set.block_size;
+                block_weight = set.block_weight;
+            } catch (UnknownParameterSet& e) {
+                std::cerr << value << ": " << e.what() << std::endl;
+                return 2;
+            }
+        } else if (option == "--block-size") {
+            block_size = std::stoul(value);
+        } else if (option == "--block-weight") {
+            block_weight = std::stoul(value);
+        } else if (option == "--threads") {
+            num_threads = std::stoul(value);
+        } else {
+            std::cerr << "unknown option " << option << std::endl;
+            return 2;
+        }
+    }
+    if (count == 0) {
+        std::cerr << "--count is required" << std::endl;
+        return 2;
+    }
+
+    try {
+        auto file = KeyFile<GF4>::create(argv[1], count, block_size, block_weight);
+        size_t complete = file.count_complete();
+        if (complete != 0) {
+            std::cout << "resuming, " << complete << " of " << count << " key pairs present" << std::endl;
+        }
+        auto start = std::chrono::steady_clock::now();
+        size_t generated = provision_key_file(file, num_threads, [](size_t done, size_t total) {
+            if (done % 100 == 0 || done == total) {
+                std::cout << "\r" << done << " / " << total << std::flush;
+            }
+        });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << (generated != 0 ? "\n" : "") << generated << " key pairs generated in " << seconds << " s" << std::endl;
+    } catch (InvalidKeyFile& e) {
+        std::cerr << argv[1] << ": " << e.what() << std::endl;
+        return 1;
+    } catch (KeyFileIOError& e) {
+        std::cerr << argv[1] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
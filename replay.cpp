@@ -0,0 +1,60 @@
+#include "src/gf4.h"
+#include "src/trace.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+
+/*
+ * Trace replayer: drives the library with the requests of a trace recorded by TraceRecorder (see trace.h)
+ * against locally generated keys and reports latency and throughput.
+ *
+ * usage: mdpc_gf4_replay trace.bin [--speed X] [--threads K] [--block-weight W] [--error-weight T]
+ *                        [--iterations I] [--max-keys K]
+ */
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " trace.bin [options]" << std::endl;
+        return 2;
+    }
+    ReplayOptions options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--speed") {
+            options.speed = std::stod(value);
+        } else if (option == "--threads") {
+            options.num_threads = std::stoul(value);
+        } else if (option == "--block-weight") {
+            options.block_weight = std::stoul(value);
+        } else if (option == "--error-weight") {
+            options.error_weight = std::stoul(value);
+        } else if (option == "--iterations") {
+            options.num_iterations = std::stoul(value);
+        } else if (option == "--max-keys") {
+            options.max_keys = std::stoul(value);
+        } else {
+            std::cerr << "unknown option " << option << std::endl;
+            return 2;
+        }
+    }
+
+    std::ifstream in{argv[1], std::ios::binary};
+    auto records = read_trace(in);
+    if (!records) {
+        std::cerr << "cannot read " << argv[1] << std::endl;
+        return 2;
+    }
+    ReplayReport report = replay_trace<GF4>(records.value(), options);
+    auto print = [](const char* name, const LatencySummary& summary) {
+        std::cout << name << ": " << summary.count << " requests, latency p50 " << summary.p50 * 1e3 << " ms, p90 "
+                  << summary.p90 * 1e3 << " ms, p99 " << summary.p99 * 1e3 << " ms, max " << summary.max * 1e3 << " ms" << std::endl;
+    };
+    std::cout << records->size() << " requests in " << report.wall_seconds << " s, " << report.throughput << " requests/s" << std::endl;
+    print("encode", report.encode);
+    print("decode", report.decode);
+    print("recorded encode", report.recorded_encode);
+    print("recorded decode", report.recorded_decode);
+    std::cout << "decode failures: " << report.decode_failures << " (recorded " << report.recorded_decode_failures << ")" << std::endl;
+    return 0;
+}
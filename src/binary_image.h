@@ -0,0 +1,370 @@
+#ifndef MDPC_GF4_BINARY_IMAGE_H
+#define MDPC_GF4_BINARY_IMAGE_H
+
+#include <vector>
+#include <array>
+#include <optional>
+#include <algorithm>
+#include <cstdint>
+#include "contexts.h"
+#include "gf4.h"
+#include "bitsliced_gf4.h"
+#include "stagnation.h"
+#include "custom_exceptions.h"
+
+/**
+ * @brief Parameters of the binary first pass of BinaryImageDecoder.
+ */
+struct BinaryFlippingPolicy {
+    size_t max_iterations = 8;    ///< The maximum number of iterations on the binary image, 0 disables the first pass.
+    size_t threshold_delta = 2;   ///< Columns with at least (the largest count - threshold_delta) unsatisfied checks are flipped.
+                                  ///< Larger values flip more per iteration, but also more wrong columns.
+};
+
+/**
+ * @brief Decoder over GF(4) which starts with a bit-flipping decoder on the binary image of H.
+ *
+ * An element x0 + x1*alpha of GF(4) is the pair of bits (x0, x1) and multiplication by a fixed a is a fixed linear map
+ * of the pair (see BitslicedGF4Vector):
+ *  + 1 * (x0, x1) = (x0, x1)
+ *  + alpha * (x0, x1) = (x1, x0 ^ x1)
+ *  + (alpha + 1) * (x0, x1) = (x0 ^ x1, x0)
+ * So every GF(4) parity check is a pair of binary parity checks (low and high bit of the syndrome)
+ * over the low and high bits of the error vector, and each circulant block of H becomes 2x2 binary circulant blocks.
+ * The low bit of the syndrome depends on the low bit of the error where h[k] is 1 or alpha + 1, and on the high bit
+ * where h[k] is alpha or alpha + 1. The high bit of the syndrome depends on the low bit where h[k] is alpha or alpha + 1,
+ * and on the high bit where h[k] is 1 or alpha.
+ *
+ * Besides the columns of the low and high bit, every position also gets the column of both bits (their sum), so that
+ * a symbol with both bits wrong is fixed by one flip. Flipping only one of its bits would fix about half of its checks
+ * and break the other half, which a bit-flipping decoder does not do.
+ *
+ * The binary decoder keeps the syndrome and the error as packed bits, counts the unsatisfied checks of all columns
+ * in bit-sliced counters (the p-th plane holds the p-th bit of the count of each column) and flips all columns whose count is close to the largest one.
+ * This costs a few word operations per 64 positions and binary check, so most decodings finish in the binary domain.
+ * Whatever remains is handed to DecodingContext::decode_with_report, which continues from the partially corrected vector.
+ * Wrong binary flips can leave that vector beyond what the GF(4) decoder corrects, so if the continuation fails,
+ * the flips are dropped and the GF(4) decoder runs on the original vector. The first pass therefore never turns
+ * a decoding which DecodingContext::decode_with_report finishes into a failure, it only costs time on such vectors.
+ */
+class BinaryImageDecoder {
+public:
+    /**
+     * @brief Expand the private key to its binary image.
+     *
+     * The decoding context must outlive the decoder.
+     *
+     * @param dc The decoding context holding the private key.
+     * @param policy Parameters of the binary first pass.
+     */
+    explicit BinaryImageDecoder(const DecodingContext<GF4>& dc, const BinaryFlippingPolicy& policy = BinaryFlippingPolicy{})
+            : dc(dc), policy(policy), block_size(dc.get_block_size()), num_words((dc.get_block_size() + 63) / 64) {
+        const std::vector<GF4>* blocks[2] = {&dc.get_h0(), &dc.get_h1()};
+        for (size_t b = 0; b < 2; ++b) {
+            const std::vector<GF4>& h = *blocks[b];
+            for (size_t k = 0; k < h.size(); ++k) {
+                uint8_t a = h[k].get_value();
+                // the bits of a * value are the syndrome bits touched by flipping the error by value
+                for (size_t value = 1; value < 4; ++value) {
+                    uint8_t image = GF4_MULTIPLICATION[a][value];
+                    for (size_t p = 0; p < 2; ++p) {
+                        if ((image >> p) & 1u) {
+                            offsets[3 * b + value - 1][p].push_back(k);
+                        }
+                    }
+                }
+            }
+        }
+        for (size_t u = 0; u < 6; ++u) {
+            column_weight[u] = offsets[u][0].size() + offsets[u][1].size();
+        }
+    }
+
+    /**
+     * @brief Decode the given vector.
+     *
+     * @param message A vector of length 2*block_size.
+     * @param num_iterations Number of iterations of the GF(4) decoding after the binary pass.
+     * @return The error vector of length 2*block_size on success, nothing on failure.
+     */
+    [[nodiscard]] auto decode(const std::vector<GF4>& message, size_t num_iterations) const -> std::optional<std::vector<GF4>> {
+        return decode_with_report(message, num_iterations, StagnationPolicy{}).error_vector;
+    }
+
+    /**
+     * @brief Decode the given vector and report how the decoding went.
+     *
+     * The binary pass runs for at most BinaryFlippingPolicy::max_iterations iterations and stops as soon as the syndrome
+     * is zero or its weight stops decreasing. If the syndrome is not zero, the GF(4) decoder continues
+     * from the corrected vector, and if that fails, it decodes the original vector instead (see binary_fallback).
+     * The report contains the GF(4) syndrome weights of the binary pass and of the last GF(4) decoding.
+     *
+     * @throws IncorrectInputVectorLength if the message is not of length 2*block_size.
+     * @param message A vector of length 2*block_size.
+     * @param num_iterations Maximum number of iterations of the GF(4) decoding.
+     * @param stagnation Rules for early failure detection of the GF(4) decoding.
+     * @param post_processing Rules for post-processing of the GF(4) decoding.
+     * @return The result of decoding.
+     */
+    [[nodiscard]] auto decode_with_report(const std::vector<GF4>& message, size_t num_iterations, const StagnationPolicy& stagnation,
+                                          const PostProcessingPolicy& post_processing = PostProcessingPolicy{}) const -> DecodingResult<GF4> {
+        if (message.size() != 2 * block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+        BitslicedGF4Vector packed_syndrome{dc.calculate_syndrome(message)};
+        std::array<std::vector<uint64_t>, 2> syndrome = {packed_syndrome.get_low_words(), packed_syndrome.get_high_words()};
+        // error[2 * b + v] holds the bit v of the error in the block b
+        std::array<std::vector<uint64_t>, 4> error;
+        for (auto& plane: error) {
+            plane.assign(num_words, 0);
+        }
+
+        std::vector<size_t> syndrome_weights = {weight(syndrome)};
+        size_t binary_iterations = 0;
+        while (syndrome_weights.back() != 0 && binary_iterations < policy.max_iterations) {
+            std::array<std::vector<uint64_t>, 6> flips = select_flips(syndrome);
+            for (size_t u = 0; u < 6; ++u) {
+                flip(u, flips[u], error, syndrome);
+            }
+            ++binary_iterations;
+            size_t syndrome_weight = weight(syndrome);
+            // an iteration which keeps the weight may still fix one bit of a symbol with both bits wrong,
+            // but two in a row mean the pass is going in circles
+            bool stalled = syndrome_weights.size() >= 2 && syndrome_weight == syndrome_weights.back() &&
+                           syndrome_weights.back() == syndrome_weights[syndrome_weights.size() - 2];
+            if (syndrome_weight > syndrome_weights.back() || stalled) {
+                // the pass does not help anymore, undo the last iteration and let the GF(4) decoder continue
+                for (size_t u = 0; u < 6; ++u) {
+                    flip(u, flips[u], error, syndrome);
+                }
+                break;
+            }
+            syndrome_weights.push_back(syndrome_weight);
+        }
+
+        std::vector<GF4> error_vector(2 * block_size);
+        for (size_t j = 0; j < 2 * block_size; ++j) {
+            size_t b = j / block_size;
+            size_t c = j % block_size;
+            size_t x0 = (error[2 * b][c / 64] >> (c % 64)) & 1u;
+            size_t x1 = (error[2 * b + 1][c / 64] >> (c % 64)) & 1u;
+            error_vector[j] = GF4{x0 | (x1 << 1)};
+        }
+
+        DecodingResult<GF4> result;
+        if (syndrome_weights.back() == 0) {
+            result.error_vector = error_vector;
+            result.status = DecodingStatus::Success;
+        } else {
+            std::vector<GF4> corrected{message};
+            for (size_t j = 0; j < corrected.size(); ++j) {
+                corrected[j] += error_vector[j];
+            }
+            result = dc.decode_with_report(corrected, num_iterations, stagnation, post_processing);
+            if (result.error_vector) {
+                for (size_t j = 0; j < error_vector.size(); ++j) {
+                    result.error_vector.value()[j] += error_vector[j];
+                }
+                syndrome_weights.insert(syndrome_weights.end(), result.syndrome_weights.begin() + 1, result.syndrome_weights.end());
+            } else {
+                result = dc.decode_with_report(message, num_iterations, stagnation, post_processing);
+                result.binary_fallback = true;
+                syndrome_weights = result.syndrome_weights;
+            }
+        }
+        result.binary_iterations = binary_iterations;
+        result.syndrome_weights = syndrome_weights;
+        return result;
+    }
+
+private:
+    /**
+     * @brief Get the GF(4) weight of the syndrome, i.e. the number of positions where either bit is set.
+     */
+    [[nodiscard]] auto weight(const std::array<std::vector<uint64_t>, 2>& syndrome) const -> size_t {
+        size_t out = 0;
+        for (size_t q = 0; q < num_words; ++q) {
+            out += __builtin_popcountll(syndrome[0][q] | syndrome[1][q]);
+        }
+        return out;
+    }
+
+    /**
+     * @brief Count the unsatisfied checks of every column and select the columns to flip.
+     *
+     * @param syndrome The low and high bits of the syndrome.
+     * @return For each of the six columns of a position (see offsets), the mask of positions to flip.
+     */
+    [[nodiscard]] auto select_flips(const std::array<std::vector<uint64_t>, 2>& syndrome) const -> std::array<std::vector<uint64_t>, 6> {
+        // doubled copy of the syndrome with a word of padding, so that any window of 64 rotated bits can be read directly
+        size_t doubled_words = (2 * block_size + 63) / 64 + 1;
+        std::array<std::vector<uint64_t>, 2> doubled;
+        for (size_t p = 0; p < 2; ++p) {
+            doubled[p].assign(doubled_words, 0);
+            for (size_t copy = 0; copy < 2; ++copy) {
+                size_t offset = copy * block_size;
+                for (size_t q = 0; q < num_words; ++q) {
+                    size_t bit = offset + 64 * q;
+                    doubled[p][bit / 64] |= syndrome[p][q] << (bit % 64);
+                    if (bit % 64 != 0) {
+                        doubled[p][bit / 64 + 1] |= syndrome[p][q] >> (64 - bit % 64);
+                    }
+                }
+            }
+        }
+        auto window = [](const std::vector<uint64_t>& words, size_t bit) -> uint64_t {
+            uint64_t w = words[bit / 64] >> (bit % 64);
+            if (bit % 64 != 0) {
+                w |= words[bit / 64 + 1] << (64 - bit % 64);
+            }
+            return w;
+        };
+        uint64_t last_word_mask = (block_size % 64 == 0) ? ~uint64_t{0} : (uint64_t{1} << (block_size % 64)) - 1;
+
+        // counters[u][i * num_words + q] holds the i-th bit of the count of unsatisfied checks
+        size_t num_planes = 1;
+        while ((size_t{1} << num_planes) <= *std::max_element(column_weight.begin(), column_weight.end())) {
+            ++num_planes;
+        }
+        std::array<std::vector<uint64_t>, 6> counters;
+        for (size_t u = 0; u < 6; ++u) {
+            counters[u].assign(num_planes * num_words, 0);
+            for (size_t p = 0; p < 2; ++p) {
+                for (size_t k: offsets[u][p]) {
+                    // the position c is in the checks (c - k) mod n
+                    for (size_t q = 0; q < num_words; ++q) {
+                        uint64_t carry = window(doubled[p], block_size - k + 64 * q);
+                        for (size_t i = 0; i < num_planes && carry != 0; ++i) {
+                            uint64_t& plane = counters[u][i * num_words + q];
+                            uint64_t next = plane & carry;
+                            plane ^= carry;
+                            carry = next;
+                        }
+                    }
+                }
+            }
+            for (size_t i = 0; i < num_planes; ++i) {
+                counters[u][i * num_words + num_words - 1] &= last_word_mask;
+            }
+        }
+
+        // the largest count over all columns, found bit by bit from the most significant one
+        size_t largest = 0;
+        std::array<std::vector<uint64_t>, 6> candidates;
+        for (size_t u = 0; u < 6; ++u) {
+            candidates[u].assign(num_words, ~uint64_t{0});
+        }
+        for (size_t i = num_planes; i > 0; --i) {
+            bool any = false;
+            for (size_t u = 0; u < 6 && !any; ++u) {
+                for (size_t q = 0; q < num_words && !any; ++q) {
+                    any = (candidates[u][q] & counters[u][(i - 1) * num_words + q]) != 0;
+                }
+            }
+            if (any) {
+                largest |= size_t{1} << (i - 1);
+                for (size_t u = 0; u < 6; ++u) {
+                    for (size_t q = 0; q < num_words; ++q) {
+                        candidates[u][q] &= counters[u][(i - 1) * num_words + q];
+                    }
+                }
+            }
+        }
+
+        // flip the columns with count >= threshold, where a column must also have a majority of its checks unsatisfied
+        std::array<std::vector<uint64_t>, 6> flips;
+        for (size_t u = 0; u < 6; ++u) {
+            size_t threshold = std::max(largest - std::min(largest, policy.threshold_delta), column_weight[u] / 2 + 1);
+            flips[u].assign(num_words, 0);
+            if ((threshold >> num_planes) != 0) {
+                continue;
+            }
+            for (size_t q = 0; q < num_words; ++q) {
+                // bit-sliced comparison count >= threshold
+                uint64_t greater = 0;
+                uint64_t equal = ~uint64_t{0};
+                for (size_t i = num_planes; i > 0; --i) {
+                    uint64_t plane = counters[u][(i - 1) * num_words + q];
+                    if ((threshold >> (i - 1)) & 1u) {
+                        equal &= plane;
+                    } else {
+                        greater |= equal & plane;
+                        equal &= ~plane;
+                    }
+                }
+                flips[u][q] = greater | equal;
+            }
+        }
+
+        // at most one of the three columns of a position is flipped, the one with the largest count
+        for (size_t b = 0; b < 2; ++b) {
+            for (size_t q = 0; q < num_words; ++q) {
+                uint64_t& m1 = flips[3 * b][q];
+                uint64_t& m2 = flips[3 * b + 1][q];
+                uint64_t& m3 = flips[3 * b + 2][q];
+                uint64_t conflicts = (m1 & m2) | (m1 & m3) | (m2 & m3);
+                while (conflicts != 0) {
+                    unsigned bit = __builtin_ctzll(conflicts);
+                    conflicts &= conflicts - 1;
+                    size_t best = 0;
+                    size_t best_count = 0;
+                    for (size_t value = 0; value < 3; ++value) {
+                        size_t count = 0;
+                        for (size_t i = 0; i < num_planes; ++i) {
+                            count |= ((counters[3 * b + value][i * num_words + q] >> bit) & 1u) << i;
+                        }
+                        if (((flips[3 * b + value][q] >> bit) & 1u) && count > best_count) {
+                            best = value;
+                            best_count = count;
+                        }
+                    }
+                    for (size_t value = 0; value < 3; ++value) {
+                        if (value != best) {
+                            flips[3 * b + value][q] &= ~(uint64_t{1} << bit);
+                        }
+                    }
+                }
+            }
+        }
+        return flips;
+    }
+
+    /**
+     * @brief Flip the selected positions of the error by the value of the column and update the syndrome.
+     */
+    auto flip(size_t u, const std::vector<uint64_t>& mask, std::array<std::vector<uint64_t>, 4>& error,
+              std::array<std::vector<uint64_t>, 2>& syndrome) const -> void {
+        size_t b = u / 3;
+        size_t value = u % 3 + 1;
+        for (size_t q = 0; q < num_words; ++q) {
+            uint64_t bits = mask[q];
+            if (value & 1u) {
+                error[2 * b][q] ^= bits;
+            }
+            if (value & 2u) {
+                error[2 * b + 1][q] ^= bits;
+            }
+            while (bits != 0) {
+                size_t c = 64 * q + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                for (size_t p = 0; p < 2; ++p) {
+                    for (size_t k: offsets[u][p]) {
+                        size_t r = (block_size + c - k) % block_size;
+                        syndrome[p][r / 64] ^= uint64_t{1} << (r % 64);
+                    }
+                }
+            }
+        }
+    }
+
+    const DecodingContext<GF4>& dc;
+    BinaryFlippingPolicy policy;
+    size_t block_size;
+    size_t num_words;
+    // offsets[3 * b + value - 1][p] are the k with the bit p of h_b[k] * value nonzero, i.e. the binary column
+    // of flipping a position of the block b by value has ones in the checks (c - k) mod n of the syndrome bit p
+    std::array<std::array<std::vector<size_t>, 2>, 6> offsets;
+    std::array<size_t, 6> column_weight{};
+};
+
+#endif //MDPC_GF4_BINARY_IMAGE_H
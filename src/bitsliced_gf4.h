@@ -0,0 +1,281 @@
+#ifndef MDPC_GF4_BITSLICED_GF4_H
+#define MDPC_GF4_BITSLICED_GF4_H
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include "gf4.h"
+#include "custom_exceptions.h"
+
+/**
+ * @brief A vector over GF(4) stored as two bit-planes.
+ *
+ * An element b0 + b1*alpha of GF(4) (see GF4) is split into its bits b0 and b1.
+ * The bits b0 of all elements are packed into 64-bit words of the low plane, the bits b1 into the high plane.
+ * Addition is then a XOR of both planes and multiplication by a scalar is a fixed mixing of the planes:
+ *  + 1 * (lo, hi) = (lo, hi)
+ *  + alpha * (lo, hi) = (hi, lo ^ hi)
+ *  + (alpha + 1) * (lo, hi) = (lo ^ hi, lo)
+ * This processes 64 elements at once.
+ */
+class BitslicedGF4Vector {
+public:
+    /**
+     * @brief Construct a zero vector of the given length.
+     *
+     * @param length The number of elements.
+     */
+    explicit BitslicedGF4Vector(size_t length = 0) : lo((length + 63) / 64), hi((length + 63) / 64), length(length) {}
+
+    /**
+     * @brief Pack a vector of GF4 elements.
+     *
+     * @param vec The vector to pack.
+     */
+    explicit BitslicedGF4Vector(const std::vector<GF4>& vec) : BitslicedGF4Vector(vec.size()) {
+        for (size_t i = 0; i < vec.size(); ++i) {
+            set(i, vec[i]);
+        }
+    }
+
+    /**
+     * @brief Unpack the vector.
+     *
+     * @return A vector of GF4 elements.
+     */
+    [[nodiscard]] auto to_vector() const -> std::vector<GF4> {
+        std::vector<GF4> out;
+        out.reserve(length);
+        for (size_t i = 0; i < length; ++i) {
+            out.push_back(get(i));
+        }
+        return out;
+    }
+
+    [[nodiscard]] auto size() const -> size_t {
+        return length;
+    }
+
+    /**
+     * @brief Get the words of the low bit-plane (bits b0 of the elements).
+     *
+     * Bits beyond size() are always zero.
+     *
+     * @return The words of the low bit-plane.
+     */
+    [[nodiscard]] auto get_low_words() const -> const std::vector<uint64_t>& {
+        return lo;
+    }
+
+    /**
+     * @brief Get the words of the high bit-plane (bits b1 of the elements).
+     *
+     * Bits beyond size() are always zero.
+     *
+     * @return The words of the high bit-plane.
+     */
+    [[nodiscard]] auto get_high_words() const -> const std::vector<uint64_t>& {
+        return hi;
+    }
+
+    [[nodiscard]] auto get(size_t i) const -> GF4 {
+        size_t b0 = (lo[i / 64] >> (i % 64)) & 1u;
+        size_t b1 = (hi[i / 64] >> (i % 64)) & 1u;
+        return GF4{b0 | (b1 << 1)};
+    }
+
+    auto set(size_t i, const GF4& value) -> void {
+        uint64_t mask = uint64_t{1} << (i % 64);
+        lo[i / 64] = (lo[i / 64] & ~mask) | ((value.get_value() & 1u) ? mask : 0);
+        hi[i / 64] = (hi[i / 64] & ~mask) | ((value.get_value() & 2u) ? mask : 0);
+    }
+
+    /**
+     * @brief Add a multiple of another vector to this vector, i.e. this += scalar * other.
+     *
+     * Words before first_word are skipped, which is useful in gaussian elimination
+     * where the leading part of the rows is known to be zero.
+     *
+     * @throws IncorrectInputVectorLength if the vectors differ in length.
+     * @param other The vector to add.
+     * @param scalar The multiple of the other vector.
+     * @param first_word The index of the first 64-element word to process.
+     */
+    auto add_multiple(const BitslicedGF4Vector& other, const GF4& scalar, size_t first_word = 0) -> void {
+        if (other.length != length) {
+            throw IncorrectInputVectorLength{};
+        }
+        switch (scalar.get_value()) {
+            case 0:
+                break;
+            case 1:
+                for (size_t k = first_word; k < lo.size(); ++k) {
+                    lo[k] ^= other.lo[k];
+                    hi[k] ^= other.hi[k];
+                }
+                break;
+            case 2:
+                for (size_t k = first_word; k < lo.size(); ++k) {
+                    lo[k] ^= other.hi[k];
+                    hi[k] ^= other.lo[k] ^ other.hi[k];
+                }
+                break;
+            default:  // value == 3
+                for (size_t k = first_word; k < lo.size(); ++k) {
+                    lo[k] ^= other.lo[k] ^ other.hi[k];
+                    hi[k] ^= other.lo[k];
+                }
+                break;
+        }
+    }
+
+    /**
+     * @brief Add a shifted multiple of the first count elements of another vector, i.e. this[i + shift] += scalar * other[i].
+     *
+     * The vectors may differ in length, elements shifted beyond size() must be zero.
+     * This is the elimination step of polynomial division when the vectors hold coefficients.
+     *
+     * @param other The vector to add.
+     * @param scalar The multiple of the other vector.
+     * @param shift The offset of the other vector in this vector.
+     * @param count The number of leading elements of other to add.
+     */
+    auto add_shifted_multiple(const BitslicedGF4Vector& other, const GF4& scalar, size_t shift, size_t count) -> void {
+        if (scalar.is_zero() || count == 0) {
+            return;
+        }
+        // scalar * (l, h) = (l & m0 ^ h & m1, l & m1 ^ h & m01) for the bits b0, b1 of the scalar
+        uint64_t m0 = (scalar.get_value() & 1u) ? ~uint64_t{0} : 0;
+        uint64_t m1 = (scalar.get_value() & 2u) ? ~uint64_t{0} : 0;
+        uint64_t m01 = m0 ^ m1;
+        size_t words = (count + 63) / 64;
+        size_t word_shift = shift / 64;
+        unsigned bit_shift = shift % 64;
+        uint64_t last_mask = (count % 64 != 0) ? (uint64_t{1} << (count % 64)) - 1 : ~uint64_t{0};
+        // words shifted beyond the end are zero by assumption, so they are not written
+        size_t end = std::min(words, lo.size() - word_shift);
+        uint64_t carry_lo = 0;
+        uint64_t carry_hi = 0;
+        for (size_t k = 0; k < end; ++k) {
+            uint64_t mask = (k + 1 == words) ? last_mask : ~uint64_t{0};
+            uint64_t l = other.lo[k] & mask;
+            uint64_t h = other.hi[k] & mask;
+            uint64_t add_lo = (l & m0) ^ (h & m1);
+            uint64_t add_hi = (l & m1) ^ (h & m01);
+            if (bit_shift == 0) {
+                lo[word_shift + k] ^= add_lo;
+                hi[word_shift + k] ^= add_hi;
+            } else {
+                lo[word_shift + k] ^= (add_lo << bit_shift) | carry_lo;
+                hi[word_shift + k] ^= (add_hi << bit_shift) | carry_hi;
+                carry_lo = add_lo >> (64 - bit_shift);
+                carry_hi = add_hi >> (64 - bit_shift);
+            }
+        }
+        if (bit_shift != 0 && word_shift + end < lo.size()) {
+            lo[word_shift + end] ^= carry_lo;
+            hi[word_shift + end] ^= carry_hi;
+        }
+    }
+
+    auto operator+=(const BitslicedGF4Vector& other) -> BitslicedGF4Vector& {
+        add_multiple(other, GF4{1});
+        return *this;
+    }
+
+    auto operator*=(const GF4& scalar) -> BitslicedGF4Vector& {
+        for (size_t k = 0; k < lo.size(); ++k) {
+            uint64_t l = lo[k];
+            uint64_t h = hi[k];
+            switch (scalar.get_value()) {
+                case 0:
+                    lo[k] = 0;
+                    hi[k] = 0;
+                    break;
+                case 1:
+                    break;
+                case 2:
+                    lo[k] = h;
+                    hi[k] = l ^ h;
+                    break;
+                default:  // value == 3
+                    lo[k] = l ^ h;
+                    hi[k] = l;
+                    break;
+            }
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Find the first nonzero element at or after the given index.
+     *
+     * @param from The index to start the search at.
+     * @return The index of the first nonzero element, or size() if there is none.
+     */
+    [[nodiscard]] auto first_nonzero(size_t from) const -> size_t {
+        for (size_t k = from / 64; k < lo.size(); ++k) {
+            uint64_t word = lo[k] | hi[k];
+            if (k == from / 64) {
+                word &= ~uint64_t{0} << (from % 64);
+            }
+            if (word != 0) {
+                size_t i = 64 * k + __builtin_ctzll(word);
+                return (i < length) ? i : length;
+            }
+        }
+        return length;
+    }
+
+    /**
+     * @brief Find the last nonzero element before the given index.
+     *
+     * @param before The index to end the search at (exclusive).
+     * @return The index of the last nonzero element, or size() if there is none.
+     */
+    [[nodiscard]] auto last_nonzero(size_t before) const -> size_t {
+        if (before == 0) {
+            return length;
+        }
+        size_t last = before - 1;
+        for (size_t k = last / 64 + 1; k > 0; --k) {
+            uint64_t word = lo[k - 1] | hi[k - 1];
+            if (k - 1 == last / 64 && last % 64 != 63) {
+                word &= (uint64_t{1} << (last % 64 + 1)) - 1;
+            }
+            if (word != 0) {
+                return 64 * (k - 1) + 63 - __builtin_clzll(word);
+            }
+        }
+        return length;
+    }
+
+    [[nodiscard]] auto is_zero() const -> bool {
+        for (size_t k = 0; k < lo.size(); ++k) {
+            if ((lo[k] | hi[k]) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Get the hamming weight of the vector, i.e. the number of nonzero elements.
+     *
+     * @return The number of nonzero elements.
+     */
+    [[nodiscard]] auto hamming_weight() const -> size_t {
+        size_t weight = 0;
+        for (size_t k = 0; k < lo.size(); ++k) {
+            weight += __builtin_popcountll(lo[k] | hi[k]);
+        }
+        return weight;
+    }
+
+private:
+    std::vector<uint64_t> lo;
+    std::vector<uint64_t> hi;
+    size_t length;
+};
+
+#endif //MDPC_GF4_BITSLICED_GF4_H
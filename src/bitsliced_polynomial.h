@@ -0,0 +1,355 @@
+#ifndef MDPC_GF4_BITSLICED_POLYNOMIAL_H
+#define MDPC_GF4_BITSLICED_POLYNOMIAL_H
+
+#include <algorithm>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <cstdint>
+#if defined(__PCLMUL__)
+#include <wmmintrin.h>
+#endif
+#include "gf4.h"
+#include "bitsliced_gf4.h"
+#include "polynomial.h"
+#include "custom_exceptions.h"
+
+/*
+ * Polynomials over GF(4) on bit-planes (see BitslicedGF4Vector): the coefficient of x^i is split into its bits,
+ * which are the bits i % 64 of the words i / 64 of the low and the high plane. Each plane is a polynomial over GF(2),
+ * so products reduce to carry-less multiplication of words.
+ *
+ * The word products use the PCLMULQDQ instruction if the code is compiled for it (e.g. -mpclmul or -march=native),
+ * otherwise the comb method, which is several times slower.
+ */
+
+/*
+ * Below this number of words, carryless_multiply_accumulate multiplies directly instead of by Karatsuba.
+ */
+#ifndef MDPC_GF4_CARRYLESS_KARATSUBA_THRESHOLD
+#define MDPC_GF4_CARRYLESS_KARATSUBA_THRESHOLD 32
+#endif
+
+/**
+ * @brief Calculate out[0 .. na + nb - 1] += a * b for polynomials over GF(2) without Karatsuba.
+ *
+ * The comb method adds the precomputed products u * b for the 4-bit polynomials u read from all words of a at once
+ * and shifts the accumulator by 4 bits between the nibbles, so there are no shifts in the inner loop.
+ */
+inline auto carryless_multiply_base(uint64_t* out, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) -> void {
+#if defined(__PCLMUL__)
+    for (size_t j = 0; j < nb; ++j) {
+        __m128i word = _mm_set_epi64x(0, (long long)b[j]);
+        for (size_t i = 0; i < na; ++i) {
+            alignas(16) uint64_t product[2];
+            _mm_store_si128((__m128i*)product, _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long)a[i]), word, 0));
+            out[i + j] ^= product[0];
+            out[i + j + 1] ^= product[1];
+        }
+    }
+#else
+    size_t row = nb + 1;
+    std::vector<uint64_t> table(16 * row);
+    std::copy(b, b + nb, table.begin() + row);
+    for (size_t u = 2; u < 16; u += 2) {
+        const uint64_t* half = &table[(u / 2) * row];
+        uint64_t* even = &table[u * row];
+        uint64_t* odd = &table[(u + 1) * row];
+        uint64_t carry = 0;
+        for (size_t k = 0; k < row; ++k) {
+            even[k] = (half[k] << 1) | carry;
+            carry = half[k] >> 63;
+            odd[k] = even[k] ^ table[row + k];
+        }
+    }
+    std::vector<uint64_t> acc(na + nb + 1);
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        for (size_t i = 0; i < na; ++i) {
+            const uint64_t* __restrict entry = &table[((a[i] >> shift) & 15u) * row];
+            uint64_t* __restrict target = &acc[i];
+            for (size_t k = 0; k < row; ++k) {
+                target[k] ^= entry[k];
+            }
+        }
+        if (shift != 0) {
+            uint64_t carry = 0;
+            for (size_t k = 0; k < acc.size(); ++k) {
+                uint64_t word = acc[k];
+                acc[k] = (word << 4) | carry;
+                carry = word >> 60;
+            }
+        }
+    }
+    for (size_t k = 0; k < na + nb; ++k) {
+        out[k] ^= acc[k];
+    }
+#endif
+}
+
+/**
+ * @brief Calculate out[0 .. na + nb - 1] += a * b for polynomials over GF(2) packed in words.
+ *
+ * Karatsuba multiplication as in multiply_accumulate, on words instead of coefficients.
+ *
+ * @param out Output buffer of at least na + nb words.
+ * @param a The first operand.
+ * @param na The number of words of a, positive.
+ * @param b The second operand.
+ * @param nb The number of words of b, positive.
+ */
+inline auto carryless_multiply_accumulate(uint64_t* out, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) -> void {
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (nb < MDPC_GF4_CARRYLESS_KARATSUBA_THRESHOLD) {
+        carryless_multiply_base(out, a, na, b, nb);
+        return;
+    }
+    size_t h = (na + 1) / 2;
+    if (nb <= h) {
+        carryless_multiply_accumulate(out, a, h, b, nb);
+        carryless_multiply_accumulate(out + h, a + h, na - h, b, nb);
+        return;
+    }
+    std::vector<uint64_t> low(2 * h);
+    std::vector<uint64_t> high(na + nb - 2 * h);
+    std::vector<uint64_t> middle(2 * h);
+    carryless_multiply_accumulate(low.data(), a, h, b, h);
+    carryless_multiply_accumulate(high.data(), a + h, na - h, b + h, nb - h);
+    std::vector<uint64_t> sum_a(a, a + h);
+    std::vector<uint64_t> sum_b(b, b + h);
+    for (size_t i = h; i < na; ++i) {
+        sum_a[i - h] ^= a[i];
+    }
+    for (size_t i = h; i < nb; ++i) {
+        sum_b[i - h] ^= b[i];
+    }
+    carryless_multiply_accumulate(middle.data(), sum_a.data(), h, sum_b.data(), h);
+    for (size_t i = 0; i < low.size(); ++i) {
+        middle[i] ^= low[i];
+        out[i] ^= low[i];
+    }
+    for (size_t i = 0; i < high.size(); ++i) {
+        middle[i] ^= high[i];
+        out[2 * h + i] ^= high[i];
+    }
+    for (size_t i = 0; i < middle.size(); ++i) {
+        out[h + i] ^= middle[i];
+    }
+}
+
+/**
+ * @brief Divide and calculate the remainder over GF(4), on bit-sliced coefficients.
+ *
+ * Same as PolynomialGF2N::div_rem, but every elimination step is one BitslicedGF4Vector::add_shifted_multiple,
+ * so the division takes (deg(a) - deg(b)) * deg(b) / 64 word operations per plane.
+ *
+ * @throws DivisionByZero if b is zero.
+ * @param a The dividend.
+ * @param b The divisor.
+ * @return A tuple containing the quotient and the remainder.
+ */
+inline auto bitsliced_div_rem(const PolynomialGF2N<GF4>& a, const PolynomialGF2N<GF4>& b)
+        -> std::tuple<PolynomialGF2N<GF4>, PolynomialGF2N<GF4>> {
+    if (b.is_zero()) {
+        throw DivisionByZero{};
+    }
+    size_t m = b.get_degree();
+    if (a.get_degree() < m) {
+        return std::make_tuple(PolynomialGF2N<GF4>{}, a);
+    }
+    BitslicedGF4Vector r{a.to_vector()};
+    BitslicedGF4Vector divisor{b.to_vector()};
+    std::vector<GF4> quotient(a.get_degree() - m + 1);
+    GF4 lead_inverse = GF4{1} / b.get_coefficient(m);
+    for (size_t deg = r.last_nonzero(r.size()); deg < r.size() && deg >= m; deg = r.last_nonzero(deg)) {
+        GF4 c = r.get(deg) * lead_inverse;
+        quotient[deg - m] = c;
+        r.add_shifted_multiple(divisor, c, deg - m, m + 1);
+    }
+    std::vector<GF4> remainder = r.to_vector();
+    remainder.resize(m);
+    return std::make_tuple(PolynomialGF2N<GF4>{quotient}, PolynomialGF2N<GF4>{remainder});
+}
+
+/**
+ * @brief Arithmetic over GF(4) modulo a fixed monic polynomial f, on bit-planes.
+ *
+ * Residues are polynomials of degree below m = deg(f) with (m + 63) / 64 words per plane.
+ * Over GF(4) = GF(2)[alpha] with alpha^2 = alpha + 1, a product of a = a0 + alpha a1 and b = b0 + alpha b1 is
+ *  a b = (a0 b0 + a1 b1) + alpha ((a0 + a1)(b0 + b1) + a0 b0),
+ * i.e. three carry-less products of the planes. Products are reduced by Barrett reduction: with mu = x^(2m) div f,
+ * the quotient of p by f is ((p div x^m) mu) div x^m for deg(p) < 2m, so the reduction takes two more products
+ * and no division.
+ */
+class BitslicedGF4Modulus {
+public:
+    /**
+     * @brief A polynomial over GF(4) of degree below m as its low and high bit-plane.
+     */
+    struct Residue {
+        std::vector<uint64_t> lo;
+        std::vector<uint64_t> hi;
+    };
+
+    /**
+     * @brief Precompute the Barrett constant of f.
+     *
+     * @throws IncorrectPolynomialDegree if f is not of positive degree.
+     * @param f A monic polynomial of positive degree.
+     */
+    explicit BitslicedGF4Modulus(const PolynomialGF2N<GF4>& f) : degree(f.get_degree()), words((f.get_degree() + 63) / 64) {
+        if (degree == 0) {
+            throw IncorrectPolynomialDegree{};
+        }
+        modulus = pack_words(f, degree + 1);
+        PolynomialGF2N<GF4> power;
+        power.set_coefficient(2 * degree, GF4{1});
+        mu = pack_words(std::get<0>(bitsliced_div_rem(power, f)), degree + 1);
+    }
+
+    /**
+     * @brief Pack a polynomial of degree below m.
+     */
+    [[nodiscard]] auto pack(const PolynomialGF2N<GF4>& p) const -> Residue {
+        return pack_words(p, degree);
+    }
+
+    /**
+     * @brief Unpack a residue into a polynomial.
+     */
+    [[nodiscard]] auto unpack(const Residue& a) const -> PolynomialGF2N<GF4> {
+        std::vector<GF4> coefficients(degree);
+        for (size_t i = 0; i < degree; ++i) {
+            size_t b0 = (a.lo[i / 64] >> (i % 64)) & 1u;
+            size_t b1 = (a.hi[i / 64] >> (i % 64)) & 1u;
+            coefficients[i] = GF4{b0 | (b1 << 1)};
+        }
+        return PolynomialGF2N<GF4>{coefficients};
+    }
+
+    /**
+     * @brief Calculate a * b mod f.
+     */
+    [[nodiscard]] auto multiply(const Residue& a, const Residue& b) const -> Residue {
+        return reduce(product(a, b));
+    }
+
+    /**
+     * @brief Calculate a^2 mod f.
+     *
+     * Squaring maps c_i x^i to c_i^2 x^(2i) in characteristic 2, so it only spreads the bits of both planes
+     * and maps c -> c^2, which is (lo, hi) -> (lo ^ hi, hi).
+     */
+    [[nodiscard]] auto square(const Residue& a) const -> Residue {
+        auto spread = [](uint32_t x) -> uint64_t {
+            uint64_t v = x;
+            v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+            v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+            v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | (v << 2)) & 0x3333333333333333ull;
+            v = (v | (v << 1)) & 0x5555555555555555ull;
+            return v;
+        };
+        Residue out{std::vector<uint64_t>(2 * words), std::vector<uint64_t>(2 * words)};
+        for (size_t k = 0; k < words; ++k) {
+            uint64_t l = a.lo[k] ^ a.hi[k];
+            uint64_t u = a.hi[k];
+            out.lo[2 * k] = spread((uint32_t)l);
+            out.lo[2 * k + 1] = spread((uint32_t)(l >> 32));
+            out.hi[2 * k] = spread((uint32_t)u);
+            out.hi[2 * k + 1] = spread((uint32_t)(u >> 32));
+        }
+        return reduce(std::move(out));
+    }
+
+    [[nodiscard]] auto get_degree() const -> size_t {
+        return degree;
+    }
+
+private:
+    size_t degree;
+    size_t words;
+    Residue modulus;
+    Residue mu;
+
+    /**
+     * @brief Pack the coefficients of x^0 .. x^(count - 1) of p.
+     */
+    static auto pack_words(const PolynomialGF2N<GF4>& p, size_t count) -> Residue {
+        Residue out{std::vector<uint64_t>((count + 63) / 64), std::vector<uint64_t>((count + 63) / 64)};
+        for (size_t i = 0; i < std::min(count, p.get_degree() + 1); ++i) {
+            uint8_t c = p.get_coefficient(i).get_value();
+            out.lo[i / 64] |= (uint64_t)(c & 1u) << (i % 64);
+            out.hi[i / 64] |= (uint64_t)((c >> 1) & 1u) << (i % 64);
+        }
+        return out;
+    }
+
+    /**
+     * @brief Multiply two polynomials on bit-planes, the product has the sum of their word counts.
+     */
+    static auto product(const Residue& a, const Residue& b) -> Residue {
+        size_t na = a.lo.size();
+        size_t nb = b.lo.size();
+        std::vector<uint64_t> low(na + nb);
+        std::vector<uint64_t> high(na + nb);
+        std::vector<uint64_t> middle(na + nb);
+        carryless_multiply_accumulate(low.data(), a.lo.data(), na, b.lo.data(), nb);
+        carryless_multiply_accumulate(high.data(), a.hi.data(), na, b.hi.data(), nb);
+        std::vector<uint64_t> sum_a(na);
+        std::vector<uint64_t> sum_b(nb);
+        for (size_t k = 0; k < na; ++k) {
+            sum_a[k] = a.lo[k] ^ a.hi[k];
+        }
+        for (size_t k = 0; k < nb; ++k) {
+            sum_b[k] = b.lo[k] ^ b.hi[k];
+        }
+        carryless_multiply_accumulate(middle.data(), sum_a.data(), na, sum_b.data(), nb);
+        for (size_t k = 0; k < na + nb; ++k) {
+            middle[k] ^= low[k];
+            low[k] ^= high[k];
+        }
+        return Residue{std::move(low), std::move(middle)};
+    }
+
+    /**
+     * @brief Get the words of p div x^shift, truncated to count words.
+     */
+    static auto shift_down(const std::vector<uint64_t>& p, size_t shift, size_t count) -> std::vector<uint64_t> {
+        std::vector<uint64_t> out(count);
+        size_t word_shift = shift / 64;
+        unsigned bit_shift = shift % 64;
+        for (size_t k = 0; k < count && word_shift + k < p.size(); ++k) {
+            out[k] = p[word_shift + k] >> bit_shift;
+            if (bit_shift != 0 && word_shift + k + 1 < p.size()) {
+                out[k] |= p[word_shift + k + 1] << (64 - bit_shift);
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @brief Reduce a polynomial of degree below 2m - 1 modulo f.
+     */
+    [[nodiscard]] auto reduce(Residue p) const -> Residue {
+        Residue top{shift_down(p.lo, degree, words), shift_down(p.hi, degree, words)};
+        Residue t = product(top, mu);
+        Residue quotient{shift_down(t.lo, degree, words), shift_down(t.hi, degree, words)};
+        Residue qf = product(quotient, modulus);
+        Residue out{std::vector<uint64_t>(words), std::vector<uint64_t>(words)};
+        for (size_t k = 0; k < words; ++k) {
+            out.lo[k] = p.lo[k] ^ qf.lo[k];
+            out.hi[k] = p.hi[k] ^ qf.hi[k];
+        }
+        if (degree % 64 != 0) {
+            uint64_t mask = (uint64_t{1} << (degree % 64)) - 1;
+            out.lo[words - 1] &= mask;
+            out.hi[words - 1] &= mask;
+        }
+        return out;
+    }
+};
+
+#endif //MDPC_GF4_BITSLICED_POLYNOMIAL_H
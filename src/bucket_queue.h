@@ -0,0 +1,123 @@
+#ifndef MDPC_GF4_BUCKET_QUEUE_H
+#define MDPC_GF4_BUCKET_QUEUE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A max-priority queue of items with small integer keys.
+ *
+ * The items 0, ..., num_items - 1 are kept in one doubly linked list per key (bucket), so changing the key of an item
+ * moves it between two lists in O(1). The highest nonempty bucket is tracked: it only rises when a key rises, and it falls
+ * lazily in top, so the cost of finding the maximum is paid for by the key changes which raised it.
+ * The links and the key of an item are stored together in 12 bytes, as the items are visited in no particular order.
+ */
+class BucketQueue {
+public:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    BucketQueue() : min_key(0), highest(0) {}
+
+    /**
+     * @brief Construct a queue which holds every item with the key min_key.
+     *
+     * @param num_items The number of items, less than 2^32 - 1.
+     * @param min_key The smallest key of any item.
+     * @param max_key The largest key of any item.
+     */
+    BucketQueue(size_t num_items, long min_key, long max_key)
+            : heads((size_t)(max_key - min_key + 1), NIL), nodes(num_items), min_key(min_key), highest(0) {
+        for (size_t item = num_items; item > 0; --item) {
+            nodes[item - 1].key = (int32_t)min_key;
+            link((uint32_t)(item - 1));
+        }
+    }
+
+    [[nodiscard]] auto key(size_t item) const -> long {
+        return nodes[item].key;
+    }
+
+    /**
+     * @brief Change the key of an item.
+     *
+     * @param item The item.
+     * @param key The key, between min_key and max_key.
+     */
+    auto set(size_t item, long key) -> void {
+        unlink((uint32_t)item);
+        nodes[item].key = (int32_t)key;
+        link((uint32_t)item);
+    }
+
+    /**
+     * @brief Add to the key of an item.
+     *
+     * @param item The item.
+     * @param delta The change of the key, the new key must be between min_key and max_key.
+     */
+    auto add(size_t item, long delta) -> void {
+        set(item, nodes[item].key + delta);
+    }
+
+    [[nodiscard]] auto empty() -> bool {
+        return top() == NONE;
+    }
+
+    /**
+     * @brief Get an item with the largest key. Among equal keys, the item whose key changed last is returned.
+     *
+     * @return The item, or NONE if the queue is empty.
+     */
+    auto top() -> size_t {
+        if (nodes.empty()) {
+            return NONE;
+        }
+        while (highest > 0 && heads[highest] == NIL) {
+            --highest;
+        }
+        return heads[highest];
+    }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        uint32_t previous = NIL;
+        uint32_t next = NIL;
+        int32_t key = 0;
+    };
+
+    auto link(uint32_t item) -> void {
+        Node& node = nodes[item];
+        size_t bucket = (size_t)(node.key - min_key);
+        node.previous = NIL;
+        node.next = heads[bucket];
+        if (node.next != NIL) {
+            nodes[node.next].previous = item;
+        }
+        heads[bucket] = item;
+        if (bucket > highest) {
+            highest = bucket;
+        }
+    }
+
+    auto unlink(uint32_t item) -> void {
+        const Node& node = nodes[item];
+        if (node.previous != NIL) {
+            nodes[node.previous].next = node.next;
+        } else {
+            heads[(size_t)(node.key - min_key)] = node.next;
+        }
+        if (node.next != NIL) {
+            nodes[node.next].previous = node.previous;
+        }
+    }
+
+    std::vector<uint32_t> heads;
+    std::vector<Node> nodes;
+    long min_key;
+    size_t highest;
+};
+
+#endif //MDPC_GF4_BUCKET_QUEUE_H
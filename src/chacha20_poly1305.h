@@ -0,0 +1,444 @@
+#ifndef MDPC_GF4_CHACHA20_POLY1305_H
+#define MDPC_GF4_CHACHA20_POLY1305_H
+
+#include <array>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include "simd.h"
+
+/*
+ * ChaCha20-Poly1305 authenticated encryption (RFC 8439), used to seal payloads in the hybrid mode (see hybrid.h).
+ *
+ * The ChaCha20 keystream is computed for several blocks at once: every state word is a vector with one lane per block,
+ * so the width follows SimdBytes (4 blocks with 16 byte vectors, 8 with AVX2, 16 with AVX-512).
+ * Without the vector extensions (MDPC_GF4_SIMD_EMULATE), a single block is computed at a time.
+ */
+#if MDPC_GF4_SIMD_NATIVE
+typedef uint32_t ChaChaLanes __attribute__((vector_size(MDPC_GF4_SIMD_WIDTH)));
+static constexpr size_t CHACHA_LANES = MDPC_GF4_SIMD_WIDTH / 4;
+#else
+typedef uint32_t ChaChaLanes;
+static constexpr size_t CHACHA_LANES = 1;
+#endif
+
+inline auto load_le32(const uint8_t* src) -> uint32_t {
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+inline auto load_le64(const uint8_t* src) -> uint64_t {
+    return (uint64_t)load_le32(src) | ((uint64_t)load_le32(src + 4) << 32);
+}
+
+inline auto store_le32(uint8_t* dst, uint32_t value) -> void {
+    for (size_t i = 0; i < 4; ++i) {
+        dst[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+inline auto store_le64(uint8_t* dst, uint64_t value) -> void {
+    store_le32(dst, (uint32_t)value);
+    store_le32(dst + 4, (uint32_t)(value >> 32));
+}
+
+/**
+ * @brief The ChaCha20 stream cipher with a 256 bit key, 96 bit nonce and 32 bit block counter.
+ */
+class ChaCha20 {
+public:
+    /**
+     * @brief Number of keystream bytes computed at once.
+     */
+    static constexpr size_t batch_bytes = 64 * CHACHA_LANES;
+
+    ChaCha20(const std::array<uint8_t, 32>& key, const std::array<uint8_t, 12>& nonce, uint32_t counter) : input{} {
+        input[0] = 0x61707865;
+        input[1] = 0x3320646e;
+        input[2] = 0x79622d32;
+        input[3] = 0x6b206574;
+        for (size_t i = 0; i < 8; ++i) {
+            input[4 + i] = load_le32(key.data() + 4 * i);
+        }
+        input[12] = counter;
+        for (size_t i = 0; i < 3; ++i) {
+            input[13 + i] = load_le32(nonce.data() + 4 * i);
+        }
+    }
+
+    /**
+     * @brief Compute the next CHACHA_LANES keystream blocks and advance the counter.
+     *
+     * @param out Output buffer of batch_bytes bytes.
+     */
+    auto next_batch(uint8_t* out) -> void {
+        ChaChaLanes x[16];
+        ChaChaLanes initial[16];
+        for (size_t i = 0; i < 16; ++i) {
+            x[i] = broadcast(input[i]);
+        }
+        uint32_t counters[CHACHA_LANES];
+        for (size_t lane = 0; lane < CHACHA_LANES; ++lane) {
+            counters[lane] = input[12] + (uint32_t)lane;
+        }
+        std::memcpy(&x[12], counters, sizeof(counters));
+        for (size_t i = 0; i < 16; ++i) {
+            initial[i] = x[i];
+        }
+        for (size_t round = 0; round < 10; ++round) {
+            quarter_round(x[0], x[4], x[8], x[12]);
+            quarter_round(x[1], x[5], x[9], x[13]);
+            quarter_round(x[2], x[6], x[10], x[14]);
+            quarter_round(x[3], x[7], x[11], x[15]);
+            quarter_round(x[0], x[5], x[10], x[15]);
+            quarter_round(x[1], x[6], x[11], x[12]);
+            quarter_round(x[2], x[7], x[8], x[13]);
+            quarter_round(x[3], x[4], x[9], x[14]);
+        }
+        for (size_t i = 0; i < 16; ++i) {
+            x[i] += initial[i];
+            uint32_t words[CHACHA_LANES];
+            std::memcpy(words, &x[i], sizeof(words));
+            for (size_t lane = 0; lane < CHACHA_LANES; ++lane) {
+                store_le32(out + 64 * lane + 4 * i, words[lane]);
+            }
+        }
+        input[12] += CHACHA_LANES;
+    }
+
+private:
+    static auto broadcast(uint32_t value) -> ChaChaLanes {
+        ChaChaLanes out;
+        uint32_t words[CHACHA_LANES];
+        for (size_t lane = 0; lane < CHACHA_LANES; ++lane) {
+            words[lane] = value;
+        }
+        std::memcpy(&out, words, sizeof(words));
+        return out;
+    }
+
+    static auto rotate_left(ChaChaLanes x, unsigned n) -> ChaChaLanes {
+        return (x << n) | (x >> (32 - n));
+    }
+
+    static auto quarter_round(ChaChaLanes& a, ChaChaLanes& b, ChaChaLanes& c, ChaChaLanes& d) -> void {
+        a += b;
+        d ^= a;
+        d = rotate_left(d, 16);
+        c += d;
+        b ^= c;
+        b = rotate_left(b, 12);
+        a += b;
+        d ^= a;
+        d = rotate_left(d, 8);
+        c += d;
+        b ^= c;
+        b = rotate_left(b, 7);
+    }
+
+    std::array<uint32_t, 16> input;
+};
+
+/**
+ * @brief The Poly1305 one-time authenticator, with 44 bit limbs and 128 bit products.
+ */
+class Poly1305 {
+public:
+    explicit Poly1305(const uint8_t* key) : h{}, buffer{}, buffered(0) {
+        uint64_t t0 = load_le64(key);
+        uint64_t t1 = load_le64(key + 8);
+        r[0] = t0 & 0xffc0fffffffull;
+        r[1] = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffffull;
+        r[2] = (t1 >> 24) & 0x00ffffffc0full;
+        pad[0] = load_le64(key + 16);
+        pad[1] = load_le64(key + 24);
+    }
+
+    auto update(const uint8_t* data, size_t length) -> void {
+        if (buffered != 0) {
+            size_t take = std::min(length, 16 - buffered);
+            std::memcpy(buffer.data() + buffered, data, take);
+            buffered += take;
+            data += take;
+            length -= take;
+            if (buffered < 16) {
+                return;
+            }
+            block(buffer.data(), uint64_t{1} << 40);
+            buffered = 0;
+        }
+        while (length >= 16) {
+            block(data, uint64_t{1} << 40);
+            data += 16;
+            length -= 16;
+        }
+        std::memcpy(buffer.data(), data, length);
+        buffered = length;
+    }
+
+    /**
+     * @brief Pad the buffered data with zeros to a multiple of 16 bytes, as required by the AEAD construction.
+     */
+    auto pad_to_block() -> void {
+        if (buffered != 0) {
+            std::memset(buffer.data() + buffered, 0, 16 - buffered);
+            block(buffer.data(), uint64_t{1} << 40);
+            buffered = 0;
+        }
+    }
+
+    auto finalize() -> std::array<uint8_t, 16> {
+        const uint64_t mask44 = 0xfffffffffffull;
+        const uint64_t mask42 = 0x3ffffffffffull;
+        if (buffered != 0) {
+            buffer[buffered] = 1;
+            std::memset(buffer.data() + buffered + 1, 0, 15 - buffered);
+            block(buffer.data(), 0);
+            buffered = 0;
+        }
+        uint64_t h0 = h[0], h1 = h[1], h2 = h[2];
+        uint64_t c = h1 >> 44; h1 &= mask44;
+        h2 += c; c = h2 >> 42; h2 &= mask42;
+        h0 += c * 5; c = h0 >> 44; h0 &= mask44;
+        h1 += c; c = h1 >> 44; h1 &= mask44;
+        h2 += c; c = h2 >> 42; h2 &= mask42;
+        h0 += c * 5; c = h0 >> 44; h0 &= mask44;
+        h1 += c;
+
+        // compute h - p and select it if it does not underflow
+        uint64_t g0 = h0 + 5; c = g0 >> 44; g0 &= mask44;
+        uint64_t g1 = h1 + c; c = g1 >> 44; g1 &= mask44;
+        uint64_t g2 = h2 + c - (uint64_t{1} << 42);
+        c = (g2 >> 63) - 1;
+        g0 &= c;
+        g1 &= c;
+        g2 &= c;
+        c = ~c;
+        h0 = (h0 & c) | g0;
+        h1 = (h1 & c) | g1;
+        h2 = (h2 & c) | g2;
+
+        h0 += pad[0] & mask44; c = h0 >> 44; h0 &= mask44;
+        h1 += (((pad[0] >> 44) | (pad[1] << 20)) & mask44) + c; c = h1 >> 44; h1 &= mask44;
+        h2 += ((pad[1] >> 24) & mask42) + c; h2 &= mask42;
+
+        std::array<uint8_t, 16> tag{};
+        store_le64(tag.data(), h0 | (h1 << 44));
+        store_le64(tag.data() + 8, (h1 >> 20) | (h2 << 24));
+        return tag;
+    }
+
+private:
+    auto block(const uint8_t* data, uint64_t high_bit) -> void {
+        __extension__ typedef unsigned __int128 uint128_t;
+        const uint64_t mask44 = 0xfffffffffffull;
+        const uint64_t mask42 = 0x3ffffffffffull;
+        uint64_t s1 = r[1] * (5 << 2);
+        uint64_t s2 = r[2] * (5 << 2);
+        uint64_t t0 = load_le64(data);
+        uint64_t t1 = load_le64(data + 8);
+        h[0] += t0 & mask44;
+        h[1] += ((t0 >> 44) | (t1 << 20)) & mask44;
+        h[2] += ((t1 >> 24) & mask42) | high_bit;
+        uint128_t d0 = (uint128_t)h[0] * r[0] + (uint128_t)h[1] * s2 + (uint128_t)h[2] * s1;
+        uint128_t d1 = (uint128_t)h[0] * r[1] + (uint128_t)h[1] * r[0] + (uint128_t)h[2] * s2;
+        uint128_t d2 = (uint128_t)h[0] * r[2] + (uint128_t)h[1] * r[1] + (uint128_t)h[2] * r[0];
+        uint64_t c = (uint64_t)(d0 >> 44); h[0] = (uint64_t)d0 & mask44;
+        d1 += c; c = (uint64_t)(d1 >> 44); h[1] = (uint64_t)d1 & mask44;
+        d2 += c; c = (uint64_t)(d2 >> 42); h[2] = (uint64_t)d2 & mask42;
+        h[0] += c * 5; c = h[0] >> 44; h[0] &= mask44;
+        h[1] += c;
+    }
+
+    std::array<uint64_t, 3> r;
+    std::array<uint64_t, 3> h;
+    std::array<uint64_t, 2> pad;
+    std::array<uint8_t, 16> buffer;
+    size_t buffered;
+};
+
+/**
+ * @brief Common part of ChaCha20Poly1305Sealer and ChaCha20Poly1305Opener.
+ *
+ * The payload is processed in any number of parts; the keystream is computed in batches (see ChaCha20::batch_bytes)
+ * and XORed with the payload word by word. A single key and nonce can encrypt up to 256 GB.
+ */
+class ChaCha20Poly1305Stream {
+public:
+    ChaCha20Poly1305Stream(const std::array<uint8_t, 32>& key, const std::array<uint8_t, 12>& nonce,
+                           const uint8_t* aad, size_t aad_length)
+            : mac(one_time_key(key, nonce).data()), cipher(key, nonce, 1), keystream{},
+              keystream_position(ChaCha20::batch_bytes), aad_length(aad_length), payload_length(0) {
+        mac.update(aad, aad_length);
+        mac.pad_to_block();
+    }
+
+protected:
+    auto crypt(const uint8_t* in, uint8_t* out, size_t length) -> void {
+        payload_length += length;
+        while (length > 0) {
+            if (keystream_position == ChaCha20::batch_bytes) {
+                cipher.next_batch(keystream.data());
+                keystream_position = 0;
+            }
+            size_t take = std::min(length, ChaCha20::batch_bytes - keystream_position);
+            size_t i = 0;
+            for (; i + 8 <= take; i += 8) {
+                uint64_t a, b;
+                std::memcpy(&a, in + i, 8);
+                std::memcpy(&b, keystream.data() + keystream_position + i, 8);
+                a ^= b;
+                std::memcpy(out + i, &a, 8);
+            }
+            for (; i < take; ++i) {
+                out[i] = in[i] ^ keystream[keystream_position + i];
+            }
+            keystream_position += take;
+            in += take;
+            out += take;
+            length -= take;
+        }
+    }
+
+    auto compute_tag() -> std::array<uint8_t, 16> {
+        mac.pad_to_block();
+        uint8_t lengths[16];
+        store_le64(lengths, aad_length);
+        store_le64(lengths + 8, payload_length);
+        mac.update(lengths, 16);
+        return mac.finalize();
+    }
+
+    Poly1305 mac;
+
+private:
+    static auto one_time_key(const std::array<uint8_t, 32>& key, const std::array<uint8_t, 12>& nonce)
+            -> std::array<uint8_t, ChaCha20::batch_bytes> {
+        // the first 32 bytes of block 0 are the Poly1305 key, the payload is encrypted from block 1
+        std::array<uint8_t, ChaCha20::batch_bytes> block{};
+        ChaCha20{key, nonce, 0}.next_batch(block.data());
+        return block;
+    }
+
+    ChaCha20 cipher;
+    std::array<uint8_t, ChaCha20::batch_bytes> keystream;
+    size_t keystream_position;
+    uint64_t aad_length;
+    uint64_t payload_length;
+};
+
+/**
+ * @brief Streaming ChaCha20-Poly1305 encryption.
+ *
+ * Call update for every part of the plaintext and finalize once at the end to get the tag.
+ * A key and nonce pair must never be used for two different messages.
+ */
+class ChaCha20Poly1305Sealer : public ChaCha20Poly1305Stream {
+public:
+    ChaCha20Poly1305Sealer(const std::array<uint8_t, 32>& key, const std::array<uint8_t, 12>& nonce,
+                           const uint8_t* aad = nullptr, size_t aad_length = 0)
+            : ChaCha20Poly1305Stream(key, nonce, aad, aad_length) {}
+
+    /**
+     * @brief Encrypt the next part of the plaintext.
+     *
+     * @param plaintext The plaintext.
+     * @param ciphertext Output buffer of length bytes, may be the same as plaintext.
+     * @param length The number of bytes.
+     */
+    auto update(const uint8_t* plaintext, uint8_t* ciphertext, size_t length) -> void {
+        crypt(plaintext, ciphertext, length);
+        mac.update(ciphertext, length);
+    }
+
+    /**
+     * @brief Get the authentication tag. The object must not be used afterwards.
+     *
+     * @return The 16 byte tag.
+     */
+    auto finalize() -> std::array<uint8_t, 16> {
+        return compute_tag();
+    }
+};
+
+/**
+ * @brief Streaming ChaCha20-Poly1305 decryption.
+ *
+ * Call update for every part of the ciphertext and finalize once at the end to verify the tag.
+ * The plaintext returned by update must not be used until finalize succeeds.
+ */
+class ChaCha20Poly1305Opener : public ChaCha20Poly1305Stream {
+public:
+    ChaCha20Poly1305Opener(const std::array<uint8_t, 32>& key, const std::array<uint8_t, 12>& nonce,
+                           const uint8_t* aad = nullptr, size_t aad_length = 0)
+            : ChaCha20Poly1305Stream(key, nonce, aad, aad_length) {}
+
+    /**
+     * @brief Decrypt the next part of the ciphertext.
+     *
+     * @param ciphertext The ciphertext.
+     * @param plaintext Output buffer of length bytes, may be the same as ciphertext.
+     * @param length The number of bytes.
+     */
+    auto update(const uint8_t* ciphertext, uint8_t* plaintext, size_t length) -> void {
+        mac.update(ciphertext, length);
+        crypt(ciphertext, plaintext, length);
+    }
+
+    /**
+     * @brief Verify the authentication tag in constant time. The object must not be used afterwards.
+     *
+     * @param tag The 16 byte tag received with the ciphertext.
+     * @return true if the ciphertext is authentic, false otherwise.
+     */
+    auto finalize(const std::array<uint8_t, 16>& tag) -> bool {
+        std::array<uint8_t, 16> expected = compute_tag();
+        uint8_t difference = 0;
+        for (size_t i = 0; i < 16; ++i) {
+            difference |= expected[i] ^ tag[i];
+        }
+        return difference == 0;
+    }
+};
+
+/**
+ * @brief Encrypt a message in one call.
+ *
+ * @return The ciphertext followed by the 16 byte tag.
+ */
+inline auto chacha20_poly1305_seal(const std::array<uint8_t, 32>& key, const std::array<uint8_t, 12>& nonce,
+                                   const std::vector<uint8_t>& plaintext, const std::vector<uint8_t>& aad = {}) -> std::vector<uint8_t> {
+    ChaCha20Poly1305Sealer sealer{key, nonce, aad.data(), aad.size()};
+    std::vector<uint8_t> out(plaintext.size() + 16);
+    sealer.update(plaintext.data(), out.data(), plaintext.size());
+    auto tag = sealer.finalize();
+    std::copy(tag.begin(), tag.end(), out.begin() + plaintext.size());
+    return out;
+}
+
+/**
+ * @brief Decrypt a message in one call.
+ *
+ * @param sealed The ciphertext followed by the 16 byte tag.
+ * @return The plaintext if the ciphertext is authentic, nothing otherwise.
+ */
+inline auto chacha20_poly1305_open(const std::array<uint8_t, 32>& key, const std::array<uint8_t, 12>& nonce,
+                                   const std::vector<uint8_t>& sealed, const std::vector<uint8_t>& aad = {}) -> std::optional<std::vector<uint8_t>> {
+    if (sealed.size() < 16) {
+        return {};
+    }
+    size_t length = sealed.size() - 16;
+    ChaCha20Poly1305Opener opener{key, nonce, aad.data(), aad.size()};
+    std::vector<uint8_t> out(length);
+    opener.update(sealed.data(), out.data(), length);
+    std::array<uint8_t, 16> tag{};
+    std::copy(sealed.begin() + length, sealed.end(), tag.begin());
+    if (!opener.finalize(tag)) {
+        return {};
+    }
+    return out;
+}
+
+#endif //MDPC_GF4_CHACHA20_POLY1305_H
@@ -4,9 +4,17 @@
 #include <vector>
 #include <optional>
 #include <tuple>
+#include <algorithm>
+#include <array>
+#include <type_traits>
 #include "polynomial.h"
 #include "custom_exceptions.h"
 #include "vector_utils.h"
+#include "stagnation.h"
+#include "linear_algebra.h"
+#include "scoring.h"
+#include "key_kernel.h"
+#include "field_traits.h"
 
 /**
  * @brief Class that hold the public key G and provides encoding functionality.
@@ -28,14 +36,18 @@ public:
      *
      * The message must be of length block_size.
      * The encoded message is calculated as mG.
+     * For fields with a packed layout (see FieldTraits), the product is computed on the packed symbols.
      *
      * @param message A vector of length block_size.
      * @return Encoded message stored in a vector of length 2*block_size.
      */
-    auto encode(const std::vector<T>& message) -> std::vector<T> {
+    auto encode(const std::vector<T>& message) const -> std::vector<T> {
         if (message.size() != block_size) {
             throw IncorrectInputVectorLength{};
         }
+        if constexpr (FieldTraits<T>::has_packed_layout) {
+            return encode(typename FieldTraits<T>::PackedVector{message}).to_vector();
+        }
         std::vector<T> encoded;
         encoded.reserve(2*block_size);
         for (unsigned i = 0; i < block_size; ++i) {
@@ -51,11 +63,95 @@ public:
         }
         return encoded;
     }
+
+    /**
+     * @brief Encode a message in the packed layout (FieldTraits::PackedVector, e.g. PackedGF4Vector),
+     * only for fields with has_packed_layout.
+     *
+     * Gives the same result as encode on the unpacked message. The product with the second block of G
+     * is computed on the packed symbols, see PackedGF4Vector::circulant_multiply_accumulate.
+     *
+     * @param message A vector of length block_size.
+     * @return Encoded message of length 2*block_size.
+     */
+    template<typename U = T, typename = std::enable_if_t<FieldTraits<U>::has_packed_layout>>
+    auto encode(const typename FieldTraits<U>::PackedVector& message) const -> typename FieldTraits<U>::PackedVector {
+        if (message.size() != block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+        std::array<std::vector<size_t>, 3> groups;
+        for (size_t k = 0; k < block_size; ++k) {
+            if (!second_block_G[k].is_zero()) {
+                groups[second_block_G[k].get_value() - 1].push_back(k);
+            }
+        }
+        using Packed = typename FieldTraits<U>::PackedVector;
+        Packed second_block{block_size};
+        Packed::circulant_multiply_accumulate(groups, message, second_block);
+        Packed encoded = message;
+        encoded.append(second_block);
+        return encoded;
+    }
+
+    [[nodiscard]] auto get_second_block_G() const -> const std::vector<T>& {
+        return second_block_G;
+    }
+
+    [[nodiscard]] auto get_block_size() const -> size_t {
+        return block_size;
+    }
 private:
     std::vector<T> second_block_G;
     size_t block_size;
 };
 
+/**
+ * @brief The outcome of a single decoding.
+ *
+ * @tparam T Finite field to be used.
+ */
+template <typename T>
+struct DecodingResult {
+    std::optional<std::vector<T>> error_vector;  ///< The error vector on success, nothing on failure.
+    DecodingStatus status = DecodingStatus::IterationsExhausted;
+    size_t iterations = 0;                       ///< Number of iterations actually performed.
+    std::vector<size_t> syndrome_weights;        ///< Initial syndrome weight followed by the weight after each iteration.
+    bool post_processed = false;                 ///< Whether the last errors were recovered by post-processing.
+    size_t binary_iterations = 0;                ///< Iterations done on the binary image, see BinaryImageDecoder.
+    bool binary_fallback = false;                ///< Whether the binary flips were dropped and the message decoded again.
+    bool erasures_solved = false;                ///< Whether the error vector was solved for directly, see decode_with_erasures.
+};
+
+/**
+ * @brief Parameters of the post-processing which finishes decodings that ended close to success.
+ *
+ * See DecodingContext::post_process.
+ */
+struct PostProcessingPolicy {
+    size_t max_syndrome_weight = 256;   ///< Post-processing is attempted only if the residual syndrome weight is at most this.
+    size_t max_candidates = 512;        ///< The maximum number of unknowns of the linear system.
+    size_t max_correction_weight = 8;   ///< Solutions with more nonzero symbols are rejected.
+
+    /**
+     * @brief Get a policy which never attempts the post-processing.
+     *
+     * @return Disabled policy.
+     */
+    static auto disabled() -> PostProcessingPolicy {
+        return PostProcessingPolicy{0, 0, 0};
+    }
+};
+
+/**
+ * @brief Parameters of decoding with known erasures, see DecodingContext::decode_with_erasures.
+ */
+struct ErasurePolicy {
+    size_t max_direct_erasures = 1024;   ///< The erased symbols are solved for directly only if there are at most this many.
+};
+
+template <typename T>
+class DecodingSession;
+
 /**
  * @brief Class that holds the private key H and provides decoding functionality.
  *
@@ -69,17 +165,29 @@ class DecodingContext {
 public:
     DecodingContext() : block_size(0), block_weight(0) {}
 
-    DecodingContext(const std::vector<T> &h0, const std::vector<T> &h1, size_t block_size, size_t block_weight) : h0(h0), h1(h1), block_size(block_size), block_weight(block_weight) {}
+    DecodingContext(const std::vector<T> &h0, const std::vector<T> &h1, size_t block_size, size_t block_weight) : h0(h0), h1(h1), block_size(block_size), block_weight(block_weight), kernel0(h0), kernel1(h1), support0(support(h0)), support1(support(h1)),
+              inverse0(inverses(h0, support0)), inverse1(inverses(h1, support1)) {}
 
     /**
      * @brief Calculate the syndrome of a given vector.
      *
      * The vector is expected to be of length 2*block_size.
+     * The key-specialized kernels (see SparseCirculant) are used unless MDPC_GF4_DISABLE_KEY_KERNELS is defined.
      *
      * @param vec Avector of length 2*block_size.
      * @return Syndrome stored in a vector of length block_size.
      */
-    auto calculate_syndrome(const std::vector<T>& vec) -> std::vector<T> {
+    auto calculate_syndrome(const std::vector<T>& vec) const -> std::vector<T> {
+        if (vec.size() != 2*block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+#ifndef MDPC_GF4_DISABLE_KEY_KERNELS
+        std::vector<T> syndrome;
+        syndrome.resize(block_size);
+        kernel0.multiply_accumulate(vec.data(), syndrome);
+        kernel1.multiply_accumulate(vec.data() + block_size, syndrome);
+        return syndrome;
+#else
         std::vector<T> syndrome;
         for (unsigned i = block_size; i > 0; --i) {
             T tmp{};
@@ -90,6 +198,25 @@ public:
             syndrome.push_back(tmp);
         }
         return syndrome;
+#endif
+    }
+
+    /**
+     * @brief Calculate the syndrome of a vector in the packed layout (FieldTraits::PackedVector, e.g. PackedGF4Vector),
+     * only for fields with has_packed_layout.
+     *
+     * @param vec A vector of length 2*block_size.
+     * @return Syndrome of length block_size.
+     */
+    template<typename U = T, typename = std::enable_if_t<FieldTraits<U>::has_packed_layout>>
+    auto calculate_syndrome(const typename FieldTraits<U>::PackedVector& vec) const -> typename FieldTraits<U>::PackedVector {
+        if (vec.size() != 2*block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+        typename FieldTraits<U>::PackedVector syndrome{block_size};
+        kernel0.multiply_accumulate(vec.slice(0, block_size), syndrome);
+        kernel1.multiply_accumulate(vec.slice(block_size, block_size), syndrome);
+        return syndrome;
     }
 
     /**
@@ -97,79 +224,633 @@ public:
      *
      * Decoding tries to find the used error vector. Message to decode must be of length 2*block_size.
      * There is a nonzero probability that the decoding will fail.
+     * All num_iterations iterations are run, pass a calibrated StagnationPolicy to decode_with_report to stop early.
      *
      * @param message A vector of length 2*block_size.
      * @param num_iterations Number of iterations of decoding.
      * @return The error vector of length 2*block_size on success, nothing on failure.
      */
-    auto decode(const std::vector<T>& message, size_t num_iterations) -> std::optional<std::vector<T>> {
+    auto decode(const std::vector<T>& message, size_t num_iterations) const -> std::optional<std::vector<T>> {
+        return decode_with_report(message, num_iterations, StagnationPolicy{}).error_vector;
+    }
+
+    /**
+     * @brief Decode a vector in the packed layout (FieldTraits::PackedVector, e.g. PackedGF4Vector),
+     * only for fields with has_packed_layout.
+     *
+     * The syndrome is computed on the packed symbols, only the syndrome is unpacked for the flip search.
+     *
+     * @param message A vector of length 2*block_size.
+     * @param num_iterations Number of iterations of decoding.
+     * @return The error vector of length 2*block_size on success, nothing on failure.
+     */
+    template<typename U = T, typename = std::enable_if_t<FieldTraits<U>::has_packed_layout>>
+    auto decode(const typename FieldTraits<U>::PackedVector& message, size_t num_iterations) const
+            -> std::optional<typename FieldTraits<U>::PackedVector> {
+        DecodingSession<T> session = start_decoding(message);
+        session.advance(num_iterations);
+        auto error_vector = session.finish().error_vector;
+        if (!error_vector) {
+            return {};
+        }
+        return typename FieldTraits<U>::PackedVector{error_vector.value()};
+    }
+
+    /**
+     * @brief Decode the given vector and report how the decoding went.
+     *
+     * In each iteration, the symbol flip (position j, value a) which decreases the syndrome weight the most is applied.
+     * Flipping the position j by a adds a times the j-th column of H to the syndrome.
+     * The decrease is evaluated for all candidates at once by match_counts before the first iteration and then updated
+     * only for the candidates adjacent to the changed checks (see FlipScores), unless MDPC_GF4_DISABLE_BUCKET_QUEUE is defined.
+     * The syndrome weight is recorded after every iteration and the decoding stops early as soon as
+     * the given policy considers it stagnating. Such decodings would almost surely fail anyway.
+     * If the decoding ends with a small nonzero syndrome, the remaining errors are searched for by post_process.
+     *
+     * @param message A vector of length 2*block_size.
+     * @param num_iterations Maximum number of iterations of decoding.
+     * @param policy Rules for early failure detection.
+     * @param post_processing Rules for post-processing.
+     * @return The result of decoding, including the reason why the decoding stopped and the syndrome weight trajectory.
+     */
+    auto decode_with_report(const std::vector<T>& message, size_t num_iterations, const StagnationPolicy& policy,
+                            const PostProcessingPolicy& post_processing = PostProcessingPolicy{}) const -> DecodingResult<T> {
+        DecodingSession<T> session = start_decoding(message, policy);
+        session.advance(num_iterations);
+        return session.finish(post_processing);
+    }
+
+    /**
+     * @brief Start a decoding which is advanced by the caller, see DecodingSession.
+     *
+     * @throws IncorrectInputVectorLength if the message is not of length 2*block_size.
+     * @param message A vector of length 2*block_size.
+     * @param policy Rules for early failure detection.
+     * @return The decoding, before its first iteration. The context must outlive it.
+     */
+    auto start_decoding(const std::vector<T>& message, const StagnationPolicy& policy = StagnationPolicy{}) const -> DecodingSession<T> {
         if (message.size() != 2*block_size) {
             throw IncorrectInputVectorLength{};
         }
+        return DecodingSession<T>{*this, calculate_syndrome(message), policy};
+    }
 
-        std::vector<T> syndrome = calculate_syndrome(message);
-        size_t syndrome_weight = hamming_weight(syndrome);
-        std::vector<T> error_vector;
-        error_vector.resize(2 * block_size);
+    /**
+     * @brief start_decoding for a vector in the packed layout (FieldTraits::PackedVector, e.g. PackedGF4Vector),
+     * only for fields with has_packed_layout.
+     */
+    template<typename U = T, typename = std::enable_if_t<FieldTraits<U>::has_packed_layout>>
+    auto start_decoding(const typename FieldTraits<U>::PackedVector& message,
+                        const StagnationPolicy& policy = StagnationPolicy{}) const -> DecodingSession<T> {
+        return DecodingSession<T>{*this, calculate_syndrome(message).to_vector(), policy};
+    }
 
-        if (syndrome_weight == 0) {
-            return error_vector;
-        }
-
-        std::vector<T> nonzero_values = T::nonzero_elements();
-
-        for (size_t iter = 0; iter < num_iterations; ++iter) {
-            size_t sigma_max = 2*block_size + 1;
-            T a_max{};
-            size_t pos = 2*block_size + 1;
-            for (size_t j = 0; j < 2*block_size; ++j) {
-                auto& h_block = (j < block_size) ? h0: h1;
-                for (const T& a: nonzero_values) {
-                    // calculate the hamming weight of s - a*h_j
-                    size_t w = 0;
-                    for (size_t i = 0; i < syndrome.size(); ++i) {
-                        T tmp = syndrome[i] + (a * h_block[i]);
-                        w += (size_t)tmp.is_zero();
-                    }
-                    size_t sigma = syndrome_weight - w;
-                    if (sigma > sigma_max) {
-                        sigma_max = sigma;
-                        a_max = a;
-                        pos = j;
-                    }
-                }
+    /**
+     * @brief Find a small error vector with the given syndrome by solving a linear system.
+     *
+     * Only the positions adjacent to unsatisfied checks (nonzero syndrome entries) are considered,
+     * preferring those adjacent to the most unsatisfied checks. At most policy.max_candidates of them become
+     * the unknowns of the linear system He = s restricted to these positions, which is then solved by gaussian
+     * elimination (see solve_linear_system).
+     * The preferred positions, e.g. known erasures, are always unknowns and do not count towards policy.max_correction_weight.
+     *
+     * @param syndrome The residual syndrome of length block_size.
+     * @param policy Limits of the post-processing.
+     * @param preferred Positions which are unknowns before all others.
+     * @return An error vector of length 2*block_size with the given syndrome if found, nothing otherwise.
+     */
+    auto post_process(const std::vector<T>& syndrome, const PostProcessingPolicy& policy,
+                      const std::vector<size_t>& preferred = {}) const -> std::optional<std::vector<T>> {
+        if (syndrome.size() != block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+
+        // position j is adjacent to check r iff H[r][j] = h[(j - r) mod block_size] is nonzero
+        std::vector<size_t> adjacent_unsatisfied;
+        adjacent_unsatisfied.resize(2 * block_size);
+        for (size_t r = 0; r < block_size; ++r) {
+            if (syndrome[r].is_zero()) {
+                continue;
             }
-            auto& h_block = (pos < block_size) ? h0: h1;
-            syndrome_weight = 0;
-            for (size_t i = 0; i < syndrome.size(); ++i) {
-                syndrome[i] += (a_max*h_block[i]);
-                syndrome_weight += (size_t)syndrome[i].is_zero();
+            for (size_t k: support0) {
+                adjacent_unsatisfied[(r + k) % block_size] += 1;
+            }
+            for (size_t k: support1) {
+                adjacent_unsatisfied[block_size + (r + k) % block_size] += 1;
             }
-            error_vector[pos] = a_max;
         }
-        if (is_vector_zero(syndrome)) {
-            return error_vector;
-        } else {
+        std::vector<bool> is_preferred;
+        is_preferred.resize(2 * block_size);
+        std::vector<size_t> candidates;
+        for (size_t j: preferred) {
+            if (!is_preferred[j]) {
+                is_preferred[j] = true;
+                candidates.push_back(j);
+            }
+        }
+        size_t num_preferred = candidates.size();
+        for (size_t j = 0; j < 2 * block_size; ++j) {
+            if (adjacent_unsatisfied[j] != 0 && !is_preferred[j]) {
+                candidates.push_back(j);
+            }
+        }
+        std::stable_sort(candidates.begin() + num_preferred, candidates.end(), [&](size_t a, size_t b) {
+            return adjacent_unsatisfied[a] > adjacent_unsatisfied[b];
+        });
+        if (candidates.size() > num_preferred + policy.max_candidates) {
+            candidates.resize(num_preferred + policy.max_candidates);
+        }
+        if (candidates.empty()) {
             return {};
         }
+
+        size_t rank = 0;
+        auto solution = solve_on_positions(syndrome, candidates, rank);
+        if (rank < candidates.size()) {
+            // the solution would not be unique, a wrong one is worse than a decoding failure
+            return {};
+        }
+        if (!solution) {
+            return {};
+        }
+        size_t correction_weight = 0;
+        for (size_t c = num_preferred; c < candidates.size(); ++c) {
+            correction_weight += !solution.value()[c].is_zero();
+        }
+        if (correction_weight > policy.max_correction_weight) {
+            return {};
+        }
+        std::vector<T> correction;
+        correction.resize(2 * block_size);
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            correction[candidates[c]] = solution.value()[c];
+        }
+        return correction;
     }
+
+    /**
+     * @brief Decode a vector in which some symbols are known to be unreliable, e.g. lost in transport.
+     *
+     * The values of the message at the erased positions are arbitrary. If there are at most policy.max_direct_erasures erasures,
+     * the errors at the erased positions are first solved for directly: the checks adjacent to the erasures and the unsatisfied
+     * checks form a linear system whose unknowns are the erased symbols (see solve_linear_system). If it has a unique solution,
+     * it is the error vector and no iteration is needed. Otherwise there are errors outside the erasures as well,
+     * and the iterative decoder runs with the flips at erased positions taking precedence over all others
+     * as long as they decrease the syndrome weight. The erasures are then the first unknowns of the post-processing.
+     *
+     * @param message A vector of length 2*block_size.
+     * @param erasures The positions of the unreliable symbols, each less than 2*block_size.
+     * @param num_iterations Maximum number of iterations of decoding.
+     * @param policy Rules for early failure detection.
+     * @param post_processing Rules for post-processing.
+     * @param erasure_policy Limit of the direct solution.
+     * @return The result of decoding.
+     */
+    auto decode_with_erasures(const std::vector<T>& message, const std::vector<size_t>& erasures, size_t num_iterations,
+                              const StagnationPolicy& policy = StagnationPolicy{},
+                              const PostProcessingPolicy& post_processing = PostProcessingPolicy{},
+                              const ErasurePolicy& erasure_policy = ErasurePolicy{}) const -> DecodingResult<T> {
+        if (message.size() != 2*block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+        for (size_t j: erasures) {
+            if (j >= 2*block_size) {
+                throw IncorrectInputVectorLength{};
+            }
+        }
+        DecodingSession<T> session{*this, calculate_syndrome(message), policy};
+        if (session.syndrome_weight != 0 && !erasures.empty() && erasures.size() <= erasure_policy.max_direct_erasures) {
+            std::vector<bool> seen;
+            seen.resize(2*block_size);
+            std::vector<size_t> positions;
+            for (size_t j: erasures) {
+                if (!seen[j]) {
+                    seen[j] = true;
+                    positions.push_back(j);
+                }
+            }
+            size_t rank = 0;
+            auto solution = solve_on_positions(session.syndrome, positions, rank);
+            if (solution && rank == positions.size()) {
+                DecodingResult<T> result;
+                std::vector<T> error_vector;
+                error_vector.resize(2*block_size);
+                for (size_t c = 0; c < positions.size(); ++c) {
+                    error_vector[positions[c]] = solution.value()[c];
+                }
+                result.error_vector = error_vector;
+                result.status = DecodingStatus::Success;
+                result.erasures_solved = true;
+                result.syndrome_weights = session.detector.get_trajectory();
+                return result;
+            }
+        }
+        session.prefer(erasures);
+        session.advance(num_iterations);
+        return session.finish(post_processing);
+    }
+
+    [[nodiscard]] auto get_h0() const -> const std::vector<T>& {
+        return h0;
+    }
+
+    [[nodiscard]] auto get_h1() const -> const std::vector<T>& {
+        return h1;
+    }
+
+    [[nodiscard]] auto get_block_size() const -> size_t {
+        return block_size;
+    }
+
 private:
+    friend class DecodingSession<T>;
+
+    /**
+     * @brief Apply the best symbol flip, see decode_with_report.
+     *
+     * @param syndrome The syndrome, updated in place.
+     * @param error_vector The error vector found so far, updated in place.
+     * @param nonzero_values The nonzero elements of T.
+     * @param preferred The positions whose flips are taken before all others if they decrease the syndrome weight, empty for none.
+     * @param syndrome_weight The hamming weight of the syndrome, updated in place.
+     */
+    auto iterate(std::vector<T>& syndrome, std::vector<T>& error_vector, const std::vector<T>& nonzero_values,
+                 const std::vector<size_t>& preferred, size_t& syndrome_weight) const -> void {
+        MatchCounts counts0 = match_counts(syndrome, h0);
+        MatchCounts counts1 = match_counts(syndrome, h1);
+        long sigma_max = 0;
+        T a_max{};
+        size_t pos = 2*block_size;
+        for (size_t j: preferred) {
+            const MatchCounts& counts = (j < block_size) ? counts0: counts1;
+            for (size_t i = 0; i < nonzero_values.size(); ++i) {
+                long sigma = counts.sigma(i, j % block_size);
+                if (sigma > sigma_max) {
+                    sigma_max = sigma;
+                    a_max = nonzero_values[i];
+                    pos = j;
+                }
+            }
+        }
+        bool preferred_found = (pos != 2*block_size);
+        for (size_t j = 0; j < 2*block_size && !preferred_found; ++j) {
+            const MatchCounts& counts = (j < block_size) ? counts0: counts1;
+            size_t column = j % block_size;
+            for (size_t i = 0; i < nonzero_values.size(); ++i) {
+                long sigma = counts.sigma(i, column);
+                if (pos == 2*block_size || sigma > sigma_max) {
+                    sigma_max = sigma;
+                    a_max = nonzero_values[i];
+                    pos = j;
+                }
+            }
+        }
+#ifndef MDPC_GF4_DISABLE_KEY_KERNELS
+        ((pos < block_size) ? kernel0: kernel1).add_column(pos % block_size, a_max, syndrome);
+#else
+        auto& h_block = (pos < block_size) ? h0: h1;
+        size_t column = pos % block_size;
+        for (size_t i = 0; i < syndrome.size(); ++i) {
+            syndrome[i] += (a_max*h_block[(block_size + column - i) % block_size]);
+        }
+#endif
+        error_vector[pos] += a_max;
+        syndrome_weight -= sigma_max;
+    }
+
+    /**
+     * @brief iterate with the scores of all candidates kept between iterations, see FlipScores.
+     *
+     * The scores are computed by match_counts when they are empty. A flip changes only the checks in the support
+     * of its column, and a change of a check only changes the scores of the positions adjacent to it,
+     * so each iteration updates the scores of about 2 * w * w positions and takes the best one from the bucket queue
+     * instead of scoring all 2 * n positions. The syndrome weight is updated from the changed checks as well.
+     *
+     * Among flips with equal scores, the queue returns the position whose score changed last, so on ties
+     * the flips may differ from the full scan, which takes the first position.
+     *
+     * @param syndrome The syndrome, updated in place.
+     * @param error_vector The error vector found so far, updated in place.
+     * @param nonzero_values The nonzero elements of T.
+     * @param preferred The positions whose flips are taken before all others if they decrease the syndrome weight, empty for none.
+     * @param syndrome_weight The hamming weight of the syndrome, updated in place.
+     * @param scores The scores of the candidates for the current syndrome, empty before the first iteration.
+     */
+    auto iterate(std::vector<T>& syndrome, std::vector<T>& error_vector, const std::vector<T>& nonzero_values,
+                 const std::vector<size_t>& preferred, size_t& syndrome_weight, FlipScores& scores) const -> void {
+        size_t q = nonzero_values.size();
+        if (scores.empty()) {
+            long max_score = (long)std::max(support0.size(), support1.size());
+            scores.sigma.resize(2 * block_size * q);
+            scores.positions = BucketQueue{2 * block_size, -max_score, max_score};
+            scores.value_index.resize(q + 1);
+            for (size_t i = 0; i < q; ++i) {
+                scores.value_index[nonzero_values[i].get_value()] = i;
+            }
+            MatchCounts counts0 = match_counts(syndrome, h0);
+            MatchCounts counts1 = match_counts(syndrome, h1);
+            for (size_t j = 0; j < 2 * block_size; ++j) {
+                const MatchCounts& counts = (j < block_size) ? counts0: counts1;
+                for (size_t i = 0; i < q; ++i) {
+                    scores.sigma[j * q + i] = (int32_t)counts.sigma(i, j % block_size);
+                }
+            }
+            // set backwards, so that the first iteration breaks ties towards the first position as the full scan does
+            for (size_t j = 2 * block_size; j > 0; --j) {
+                scores.positions.set(j - 1, scores.sigma[(j - 1) * q + scores.best_value(j - 1, q)]);
+            }
+        }
+
+        size_t pos = 2 * block_size;
+        long sigma_max = 0;
+        for (size_t j: preferred) {
+            long sigma = scores.positions.key(j);
+            if (sigma > sigma_max) {
+                sigma_max = sigma;
+                pos = j;
+            }
+        }
+        if (pos == 2 * block_size) {
+            pos = scores.positions.top();
+        }
+        const T& a = nonzero_values[scores.best_value(pos, q)];
+
+        const auto& h_block = (pos < block_size) ? h0: h1;
+        size_t column = pos % block_size;
+        for (size_t k: (pos < block_size) ? support0: support1) {
+            size_t r = (block_size + column - k) % block_size;
+            T updated = syndrome[r] + a * h_block[k];
+            syndrome_weight += rescore_check(r, syndrome[r], updated, scores);
+            syndrome[r] = updated;
+        }
+        error_vector[pos] += a;
+    }
+
+    /**
+     * @brief Update the scores of the candidates adjacent to the check r when it changes from old_value to new_value.
+     *
+     * The check contributes [s_r = a * h[k]] - [s_r = 0] to the score of flipping its adjacent position by a, where k is
+     * the offset of the position in the check. A zero check contributes -1 to every value a, a nonzero one +1 to the single
+     * value a = s_r / h[k], so only these scores change.
+     *
+     * @return The change of the syndrome weight, -1, 0 or 1.
+     */
+    auto rescore_check(size_t r, const T& old_value, const T& new_value, FlipScores& scores) const -> long {
+        const std::vector<size_t>& value_index = scores.value_index;
+        size_t q = value_index.size() - 1;
+        // the change of the contribution to every value, the values old_value / h[k] and new_value / h[k] change by one more
+        int32_t common = (old_value.is_zero() ? 1: 0) - (new_value.is_zero() ? 1: 0);
+        for (size_t b = 0; b < 2; ++b) {
+            const auto& h_support = (b == 0) ? support0: support1;
+            const auto& h_inverse = (b == 0) ? inverse0: inverse1;
+            for (size_t s = 0; s < h_support.size(); ++s) {
+                size_t j = b * block_size + (r + h_support[s]) % block_size;
+                int32_t* sigma = scores.sigma.data() + j * q;
+                if (common != 0) {
+                    for (size_t i = 0; i < q; ++i) {
+                        sigma[i] += common;
+                    }
+                }
+                if (!old_value.is_zero()) {
+                    sigma[value_index[(old_value * h_inverse[s]).get_value()]] -= 1;
+                }
+                if (!new_value.is_zero()) {
+                    sigma[value_index[(new_value * h_inverse[s]).get_value()]] += 1;
+                }
+                scores.requeue(j, q);
+            }
+        }
+        return common;
+    }
+
+    /**
+     * @brief Solve He = s for an error vector supported on the given positions.
+     *
+     * The rows of the system are the unsatisfied checks and the checks adjacent to some position.
+     *
+     * @param syndrome The syndrome s.
+     * @param positions The unknowns.
+     * @param rank Receives the rank of the system, the solution is unique iff it equals positions.size().
+     * @return The values at the positions if the system is consistent, nothing otherwise.
+     */
+    auto solve_on_positions(const std::vector<T>& syndrome, const std::vector<size_t>& positions,
+                            size_t& rank) const -> std::optional<std::vector<T>> {
+        std::vector<size_t> row_index;
+        row_index.resize(block_size, block_size);
+        std::vector<std::vector<T>> matrix;
+        std::vector<T> rhs;
+        auto get_row = [&](size_t r) -> size_t {
+            if (row_index[r] == block_size) {
+                row_index[r] = matrix.size();
+                matrix.emplace_back(positions.size());
+                rhs.push_back(syndrome[r]);
+            }
+            return row_index[r];
+        };
+        for (size_t r = 0; r < block_size; ++r) {
+            if (!syndrome[r].is_zero()) {
+                get_row(r);
+            }
+        }
+        for (size_t c = 0; c < positions.size(); ++c) {
+            size_t j = positions[c];
+            auto& h_block = (j < block_size) ? h0: h1;
+            auto& h_support = (j < block_size) ? support0: support1;
+            size_t column = j % block_size;
+            for (size_t k: h_support) {
+                matrix[get_row((block_size + column - k) % block_size)][c] = h_block[k];
+            }
+        }
+        return solve_linear_system(matrix, rhs, &rank);
+    }
+
+    static auto inverses(const std::vector<T>& vec, const std::vector<size_t>& vec_support) -> std::vector<T> {
+        std::vector<T> out;
+        for (size_t k: vec_support) {
+            out.push_back(T{1} / vec[k]);
+        }
+        return out;
+    }
+
+    static auto support(const std::vector<T>& vec) -> std::vector<size_t> {
+        std::vector<size_t> out;
+        for (size_t i = 0; i < vec.size(); ++i) {
+            if (!vec[i].is_zero()) {
+                out.push_back(i);
+            }
+        }
+        return out;
+    }
+
     std::vector<T> h0;
     std::vector<T> h1;
     size_t block_size;
     size_t block_weight;
+    SparseCirculant<T> kernel0;
+    SparseCirculant<T> kernel1;
+    std::vector<size_t> support0;
+    std::vector<size_t> support1;
+    std::vector<T> inverse0;   ///< The inverses of the nonzero entries of h0, in the order of support0.
+    std::vector<T> inverse1;
 };
 
 /**
- * @brief Generate public (matrix G) and private (matrix H) keys and the classes that store them.
+ * @brief A single decoding which is advanced a few iterations at a time, see DecodingContext::start_decoding.
+ *
+ * The session holds the syndrome, the error vector found so far and the stagnation detector, so that one thread
+ * can interleave many decodings and decide from outside how long each of them may run: e.g. advance every session
+ * by a few iterations in turn, and finish the sessions which missed their deadline or escalate them elsewhere.
+ * Advancing a session by k iterations and then by l iterations is the same as advancing it by k + l iterations,
+ * and DecodingContext::decode_with_report is advance(num_iterations) followed by finish.
+ *
+ * @tparam T Finite field to be used.
+ */
+template <typename T>
+class DecodingSession {
+public:
+    /**
+     * @brief Run up to the given number of iterations. Does nothing once the decoding has stopped.
+     *
+     * @param num_iterations The maximum number of iterations.
+     * @return Whether the decoding has stopped, i.e. succeeded or was declared stagnating.
+     */
+    auto advance(size_t num_iterations) -> bool {
+        for (size_t i = 0; i < num_iterations && !stopped(); ++i) {
+#ifndef MDPC_GF4_DISABLE_BUCKET_QUEUE
+            context->iterate(syndrome, error_vector, nonzero_values, preferred, syndrome_weight, scores);
+#else
+            context->iterate(syndrome, error_vector, nonzero_values, preferred, syndrome_weight);
+#endif
+            ++iterations;
+            DecodingStatus verdict = detector.update(syndrome_weight);
+            if (syndrome_weight == 0) {
+                status = DecodingStatus::Success;
+            } else if (verdict != DecodingStatus::IterationsExhausted) {
+                status = verdict;
+            }
+        }
+        return stopped();
+    }
+
+    /**
+     * @brief Stop the decoding and report its outcome.
+     *
+     * A decoding which has not stopped yet is reported as IterationsExhausted unless the post-processing finishes it.
+     *
+     * @param post_processing Rules for post-processing, see DecodingContext::post_process.
+     * @return The result of decoding.
+     */
+    auto finish(const PostProcessingPolicy& post_processing = PostProcessingPolicy{}) const -> DecodingResult<T> {
+        DecodingResult<T> result;
+        std::vector<T> found = error_vector;
+        size_t weight = syndrome_weight;
+        if (weight != 0 && weight <= post_processing.max_syndrome_weight) {
+            auto correction = context->post_process(syndrome, post_processing, preferred);
+            if (correction) {
+                for (size_t j = 0; j < found.size(); ++j) {
+                    found[j] += correction.value()[j];
+                }
+                weight = 0;
+                result.post_processed = true;
+            }
+        }
+        result.status = status;
+        if (weight == 0) {
+            result.error_vector = found;
+            result.status = DecodingStatus::Success;
+        }
+        result.iterations = iterations;
+        result.syndrome_weights = detector.get_trajectory();
+        return result;
+    }
+
+    /**
+     * @brief Whether the decoding has stopped, i.e. succeeded or was declared stagnating.
+     */
+    [[nodiscard]] auto stopped() const -> bool {
+        return syndrome_weight == 0 || status != DecodingStatus::IterationsExhausted;
+    }
+
+    /**
+     * @brief Get the reason why the decoding stopped, IterationsExhausted while it is running.
+     */
+    [[nodiscard]] auto get_status() const -> DecodingStatus {
+        return syndrome_weight == 0 ? DecodingStatus::Success: status;
+    }
+
+    [[nodiscard]] auto get_iterations() const -> size_t {
+        return iterations;
+    }
+
+    [[nodiscard]] auto get_syndrome_weight() const -> size_t {
+        return syndrome_weight;
+    }
+
+    /**
+     * @brief Get the error vector found so far, which is the decoded error vector once the status is Success.
+     */
+    [[nodiscard]] auto get_error_vector() const -> const std::vector<T>& {
+        return error_vector;
+    }
+
+private:
+    friend class DecodingContext<T>;
+
+    /**
+     * @brief Take the flips at the given positions first, see DecodingContext::decode_with_erasures.
+     */
+    auto prefer(const std::vector<size_t>& positions) -> void {
+        preferred = positions;
+        std::sort(preferred.begin(), preferred.end());
+        preferred.erase(std::unique(preferred.begin(), preferred.end()), preferred.end());
+    }
+
+    DecodingSession(const DecodingContext<T>& context, std::vector<T> syndrome, const StagnationPolicy& policy)
+            : context(&context), syndrome(std::move(syndrome)), syndrome_weight(hamming_weight(this->syndrome)),
+              error_vector(2 * context.get_block_size()), detector(policy), nonzero_values(T::nonzero_elements()),
+              status(DecodingStatus::IterationsExhausted), iterations(0) {
+        detector.update(syndrome_weight);
+        if (syndrome_weight == 0) {
+            status = DecodingStatus::Success;
+        }
+    }
+
+    const DecodingContext<T>* context;
+    std::vector<T> syndrome;
+    size_t syndrome_weight;
+    std::vector<T> error_vector;
+    StagnationDetector detector;
+    std::vector<T> nonzero_values;
+    DecodingStatus status;
+    size_t iterations;
+    std::vector<size_t> preferred;
+    FlipScores scores;   ///< The scores of the flips, see DecodingContext::iterate.
+};
+
+/**
+ * @brief The vectors which make up a key pair, see EncodingContext and DecodingContext.
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+struct KeyBlocks {
+    std::vector<T> second_block_G;
+    std::vector<T> h0;
+    std::vector<T> h1;
+};
+
+/**
+ * @brief Generate the vectors of public (matrix G) and private (matrix H) keys.
  *
  * @tparam T Finite field to be used.
  * @param block_size The size of the circulant block of the matrices.
  * @param block_weight The hamming weight of the row of the block of the matrix H.
- * @return Instantiated classes EncodingContext and DecodingContext.
+ * @param half_gcd_threshold The threshold of the inversion of h1, see PolynomialGF2N::invert.
+ * @return The vectors of the keys.
  */
 template<typename T>
-auto generate_contexts_over_GF2N(size_t block_size, size_t block_weight) -> std::tuple<EncodingContext<T>, DecodingContext<T>> {
+auto generate_key_blocks(size_t block_size, size_t block_weight,
+                         size_t half_gcd_threshold = default_half_gcd_threshold<T>()) -> KeyBlocks<T> {
     PolynomialGF2N<T> modulus;
     modulus.set_coefficient(0, T{1});
     modulus.set_coefficient(block_size, T{1});
@@ -180,7 +861,7 @@ auto generate_contexts_over_GF2N(size_t block_size, size_t block_weight) -> std:
             continue;
         }
         PolynomialGF2N<T> h1_poly{h1};
-        auto maybe_inverse = h1_poly.invert(modulus);
+        auto maybe_inverse = h1_poly.invert(modulus, half_gcd_threshold);
         if (maybe_inverse) {
             PolynomialGF2N<T> inverse = maybe_inverse.value();
             PolynomialGF2N<T> tmp = (h1_poly * inverse) % modulus;
@@ -190,13 +871,28 @@ auto generate_contexts_over_GF2N(size_t block_size, size_t block_weight) -> std:
                 throw WTF{};
             }
             PolynomialGF2N<T> h0_poly{h0};
-            PolynomialGF2N<T> second_block_G_poly = h0_poly * inverse;
+            PolynomialGF2N<T> second_block_G_poly = (h0_poly * inverse) % modulus;
             std::vector<T> second_block_G = second_block_G_poly.to_vector();
-            EncodingContext<T> ec{second_block_G, block_size};
-            DecodingContext<T> dc{h0, h1, block_size, block_weight};
-            return std::make_tuple(ec, dc);
+            second_block_G.resize(block_size);
+            return KeyBlocks<T>{second_block_G, h0, h1};
         }
     }
 }
 
+/**
+ * @brief Generate public (matrix G) and private (matrix H) keys and the classes that store them.
+ *
+ * @tparam T Finite field to be used.
+ * @param block_size The size of the circulant block of the matrices.
+ * @param block_weight The hamming weight of the row of the block of the matrix H.
+ * @return Instantiated classes EncodingContext and DecodingContext.
+ */
+template<typename T>
+auto generate_contexts_over_GF2N(size_t block_size, size_t block_weight) -> std::tuple<EncodingContext<T>, DecodingContext<T>> {
+    KeyBlocks<T> blocks = generate_key_blocks<T>(block_size, block_weight);
+    EncodingContext<T> ec{blocks.second_block_G, block_size};
+    DecodingContext<T> dc{blocks.h0, blocks.h1, block_size, block_weight};
+    return std::make_tuple(ec, dc);
+}
+
 #endif //MDPC_GF4_ENCODING_CONTEXT_H
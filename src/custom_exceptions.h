@@ -33,6 +33,54 @@ struct ImpossibleHammingWeight : public std::exception {
     }
 };
 
+struct RandomnessUnavailable : public std::exception {
+    auto what() -> const char * {
+        return "The operating system provides no secure random bytes!";
+    }
+};
+
+struct TooManyReaders : public std::exception {
+    auto what() -> const char * {
+        return "All reader slots of the key set holder are taken!";
+    }
+};
+
+struct InvalidKeyFile : public std::exception {
+    auto what() -> const char * {
+        return "The file is not a key file of the expected field and parameters!";
+    }
+};
+
+struct KeyFileIOError : public std::exception {
+    auto what() -> const char * {
+        return "The key file cannot be opened, resized, mapped or flushed!";
+    }
+};
+
+struct KeyNotProvisioned : public std::exception {
+    auto what() -> const char * {
+        return "The requested slot of the key file holds no complete key pair!";
+    }
+};
+
+struct FileIOError : public std::exception {
+    auto what() -> const char * {
+        return "The file cannot be opened, read or written!";
+    }
+};
+
+struct InvalidSealedFile : public std::exception {
+    auto what() -> const char * {
+        return "The file is not a sealed file of the expected field and block size!";
+    }
+};
+
+struct UnknownParameterSet : public std::exception {
+    auto what() -> const char * {
+        return "No parameter set of this name, field and block size is registered!";
+    }
+};
+
 struct WTF : public std::exception {
     auto what() -> const char * {
         return "This shouldn't have happened. This is a bug! read the comments!";
@@ -0,0 +1,354 @@
+#ifndef MDPC_GF4_DECODE_POOL_H
+#define MDPC_GF4_DECODE_POOL_H
+
+#include <vector>
+#include <deque>
+#include <optional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <algorithm>
+#include <utility>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "contexts.h"
+#include "custom_exceptions.h"
+
+/**
+ * @brief Parameters of DecodePool.
+ */
+struct DecodePoolOptions {
+    size_t num_threads = 0;       ///< The number of workers, 0 uses the hardware concurrency.
+    size_t group_size = 1;        ///< The number of consecutive workers per group, which steal from each other first.
+    size_t steal_threshold = 1;   ///< A worker steals from a queue only if it holds at least this many requests.
+    bool pin_threads = false;     ///< Pin the worker w to the w-th CPU the process may run on (Linux only).
+};
+
+/**
+ * @brief Counters of DecodePool.
+ */
+struct DecodePoolStatistics {
+    size_t executed = 0;   ///< The number of decoded requests.
+    size_t stolen = 0;     ///< The number of requests decoded by a worker other than their home worker.
+};
+
+/**
+ * @brief A pool of decoding threads which routes the requests of a key to the same worker.
+ *
+ * Every key has a home worker: the workers are split into groups of DecodePoolOptions::group_size, the key id selects
+ * a group and a worker within the group. All requests of the key are queued at its home worker, so its h0, h1
+ * and the kernels derived from them stay in the caches of one core. A worker which runs out of requests steals
+ * the most recently queued request of another worker, first within its group and then from the others,
+ * so an uneven mix of keys still keeps all workers busy.
+ * The groups are ranges of worker indices; with pin_threads they are ranges of the CPUs in the affinity mask of the
+ * process, which are not matched against the cache topology, so choose group_size accordingly.
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+class DecodePool {
+public:
+    /**
+     * @brief Start the workers.
+     *
+     * @param keys The decoding contexts, the key id of a request is the index in this vector.
+     * @param options The parameters of the pool.
+     */
+    explicit DecodePool(std::vector<DecodingContext<T>> keys, const DecodePoolOptions& options = DecodePoolOptions{})
+            : keys(std::move(keys)), options(options), stopping(false) {
+        size_t num_threads = options.num_threads;
+        if (num_threads == 0) {
+            num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        this->options.group_size = std::max<size_t>(1, std::min(options.group_size, num_threads));
+        this->options.steal_threshold = std::max<size_t>(1, options.steal_threshold);
+        num_workers = num_threads;
+#ifdef __linux__
+        if (options.pin_threads) {
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+                for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                    if (CPU_ISSET(cpu, &allowed)) {
+                        cpus.push_back(cpu);
+                    }
+                }
+            }
+        }
+#endif
+        workers.reset(new Worker[num_workers]);
+        for (size_t w = 0; w < num_workers; ++w) {
+            threads.emplace_back([this, w]() { run(w); });
+        }
+    }
+
+    DecodePool(const DecodePool&) = delete;
+    auto operator=(const DecodePool&) -> DecodePool& = delete;
+
+    /**
+     * @brief Decode the queued requests and stop the workers.
+     */
+    ~DecodePool() {
+        stopping.store(true);
+        for (size_t w = 0; w < num_workers; ++w) {
+            std::lock_guard<std::mutex> lock{workers[w].mutex};
+            workers[w].wake.notify_one();
+        }
+        for (auto& thread: threads) {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Queue a decoding at the home worker of its key.
+     *
+     * @throws IncorrectValueRange if there is no key with the given id.
+     * @param key_id The index of the decoding context.
+     * @param message A vector of length 2*block_size.
+     * @param num_iterations Maximum number of iterations of decoding.
+     * @param policy Rules for early failure detection.
+     * @return The result of DecodingContext::decode_with_report, when it is done.
+     */
+    auto submit(size_t key_id, std::vector<T> message, size_t num_iterations,
+                const StagnationPolicy& policy = StagnationPolicy{}) -> std::future<DecodingResult<T>> {
+        if (key_id >= keys.size()) {
+            throw IncorrectValueRange{};
+        }
+        Request request{key_id, std::move(message), num_iterations, policy, {}};
+        auto future = request.promise.get_future();
+        size_t home = home_worker(key_id);
+        Worker& worker = workers[home];
+        bool busy;
+        {
+            std::lock_guard<std::mutex> lock{worker.mutex};
+            worker.requests.push_back(std::move(request));
+            worker.queued.store(worker.requests.size());
+            busy = worker.busy;
+            worker.wake.notify_one();
+        }
+        if (busy && worker.queued.load() >= options.steal_threshold) {
+            wake_idle_worker(home);
+        }
+        return future;
+    }
+
+    /**
+     * @brief Decode a batch of requests.
+     *
+     * @param requests Pairs of key id and message.
+     * @param num_iterations Maximum number of iterations of decoding.
+     * @param policy Rules for early failure detection.
+     * @return The results in the order of the requests.
+     */
+    auto decode_batch(const std::vector<std::pair<size_t, std::vector<T>>>& requests, size_t num_iterations,
+                      const StagnationPolicy& policy = StagnationPolicy{}) -> std::vector<DecodingResult<T>> {
+        std::vector<std::future<DecodingResult<T>>> futures;
+        futures.reserve(requests.size());
+        for (const auto& [key_id, message]: requests) {
+            futures.push_back(submit(key_id, message, num_iterations, policy));
+        }
+        std::vector<DecodingResult<T>> results;
+        results.reserve(requests.size());
+        for (auto& future: futures) {
+            results.push_back(future.get());
+        }
+        return results;
+    }
+
+    /**
+     * @brief Get the worker whose queue receives the requests of a key.
+     */
+    [[nodiscard]] auto home_worker(size_t key_id) const -> size_t {
+        size_t num_groups = (num_workers + options.group_size - 1) / options.group_size;
+        size_t group = key_id % num_groups;
+        size_t group_begin = group * options.group_size;
+        size_t group_end = std::min(num_workers, group_begin + options.group_size);
+        return group_begin + (key_id / num_groups) % (group_end - group_begin);
+    }
+
+    [[nodiscard]] auto get_num_workers() const -> size_t {
+        return num_workers;
+    }
+
+    [[nodiscard]] auto get_statistics() const -> DecodePoolStatistics {
+        DecodePoolStatistics statistics;
+        for (size_t w = 0; w < num_workers; ++w) {
+            statistics.executed += workers[w].executed.load();
+            statistics.stolen += workers[w].stolen.load();
+        }
+        return statistics;
+    }
+
+private:
+    struct Request {
+        size_t key_id;
+        std::vector<T> message;
+        size_t num_iterations;
+        StagnationPolicy policy;
+        std::promise<DecodingResult<T>> promise;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<Request> requests;
+        std::atomic<size_t> queued{0};   ///< requests.size(), readable without the mutex
+        bool busy = false;
+        bool idle = false;
+        std::atomic<size_t> executed{0};
+        std::atomic<size_t> stolen{0};
+    };
+
+    auto run(size_t w) -> void {
+#ifdef __linux__
+        if (!cpus.empty()) {
+            cpu_set_t cpu;
+            CPU_ZERO(&cpu);
+            CPU_SET(cpus[w % cpus.size()], &cpu);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu), &cpu);
+        }
+#endif
+        Worker& self = workers[w];
+        while (true) {
+            std::optional<Request> request;
+            {
+                std::unique_lock<std::mutex> lock{self.mutex};
+                if (!self.requests.empty()) {
+                    request.emplace(std::move(self.requests.front()));
+                    self.requests.pop_front();
+                    self.queued.store(self.requests.size());
+                    self.busy = true;
+                }
+            }
+            bool stolen = false;
+            if (!request) {
+                request = steal(w);
+                stolen = request.has_value();
+            }
+            if (!request) {
+                std::unique_lock<std::mutex> lock{self.mutex};
+                self.busy = false;
+                if (self.requests.empty()) {
+                    if (stopping.load()) {
+                        if (all_queues_empty()) {
+                            return;
+                        }
+                        // the remaining requests may be below the steal threshold, their workers finish them
+                        lock.unlock();
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    self.idle = true;
+                    // a request queued before idle was set is seen here, any later one notifies this worker
+                    if (!stealable(w)) {
+                        self.wake.wait(lock);
+                    }
+                    self.idle = false;
+                }
+                continue;
+            }
+            const DecodingContext<T>& dc = keys[request->key_id];
+            // counted before the result is delivered, so the statistics include every finished request
+            self.executed.fetch_add(1);
+            if (stolen) {
+                self.stolen.fetch_add(1);
+            }
+            try {
+                request->promise.set_value(dc.decode_with_report(request->message, request->num_iterations, request->policy));
+            } catch (...) {
+                request->promise.set_exception(std::current_exception());
+            }
+        }
+    }
+
+    /**
+     * @brief Take the most recently queued request of another worker, trying the own group first.
+     */
+    auto steal(size_t thief) -> std::optional<Request> {
+        size_t group_begin = thief / options.group_size * options.group_size;
+        size_t group_end = std::min(num_workers, group_begin + options.group_size);
+        for (size_t round = 0; round < 2; ++round) {
+            for (size_t offset = 1; offset < num_workers; ++offset) {
+                size_t victim = (thief + offset) % num_workers;
+                bool in_group = victim >= group_begin && victim < group_end;
+                if (in_group != (round == 0) || workers[victim].queued.load() < options.steal_threshold) {
+                    continue;
+                }
+                std::optional<Request> request;
+                {
+                    std::lock_guard<std::mutex> lock{workers[victim].mutex};
+                    if (workers[victim].requests.size() >= options.steal_threshold) {
+                        request.emplace(std::move(workers[victim].requests.back()));
+                        workers[victim].requests.pop_back();
+                        workers[victim].queued.store(workers[victim].requests.size());
+                    }
+                }
+                if (request) {
+                    // a worker never holds two locks, so thieves cannot deadlock
+                    std::lock_guard<std::mutex> lock{workers[thief].mutex};
+                    workers[thief].busy = true;
+                    return request;
+                }
+            }
+        }
+        return {};
+    }
+
+    /**
+     * @brief Wake an idle worker to steal from the given busy worker, preferring its group.
+     */
+    auto wake_idle_worker(size_t busy_worker) -> void {
+        size_t group_begin = busy_worker / options.group_size * options.group_size;
+        size_t group_end = std::min(num_workers, group_begin + options.group_size);
+        for (size_t round = 0; round < 2; ++round) {
+            for (size_t offset = 1; offset < num_workers; ++offset) {
+                size_t w = (busy_worker + offset) % num_workers;
+                bool in_group = w >= group_begin && w < group_end;
+                if (in_group != (round == 0)) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock{workers[w].mutex};
+                if (workers[w].idle) {
+                    workers[w].wake.notify_one();
+                    return;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Whether another worker holds enough requests to steal from.
+     */
+    auto stealable(size_t thief) const -> bool {
+        for (size_t w = 0; w < num_workers; ++w) {
+            if (w != thief && workers[w].queued.load() >= options.steal_threshold) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto all_queues_empty() const -> bool {
+        for (size_t w = 0; w < num_workers; ++w) {
+            if (workers[w].queued.load() != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<DecodingContext<T>> keys;
+    DecodePoolOptions options;
+    size_t num_workers;
+    std::unique_ptr<Worker[]> workers;
+    std::vector<std::thread> threads;
+    std::vector<int> cpus;   ///< The CPUs the workers are pinned to, empty if they are not pinned.
+    std::atomic<bool> stopping;
+};
+
+#endif //MDPC_GF4_DECODE_POOL_H
@@ -0,0 +1,236 @@
+#ifndef MDPC_GF4_DFR_SWEEP_H
+#define MDPC_GF4_DFR_SWEEP_H
+
+#include <vector>
+#include <optional>
+#include <tuple>
+#include <mutex>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include "contexts.h"
+#include "random.h"
+#include "stagnation.h"
+#include "vector_utils.h"
+
+/**
+ * @brief A configuration whose decoding failure rate (DFR) is estimated by run_dfr_sweep.
+ */
+struct SweepPoint {
+    size_t block_size;
+    size_t block_weight;
+    size_t error_weight;      ///< The hamming weight of the error vectors added to the codewords.
+    size_t num_iterations;    ///< The iteration budget of the decoder.
+};
+
+/**
+ * @brief When to stop estimating the DFR of a sweep point.
+ *
+ * The DFR of a point is estimated by the Wilson score interval. The interval is evaluated only at looks,
+ * after min_trials, 2 * min_trials, 4 * min_trials, ... trials, and the k-th look (k = 0, 1, ...) uses
+ * the confidence 1 - (1 - confidence) / 2^(k + 1). The error probabilities of the looks sum up to 1 - confidence,
+ * so the final interval holds with the requested confidence even though the stopping depends on the data.
+ * A point stops at the first look at which
+ *  + the half-width of the interval is at most relative_precision times the estimate, or
+ *  + the upper bound of the interval is below dfr_floor, i.e. the DFR is too small to matter,
+ * or when max_trials trials were done.
+ */
+struct SweepTarget {
+    double relative_precision = 0.2;
+    double confidence = 0.95;
+    double dfr_floor = 0.0;
+    size_t min_trials = 100;
+    size_t max_trials = 1000000;
+    size_t batch_size = 16;   ///< The number of trials a thread runs before reporting them.
+};
+
+/**
+ * @brief The reason why a sweep point stopped.
+ */
+enum class SweepStopReason {
+    PrecisionReached,   ///< The interval is narrow enough relative to the estimate.
+    BelowFloor,         ///< The upper bound of the interval is below SweepTarget::dfr_floor.
+    TrialBudget         ///< SweepTarget::max_trials trials were done.
+};
+
+/**
+ * @brief The estimated DFR of a sweep point.
+ */
+struct SweepEstimate {
+    SweepPoint point;
+    size_t trials = 0;
+    size_t failures = 0;
+    double dfr = 0.0;     ///< failures / trials
+    double lower = 0.0;   ///< Lower bound of the confidence interval.
+    double upper = 1.0;   ///< Upper bound of the confidence interval.
+    SweepStopReason reason = SweepStopReason::TrialBudget;
+};
+
+/**
+ * @brief Get the two-sided critical value z of the standard normal distribution, i.e. P(|Z| > z) = alpha.
+ *
+ * @param alpha The error probability, 0 < alpha < 1.
+ * @return The critical value.
+ */
+inline auto normal_critical_value(double alpha) -> double {
+    double low = 0.0;
+    double high = 40.0;
+    for (size_t i = 0; i < 100; ++i) {
+        double mid = (low + high) / 2;
+        if (std::erfc(mid / std::sqrt(2.0)) > alpha) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return (low + high) / 2;
+}
+
+/**
+ * @brief Compute the Wilson score interval of a failure rate.
+ *
+ * @param trials The number of trials, must be nonzero.
+ * @param failures The number of failures.
+ * @param z The critical value, see normal_critical_value.
+ * @return The lower and upper bound.
+ */
+inline auto wilson_interval(size_t trials, size_t failures, double z) -> std::tuple<double, double> {
+    double n = (double)trials;
+    double p = (double)failures / n;
+    double denominator = 1 + z * z / n;
+    double center = (p + z * z / (2 * n)) / denominator;
+    double half_width = z / denominator * std::sqrt(p * (1 - p) / n + z * z / (4 * n * n));
+    return std::make_tuple(std::max(0.0, center - half_width), std::min(1.0, center + half_width));
+}
+
+/**
+ * @brief Estimate the DFR of several configurations, spending trials only where the estimate has not converged.
+ *
+ * A trial encodes a random message, adds a random error vector of the given weight and checks that the decoder
+ * finds exactly that error vector. The threads repeatedly take a batch of trials of the running point with the fewest
+ * trials so far, so the points share the threads evenly and the threads move to the remaining points
+ * as soon as a point stops (see SweepTarget). Every thread generates its own keys for every point it works on.
+ *
+ * @tparam T Finite field to be used.
+ * @param points The configurations.
+ * @param target The stopping rules.
+ * @param num_threads The number of threads, 0 uses the hardware concurrency.
+ * @param policy The early failure detection of the decoder.
+ * @return The estimates in the order of the points.
+ */
+template<typename T>
+auto run_dfr_sweep(const std::vector<SweepPoint>& points, const SweepTarget& target, size_t num_threads = 0,
+                   const StagnationPolicy& policy = StagnationPolicy{}) -> std::vector<SweepEstimate> {
+    struct PointState {
+        size_t scheduled = 0;
+        size_t next_look = 0;
+        size_t looks = 0;
+        bool running = true;
+    };
+    std::vector<SweepEstimate> estimates(points.size());
+    std::vector<PointState> states(points.size());
+    for (size_t p = 0; p < points.size(); ++p) {
+        estimates[p].point = points[p];
+        states[p].next_look = std::max<size_t>(1, target.min_trials);
+    }
+    std::mutex mutex;
+
+    // called with the mutex held after the results of a batch were added
+    auto evaluate = [&](size_t p) {
+        SweepEstimate& estimate = estimates[p];
+        PointState& state = states[p];
+        if (estimate.trials < state.next_look && estimate.trials < target.max_trials) {
+            return;
+        }
+        double alpha = (1 - target.confidence) / std::ldexp(1.0, (int)state.looks + 1);
+        auto [lower, upper] = wilson_interval(estimate.trials, estimate.failures, normal_critical_value(alpha));
+        estimate.dfr = (double)estimate.failures / (double)estimate.trials;
+        estimate.lower = lower;
+        estimate.upper = upper;
+        state.looks += 1;
+        state.next_look *= 2;
+        if (estimate.failures != 0 && (upper - lower) / 2 <= target.relative_precision * estimate.dfr) {
+            estimate.reason = SweepStopReason::PrecisionReached;
+            state.running = false;
+        } else if (upper < target.dfr_floor) {
+            estimate.reason = SweepStopReason::BelowFloor;
+            state.running = false;
+        } else if (estimate.trials >= target.max_trials) {
+            estimate.reason = SweepStopReason::TrialBudget;
+            state.running = false;
+        }
+    };
+
+    auto work = [&]() {
+        std::vector<std::optional<std::tuple<EncodingContext<T>, DecodingContext<T>>>> keys(points.size());
+        while (true) {
+            size_t p = points.size();
+            size_t batch = 0;
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                for (size_t q = 0; q < points.size(); ++q) {
+                    if (states[q].running && states[q].scheduled < target.max_trials &&
+                        (p == points.size() || states[q].scheduled < states[p].scheduled)) {
+                        p = q;
+                    }
+                }
+                if (p == points.size()) {
+                    return;
+                }
+                batch = std::min(std::max<size_t>(1, target.batch_size), target.max_trials - states[p].scheduled);
+                states[p].scheduled += batch;
+            }
+
+            const SweepPoint& point = points[p];
+            if (!keys[p]) {
+                keys[p] = generate_contexts_over_GF2N<T>(point.block_size, point.block_weight);
+            }
+            auto& [ec, dc] = *keys[p];
+            size_t failures = 0;
+            for (size_t i = 0; i < batch; ++i) {
+                std::vector<T> message = Random::random_vector_over_GF2N<T>(point.block_size);
+                std::vector<T> error_vector = Random::random_weighted_vector_over_GF2N<T>(2 * point.block_size, point.error_weight);
+                std::vector<T> encoded = ec.encode(message);
+                for (size_t j = 0; j < encoded.size(); ++j) {
+                    encoded[j] += error_vector[j];
+                }
+                auto result = dc.decode_with_report(encoded, point.num_iterations, policy);
+                if (!result.error_vector) {
+                    ++failures;
+                    continue;
+                }
+                // another error vector with the same syndrome is a failure too
+                for (size_t j = 0; j < error_vector.size(); ++j) {
+                    error_vector[j] += result.error_vector.value()[j];
+                }
+                if (!is_vector_zero(error_vector)) {
+                    ++failures;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock{mutex};
+            if (!states[p].running) {
+                // the point stopped while this batch was running, the reported interval is kept as it was
+                continue;
+            }
+            estimates[p].trials += batch;
+            estimates[p].failures += failures;
+            evaluate(p);
+        }
+    };
+
+    if (num_threads == 0) {
+        num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    return estimates;
+}
+
+#endif //MDPC_GF4_DFR_SWEEP_H
@@ -0,0 +1,626 @@
+#ifndef MDPC_GF4_FACTORIZATION_H
+#define MDPC_GF4_FACTORIZATION_H
+
+#include <vector>
+#include <tuple>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <optional>
+#include <system_error>
+#include <cstdint>
+#include "polynomial.h"
+#include "bitsliced_polynomial.h"
+#include "random.h"
+#include "gf4.h"
+#include "field_traits.h"
+#include "custom_exceptions.h"
+
+/*
+ * Factorization of polynomials over finite fields GF(q), q = 2^k:
+ *  1. squarefree factorization,
+ *  2. distinct-degree factorization (DDF), which splits a squarefree polynomial into products of irreducible factors of equal degree,
+ *  3. equal-degree factorization (EDF, Cantor-Zassenhaus), which splits such a product by gcd with random trace polynomials.
+ *
+ * The field T must additionally provide get_value() returning the integer representation used by its conversion constructor.
+ */
+
+/**
+ * @brief Get the size q of the finite field T.
+ */
+template<typename T>
+auto field_size() -> size_t {
+    return T::get_max_value() + 1;
+}
+
+/**
+ * @brief Get k such that the finite field T is GF(2^k).
+ *
+ * Taken from FieldTraits if it is known at compile time.
+ */
+template<typename T>
+auto field_bits() -> size_t {
+    if constexpr (FieldTraits<T>::bits != 0) {
+        return FieldTraits<T>::bits;
+    }
+    size_t k = 0;
+    while ((size_t{1} << k) < field_size<T>()) {
+        ++k;
+    }
+    return k;
+}
+
+template<typename T>
+auto polynomials_equal(const PolynomialGF2N<T>& a, const PolynomialGF2N<T>& b) -> bool {
+    return (a + b).is_zero();
+}
+
+/**
+ * @brief Divide the polynomial by its leading coefficient.
+ *
+ * @param f A nonzero polynomial.
+ * @return The monic polynomial associated to f.
+ */
+template<typename T>
+auto make_monic(const PolynomialGF2N<T>& f) -> PolynomialGF2N<T> {
+    if (f.is_zero()) {
+        throw DivisionByZero{};
+    }
+    return f * (T{1} / f.get_coefficient(f.get_degree()));
+}
+
+/**
+ * @brief Calculate the monic greatest common divisor, by the remainder sequence of gcd_remainder.
+ *
+ * @return Monic gcd of a and b, zero if both are zero.
+ */
+template<typename T>
+auto polynomial_gcd(const PolynomialGF2N<T>& a, const PolynomialGF2N<T>& b) -> PolynomialGF2N<T> {
+    PolynomialGF2N<T> g = (a.get_degree() < b.get_degree()) ? gcd_remainder(b, a): gcd_remainder(a, b);
+    return g.is_zero() ? g : make_monic(g);
+}
+
+/**
+ * @brief Calculate base^exponent mod modulus by square and multiply.
+ */
+template<typename T>
+auto pow_mod(const PolynomialGF2N<T>& base, size_t exponent, const PolynomialGF2N<T>& modulus) -> PolynomialGF2N<T> {
+    PolynomialGF2N<T> out = PolynomialGF2N<T>::make_one() % modulus;
+    PolynomialGF2N<T> b = base % modulus;
+    while (exponent != 0) {
+        if (exponent & 1u) {
+            out = (out * b) % modulus;
+        }
+        b = (b * b) % modulus;
+        exponent >>= 1u;
+    }
+    return out;
+}
+
+/**
+ * @brief Repeatedly square a polynomial modulo f.
+ *
+ * Calculates h^(2^i) mod f for i = 1, ..., count and returns either the last power or the sum of h and all the powers.
+ * With count = k*d - 1 and sum = true, this is the trace of h from GF(q^d) to GF(2) used by the equal-degree factorization.
+ * With count = k and sum = false, this is the Frobenius map h^q mod f used by the distinct-degree factorization.
+ *
+ * @param h A polynomial of degree less than deg(f).
+ * @param f The modulus.
+ * @param count Number of squarings.
+ * @param sum Whether to sum all the powers.
+ * @return h^(2^count) mod f, or h + h^2 + ... + h^(2^count) mod f.
+ */
+template<typename T>
+auto repeated_squaring(const PolynomialGF2N<T>& h, const PolynomialGF2N<T>& f, size_t count, bool sum) -> PolynomialGF2N<T> {
+    PolynomialGF2N<T> power = h % f;
+    PolynomialGF2N<T> acc = power;
+    for (size_t i = 0; i < count; ++i) {
+        power = (power * power) % f;
+        if (sum) {
+            acc += power;
+        }
+    }
+    return sum ? acc : power;
+}
+
+/**
+ * @brief Repeatedly square a polynomial over GF(4) modulo f, on bit-sliced coefficients.
+ *
+ * Same as the generic repeated_squaring. In characteristic 2, squaring maps c_i x^i to c_i^2 x^(2i), so it only spreads
+ * the bits of both bit-planes and maps c -> c^2, which is (lo, hi) -> (lo ^ hi, hi).
+ * The reduction modulo the monic f subtracts c * x^s * f for the leading coefficients c; the 64 possible bit shifts
+ * of f are precomputed, so each subtraction is a word-aligned XOR of deg(f)/64 words per plane.
+ */
+inline auto repeated_squaring(const PolynomialGF2N<GF4>& h, const PolynomialGF2N<GF4>& f, size_t count, bool sum) -> PolynomialGF2N<GF4> {
+    PolynomialGF2N<GF4> monic = make_monic(f);
+    size_t m = monic.get_degree();
+    if (m == 0) {
+        return PolynomialGF2N<GF4>::make_zero();
+    }
+    size_t words = (2 * m + 63) / 64 + 1;
+    size_t f_words = (m + 1 + 63) / 64 + 1;
+
+    // shifted[s] holds both planes of x^s * f, s = 0..63
+    std::vector<std::vector<uint64_t>> shifted_lo(64, std::vector<uint64_t>(f_words));
+    std::vector<std::vector<uint64_t>> shifted_hi(64, std::vector<uint64_t>(f_words));
+    for (size_t s = 0; s < 64; ++s) {
+        for (size_t i = 0; i <= m; ++i) {
+            uint8_t c = monic.get_coefficient(i).get_value();
+            size_t bit = i + s;
+            shifted_lo[s][bit / 64] |= (uint64_t)(c & 1u) << (bit % 64);
+            shifted_hi[s][bit / 64] |= (uint64_t)((c >> 1) & 1u) << (bit % 64);
+        }
+    }
+
+    std::vector<uint64_t> lo(words);
+    std::vector<uint64_t> hi(words);
+    PolynomialGF2N<GF4> reduced = h % monic;
+    for (size_t i = 0; i <= reduced.get_degree(); ++i) {
+        uint8_t c = reduced.get_coefficient(i).get_value();
+        lo[i / 64] |= (uint64_t)(c & 1u) << (i % 64);
+        hi[i / 64] |= (uint64_t)((c >> 1) & 1u) << (i % 64);
+    }
+    std::vector<uint64_t> acc_lo = lo;
+    std::vector<uint64_t> acc_hi = hi;
+
+    auto spread = [](uint32_t x) -> uint64_t {
+        uint64_t v = x;
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+        v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+        v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | (v << 2)) & 0x3333333333333333ull;
+        v = (v | (v << 1)) & 0x5555555555555555ull;
+        return v;
+    };
+    size_t used_words = (m + 63) / 64;
+    std::vector<uint64_t> sq_lo(words);
+    std::vector<uint64_t> sq_hi(words);
+    for (size_t step = 0; step < count; ++step) {
+        // square
+        std::fill(sq_lo.begin(), sq_lo.end(), 0);
+        std::fill(sq_hi.begin(), sq_hi.end(), 0);
+        for (size_t k = 0; k < used_words; ++k) {
+            uint64_t l = lo[k] ^ hi[k];
+            uint64_t u = hi[k];
+            sq_lo[2 * k] = spread((uint32_t)l);
+            sq_lo[2 * k + 1] = spread((uint32_t)(l >> 32));
+            sq_hi[2 * k] = spread((uint32_t)u);
+            sq_hi[2 * k + 1] = spread((uint32_t)(u >> 32));
+        }
+        // reduce from the degree 2m - 2 down to m
+        for (size_t deg = 2 * m - 2; deg >= m; --deg) {
+            uint64_t bit_lo = (sq_lo[deg / 64] >> (deg % 64)) & 1u;
+            uint64_t bit_hi = (sq_hi[deg / 64] >> (deg % 64)) & 1u;
+            uint8_t c = (uint8_t)(bit_lo | (bit_hi << 1));
+            if (c != 0) {
+                size_t shift = deg - m;
+                const auto& f_lo = shifted_lo[shift % 64];
+                const auto& f_hi = shifted_hi[shift % 64];
+                size_t base = shift / 64;
+                size_t end = std::min(f_words, words - base);
+                switch (c) {
+                    case 1:
+                        for (size_t k = 0; k < end; ++k) {
+                            sq_lo[base + k] ^= f_lo[k];
+                            sq_hi[base + k] ^= f_hi[k];
+                        }
+                        break;
+                    case 2:
+                        for (size_t k = 0; k < end; ++k) {
+                            sq_lo[base + k] ^= f_hi[k];
+                            sq_hi[base + k] ^= f_lo[k] ^ f_hi[k];
+                        }
+                        break;
+                    default:  // c == 3
+                        for (size_t k = 0; k < end; ++k) {
+                            sq_lo[base + k] ^= f_lo[k] ^ f_hi[k];
+                            sq_hi[base + k] ^= f_lo[k];
+                        }
+                        break;
+                }
+            }
+            if (deg == m) {
+                break;
+            }
+        }
+        uint64_t last_mask = (m % 64 == 0) ? ~uint64_t{0} : (uint64_t{1} << (m % 64)) - 1;
+        for (size_t k = 0; k < words; ++k) {
+            uint64_t mask = (k + 1 < used_words) ? ~uint64_t{0} : (k + 1 == used_words ? last_mask : 0);
+            lo[k] = sq_lo[k] & mask;
+            hi[k] = sq_hi[k] & mask;
+            if (sum) {
+                acc_lo[k] ^= lo[k];
+                acc_hi[k] ^= hi[k];
+            }
+        }
+    }
+
+    const auto& out_lo = sum ? acc_lo : lo;
+    const auto& out_hi = sum ? acc_hi : hi;
+    std::vector<GF4> coefficients;
+    coefficients.resize(m);
+    for (size_t i = 0; i < m; ++i) {
+        size_t b0 = (out_lo[i / 64] >> (i % 64)) & 1u;
+        size_t b1 = (out_hi[i / 64] >> (i % 64)) & 1u;
+        coefficients[i] = GF4{b0 | (b1 << 1)};
+    }
+    return PolynomialGF2N<GF4>{coefficients};
+}
+
+/**
+ * @brief Calculate the 2nd root of a polynomial whose derivative is zero, i.e. which only has even powers.
+ *
+ * In GF(2^k), the square root of c is c^(2^(k-1)).
+ */
+template<typename T>
+auto polynomial_square_root(const PolynomialGF2N<T>& f) -> PolynomialGF2N<T> {
+    PolynomialGF2N<T> out;
+    for (size_t deg = 0; deg <= f.get_degree(); deg += 2) {
+        T c = f.get_coefficient(deg);
+        for (size_t i = 1; i < field_bits<T>(); ++i) {
+            c = c * c;
+        }
+        out.set_coefficient(deg / 2, c);
+    }
+    return out;
+}
+
+/**
+ * @brief Split a monic polynomial into squarefree factors.
+ *
+ * @param f A monic polynomial of positive degree.
+ * @return Pairwise coprime squarefree polynomials g_i with multiplicities e_i such that f = prod g_i^e_i.
+ */
+template<typename T>
+auto squarefree_factorization(const PolynomialGF2N<T>& f) -> std::vector<std::tuple<PolynomialGF2N<T>, size_t>> {
+    std::vector<std::tuple<PolynomialGF2N<T>, size_t>> out;
+    PolynomialGF2N<T> c = polynomial_gcd(f, f.derivative());
+    PolynomialGF2N<T> w = f / c;
+    size_t i = 1;
+    while (w.get_degree() > 0) {
+        PolynomialGF2N<T> y = polynomial_gcd(w, c);
+        PolynomialGF2N<T> factor = w / y;
+        if (factor.get_degree() > 0) {
+            out.emplace_back(make_monic(factor), i);
+        }
+        w = y;
+        c = c / y;
+        ++i;
+    }
+    if (c.get_degree() > 0) {
+        for (auto& [g, e]: squarefree_factorization(make_monic(polynomial_square_root(c)))) {
+            out.emplace_back(g, 2 * e);
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Split a monic squarefree polynomial into products of irreducible factors of the same degree.
+ *
+ * The product of all irreducible factors of degree i is gcd(f, x^(q^i) - x).
+ *
+ * @param f A monic squarefree polynomial.
+ * @return Pairs (g_d, d) where g_d is the product of all irreducible factors of f of degree d.
+ */
+template<typename T>
+auto distinct_degree_factorization(const PolynomialGF2N<T>& f) -> std::vector<std::tuple<PolynomialGF2N<T>, size_t>> {
+    std::vector<std::tuple<PolynomialGF2N<T>, size_t>> out;
+    PolynomialGF2N<T> x;
+    x.set_coefficient(1, T{1});
+    PolynomialGF2N<T> rest = f;
+    PolynomialGF2N<T> h = x % rest;
+    for (size_t i = 1; rest.get_degree() >= 2 * i; ++i) {
+        h = repeated_squaring(h, rest, field_bits<T>(), false);
+        PolynomialGF2N<T> g = polynomial_gcd(rest, h + x);
+        if (g.get_degree() > 0) {
+            out.emplace_back(g, i);
+            rest = rest / g;
+            h = h % rest;
+        }
+    }
+    if (rest.get_degree() > 0) {
+        out.emplace_back(make_monic(rest), rest.get_degree());
+    }
+    return out;
+}
+
+/*
+ * The number of consecutive degrees whose gcds the GF(4) distinct-degree factorization takes at once.
+ */
+#ifndef MDPC_GF4_DDF_BLOCK_SIZE
+#define MDPC_GF4_DDF_BLOCK_SIZE 32
+#endif
+
+/**
+ * @brief Split a monic squarefree polynomial over GF(4) into products of irreducible factors of the same degree.
+ *
+ * Same as the generic distinct_degree_factorization, but the powers h_i = x^(4^i) mod rest are computed
+ * with BitslicedGF4Modulus and the gcds are taken in blocks of MDPC_GF4_DDF_BLOCK_SIZE degrees
+ * (the blocking of the baby-step giant-step algorithm): one gcd of rest with prod_i (h_i - x) mod rest
+ * finds all factors with degrees in the block, and only a nontrivial block gcd is split degree by degree.
+ * A product mod rest is much cheaper than a gcd, so the gcds almost vanish from the running time.
+ */
+inline auto distinct_degree_factorization(const PolynomialGF2N<GF4>& f) -> std::vector<std::tuple<PolynomialGF2N<GF4>, size_t>> {
+    std::vector<std::tuple<PolynomialGF2N<GF4>, size_t>> out;
+    PolynomialGF2N<GF4> x;
+    x.set_coefficient(1, GF4{1});
+    PolynomialGF2N<GF4> rest = f;
+    PolynomialGF2N<GF4> h = x % rest;
+    size_t done = 0;
+    while (rest.get_degree() >= 2 * (done + 1)) {
+        BitslicedGF4Modulus modulus{rest};
+        BitslicedGF4Modulus::Residue power = modulus.pack(h);
+        BitslicedGF4Modulus::Residue x_residue = modulus.pack(x);
+        BitslicedGF4Modulus::Residue product = modulus.pack(PolynomialGF2N<GF4>::make_one());
+        std::vector<BitslicedGF4Modulus::Residue> powers;
+        // the modulus is kept while no factor is found
+        bool found = false;
+        while (!found && rest.get_degree() >= 2 * (done + 1)) {
+            size_t block_end = std::min(done + MDPC_GF4_DDF_BLOCK_SIZE, rest.get_degree() / 2);
+            powers.clear();
+            for (size_t i = done + 1; i <= block_end; ++i) {
+                for (size_t k = 0; k < field_bits<GF4>(); ++k) {
+                    power = modulus.square(power);
+                }
+                powers.push_back(power);
+                BitslicedGF4Modulus::Residue difference = power;
+                for (size_t w = 0; w < difference.lo.size(); ++w) {
+                    difference.lo[w] ^= x_residue.lo[w];
+                    difference.hi[w] ^= x_residue.hi[w];
+                }
+                product = modulus.multiply(product, difference);
+            }
+            PolynomialGF2N<GF4> g = polynomial_gcd(rest, modulus.unpack(product));
+            if (g.get_degree() > 0) {
+                found = true;
+                // factors of the degrees below done + i were removed from g before it is split at done + i
+                for (size_t i = 0; i < powers.size() && g.get_degree() > 0; ++i) {
+                    PolynomialGF2N<GF4> factor = polynomial_gcd(g, modulus.unpack(powers[i]) + x);
+                    if (factor.get_degree() > 0) {
+                        out.emplace_back(factor, done + i + 1);
+                        g = std::get<0>(bitsliced_div_rem(g, factor));
+                        rest = std::get<0>(bitsliced_div_rem(rest, factor));
+                    }
+                }
+                h = std::get<1>(bitsliced_div_rem(modulus.unpack(power), rest));
+            }
+            product = modulus.pack(PolynomialGF2N<GF4>::make_one());
+            done = block_end;
+        }
+    }
+    if (rest.get_degree() > 0) {
+        out.emplace_back(make_monic(rest), rest.get_degree());
+    }
+    return out;
+}
+
+/**
+ * @brief Split a monic product of distinct irreducible factors of degree d (Cantor-Zassenhaus).
+ *
+ * For a random a, the trace of a from GF(q^d) to GF(2) is 0 or 1 modulo each irreducible factor,
+ * each with probability 1/2, so gcd(f, trace(a)) is a proper factor with probability at least 1/2 if f is reducible.
+ *
+ * @param f A monic product of distinct irreducible polynomials of degree d.
+ * @param d The degree of the irreducible factors.
+ * @return The irreducible factors.
+ */
+template<typename T>
+auto equal_degree_factorization(const PolynomialGF2N<T>& f, size_t d) -> std::vector<PolynomialGF2N<T>> {
+    if (f.get_degree() <= d) {
+        return {make_monic(f)};
+    }
+    while (true) {
+        PolynomialGF2N<T> a{Random::random_vector_over_GF2N<T>(f.get_degree())};
+        if (a.get_degree() == 0) {
+            continue;
+        }
+        PolynomialGF2N<T> t = repeated_squaring(a, f, field_bits<T>() * d - 1, true);
+        PolynomialGF2N<T> g = polynomial_gcd(f, t);
+        if (g.get_degree() > 0 && g.get_degree() < f.get_degree()) {
+            std::vector<PolynomialGF2N<T>> out = equal_degree_factorization(g, d);
+            std::vector<PolynomialGF2N<T>> other = equal_degree_factorization(f / g, d);
+            out.insert(out.end(), other.begin(), other.end());
+            return out;
+        }
+    }
+}
+
+/**
+ * @brief Sort factors by degree and then lexicographically by coefficients from the highest power.
+ */
+template<typename T>
+auto sort_factors(std::vector<std::tuple<PolynomialGF2N<T>, size_t>>& factors) -> void {
+    std::sort(factors.begin(), factors.end(), [](const auto& a, const auto& b) {
+        const auto& p = std::get<0>(a);
+        const auto& r = std::get<0>(b);
+        if (p.get_degree() != r.get_degree()) {
+            return p.get_degree() < r.get_degree();
+        }
+        for (size_t deg = p.get_degree() + 1; deg > 0; --deg) {
+            auto u = p.get_coefficient(deg - 1).get_value();
+            auto v = r.get_coefficient(deg - 1).get_value();
+            if (u != v) {
+                return u < v;
+            }
+        }
+        return false;
+    });
+}
+
+/**
+ * @brief Factor a polynomial into monic irreducible factors.
+ *
+ * The distinct-degree step raises x to the q-th power modulo the remaining polynomial up to deg(f)/2 times.
+ * Over GF(4) these powers use Karatsuba multiplication on bit-planes and the gcds are taken in blocks
+ * (see the GF(4) distinct_degree_factorization): a random polynomial of degree 10^4 takes about 8 s,
+ * or 1-2 s if compiled with PCLMULQDQ (e.g. -march=native). There is no fast modular composition,
+ * so every power is computed. For x^n - 1 use factor_x_n_minus_1, which skips that step.
+ *
+ * @param f A polynomial of positive degree.
+ * @return Pairs (g, e) of monic irreducible g and multiplicity e such that f = lead(f) * prod g^e, sorted by degree.
+ */
+template<typename T>
+auto factor(const PolynomialGF2N<T>& f) -> std::vector<std::tuple<PolynomialGF2N<T>, size_t>> {
+    std::vector<std::tuple<PolynomialGF2N<T>, size_t>> out;
+    for (auto& [g, e]: squarefree_factorization(make_monic(f))) {
+        for (auto& [h, d]: distinct_degree_factorization(g)) {
+            for (auto& irreducible: equal_degree_factorization(h, d)) {
+                out.emplace_back(irreducible, e);
+            }
+        }
+    }
+    sort_factors(out);
+    return out;
+}
+
+/**
+ * @brief Factor x^n - 1 using its cyclotomic structure.
+ *
+ * For n = 2^e * m with m odd, x^n - 1 = (x^m - 1)^(2^e) and x^m - 1 is the product of the cyclotomic polynomials Phi_d for d | m.
+ * All irreducible factors of Phi_d have the degree ord_d(q), so the distinct-degree step is skipped.
+ *
+ * @param n The exponent, positive.
+ * @return Pairs (g, e) of monic irreducible g and multiplicity e, sorted by degree.
+ */
+template<typename T>
+auto factor_x_n_minus_1(size_t n) -> std::vector<std::tuple<PolynomialGF2N<T>, size_t>> {
+    size_t multiplicity = 1;
+    size_t m = n;
+    while (m % 2 == 0) {
+        m /= 2;
+        multiplicity *= 2;
+    }
+    std::vector<size_t> divisors;
+    for (size_t d = 1; d <= m; ++d) {
+        if (m % d == 0) {
+            divisors.push_back(d);
+        }
+    }
+    std::vector<PolynomialGF2N<T>> cyclotomic;
+    std::vector<std::tuple<PolynomialGF2N<T>, size_t>> out;
+    for (size_t i = 0; i < divisors.size(); ++i) {
+        size_t d = divisors[i];
+        PolynomialGF2N<T> phi;
+        phi.set_coefficient(0, T{1});
+        phi.set_coefficient(d, T{1});
+        for (size_t j = 0; j < i; ++j) {
+            if (d % divisors[j] == 0) {
+                phi = phi / cyclotomic[j];
+            }
+        }
+        cyclotomic.push_back(phi);
+
+        size_t order = 1;
+        size_t power = field_size<T>() % d;
+        while (d > 1 && power != 1) {
+            power = (power * field_size<T>()) % d;
+            ++order;
+        }
+        for (auto& irreducible: equal_degree_factorization(phi, order)) {
+            out.emplace_back(irreducible, multiplicity);
+        }
+    }
+    sort_factors(out);
+    return out;
+}
+
+/**
+ * @brief Read a factorization of x^n - 1 written by factor_x_n_minus_1_cached.
+ *
+ * @param in Stream of the cache file.
+ * @param n The exponent.
+ * @return The factors, or nothing if a line is malformed, a factor is not monic of positive degree,
+ * or the degrees times multiplicities do not sum up to n.
+ */
+template<typename T>
+auto read_cached_factors(std::istream& in, size_t n) -> std::optional<std::vector<std::tuple<PolynomialGF2N<T>, size_t>>> {
+    std::vector<std::tuple<PolynomialGF2N<T>, size_t>> out;
+    size_t total_degree = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields{line};
+        size_t multiplicity;
+        char colon;
+        if (!(fields >> multiplicity >> colon) || colon != ':' || multiplicity == 0) {
+            return {};
+        }
+        std::vector<T> coefficients;
+        size_t value;
+        while (fields >> value) {
+            if (value >= field_size<T>()) {
+                return {};
+            }
+            coefficients.push_back(T{value});
+        }
+        if (!fields.eof() || coefficients.size() < 2 || coefficients.back().get_value() != 1) {
+            return {};
+        }
+        total_degree += (coefficients.size() - 1) * multiplicity;
+        out.emplace_back(PolynomialGF2N<T>{coefficients}, multiplicity);
+    }
+    if (in.bad() || total_degree != n) {
+        return {};
+    }
+    return out;
+}
+
+/**
+ * @brief Factor x^n - 1 and cache the result in a file.
+ *
+ * The factorization is stored in cache_directory/x^n-1_q<q>_n<n>.txt, one factor per line as
+ * "multiplicity: c_0 c_1 ... c_deg" with the integer representations of the coefficients.
+ * If the file exists and passes read_cached_factors, the factorization is read from it instead of being computed.
+ * Otherwise it is computed and the file is replaced: it is written to a temporary file in the same directory
+ * which is then renamed, so concurrent readers never see a partial file.
+ *
+ * @param n The exponent, positive.
+ * @param cache_directory Directory of the cache, created if it does not exist.
+ * @return Pairs (g, e) of monic irreducible g and multiplicity e, sorted by degree.
+ * @throws FileIOError if the cache file cannot be written.
+ */
+template<typename T>
+auto factor_x_n_minus_1_cached(size_t n, const std::string& cache_directory) -> std::vector<std::tuple<PolynomialGF2N<T>, size_t>> {
+    std::filesystem::path path = std::filesystem::path{cache_directory} /
+            ("x^n-1_q" + std::to_string(field_size<T>()) + "_n" + std::to_string(n) + ".txt");
+    {
+        std::ifstream in{path};
+        if (in) {
+            if (auto cached = read_cached_factors<T>(in, n)) {
+                return *cached;
+            }
+        }
+    }
+
+    auto out = factor_x_n_minus_1<T>(n);
+    std::filesystem::create_directories(cache_directory);
+    std::filesystem::path temporary = path;
+    temporary += ".tmp" + std::to_string(Random::integer<uint64_t>(UINT64_MAX));
+    {
+        std::ofstream file{temporary};
+        for (const auto& [g, e]: out) {
+            file << e << ":";
+            for (size_t deg = 0; deg <= g.get_degree(); ++deg) {
+                file << " " << (size_t)g.get_coefficient(deg).get_value();
+            }
+            file << "\n";
+        }
+        file.close();
+        if (!file) {
+            std::error_code ignored;
+            std::filesystem::remove(temporary, ignored);
+            throw FileIOError{};
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        throw FileIOError{};
+    }
+    return out;
+}
+
+#endif //MDPC_GF4_FACTORIZATION_H
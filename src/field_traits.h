@@ -0,0 +1,57 @@
+#ifndef MDPC_GF4_FIELD_TRAITS_H
+#define MDPC_GF4_FIELD_TRAITS_H
+
+#include <cstddef>
+#include "gf4.h"
+#include "gf4_extension.h"
+#include "packed_gf4.h"
+
+/**
+ * @brief Compile-time description of a finite field T for the generic algorithms.
+ *
+ * PolynomialGF2N, EncodingContext, DecodingContext and the other templates only need T to provide +, *, /, is_zero
+ * and nonzero_elements. Fields which provide more declare it by specializing FieldTraits, and the templates below
+ * test the flags with if constexpr, so a field without a specialization gets the element-wise code:
+ *  + bits: the number of bits of get_value(), 0 if it is only known at runtime (used by field_bits),
+ *  + has_bitsliced_layout: the classical euclidean algorithm runs on bit-sliced coefficients, which moves
+ *    the crossover to the half-gcd (used by default_half_gcd_threshold),
+ *  + has_packed_layout: PackedVector stores the elements at bits per element and multiplies by byte tables
+ *    (used by EncodingContext::encode and the key file),
+ *  + has_binary_image: BinaryImageDecoder decodes over the binary image of the code (used by ParameterSet).
+ *
+ * The traits describe the field only. The other GF(4) kernels, e.g. SparseCirculant<GF4> and the bit-sliced
+ * repeated squaring of the factorization, are selected by specializations and overloads for GF4.
+ *
+ * @tparam T Finite field.
+ */
+template<typename T>
+struct FieldTraits {
+    static constexpr size_t bits = 0;
+    static constexpr bool has_bitsliced_layout = false;
+    static constexpr bool has_packed_layout = false;
+    static constexpr bool has_binary_image = false;
+    using PackedVector = void;
+};
+
+template<>
+struct FieldTraits<GF4> {
+    static constexpr size_t bits = 2;
+    static constexpr bool has_bitsliced_layout = true;
+    static constexpr bool has_packed_layout = true;
+    static constexpr bool has_binary_image = true;
+    using PackedVector = PackedGF4Vector;
+};
+
+/*
+ * GF(4^K) stores K coefficients over GF(4) at two bits each, but has no kernels of its own.
+ */
+template<unsigned K>
+struct FieldTraits<GF4Extension<K>> {
+    static constexpr size_t bits = 2 * K;
+    static constexpr bool has_bitsliced_layout = false;
+    static constexpr bool has_packed_layout = false;
+    static constexpr bool has_binary_image = false;
+    using PackedVector = void;
+};
+
+#endif //MDPC_GF4_FIELD_TRAITS_H
@@ -0,0 +1,729 @@
+#ifndef MDPC_GF4_FILE_PIPELINE_H
+#define MDPC_GF4_FILE_PIPELINE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <array>
+#include <memory>
+#include <new>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "hybrid.h"
+#include "key_file.h"
+#include "custom_exceptions.h"
+
+#if defined(__linux__) && !defined(MDPC_GF4_DISABLE_IO_URING) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define MDPC_GF4_HAS_IO_URING
+#endif
+#endif
+
+static const char SEALED_FILE_MAGIC[8] = {'M', 'D', 'P', 'C', 'S', 'E', 'A', 'L'};
+static const uint32_t SEALED_FILE_VERSION = 1;
+static const size_t SEALED_FILE_HEADER_SIZE = 32;
+static const size_t FILE_PIPELINE_ALIGNMENT = 4096;
+
+/**
+ * @brief The I/O backend of the file pipeline.
+ */
+enum class FileIOBackend {
+    automatic,   ///< io_uring where the kernel allows it, the thread pool otherwise.
+    io_uring,    ///< Linux io_uring with registered buffers, FileIOError if it is not available.
+    threads      ///< pread and pwrite on a pool of threads.
+};
+
+/**
+ * @brief Parameters of the file pipeline.
+ */
+struct FilePipelineOptions {
+    size_t chunk_size = 1 << 20;               ///< The bytes per read or write.
+    size_t queue_depth = 16;                   ///< The number of chunk buffers, i.e. of reads and writes in flight.
+    FileIOBackend backend = FileIOBackend::automatic;
+    size_t num_io_threads = 4;                 ///< The number of threads of the pread/pwrite backend.
+};
+
+/**
+ * @brief The outcome of open_sealed_file.
+ */
+enum class OpenFileStatus {
+    success,                  ///< The payload is authentic and was written.
+    authentication_failure    ///< The tag does not match or the encapsulation was rejected, nothing was written to the output.
+};
+
+/**
+ * @brief A completed read or write of a chunk buffer.
+ */
+struct IOCompletion {
+    size_t buffer;   ///< The index of the buffer.
+    long result;     ///< The number of bytes transferred, or -errno.
+};
+
+/**
+ * @brief Page-aligned chunk buffers shared by the I/O queues.
+ */
+class ChunkBuffers {
+public:
+    ChunkBuffers(size_t count, size_t size) : size(size) {
+        for (size_t i = 0; i < count; ++i) {
+            void* memory = std::aligned_alloc(FILE_PIPELINE_ALIGNMENT, (size + FILE_PIPELINE_ALIGNMENT - 1) / FILE_PIPELINE_ALIGNMENT * FILE_PIPELINE_ALIGNMENT);
+            if (memory == nullptr) {
+                throw std::bad_alloc{};
+            }
+            buffers.emplace_back(static_cast<uint8_t*>(memory), &std::free);
+        }
+    }
+
+    [[nodiscard]] auto get(size_t i) const -> uint8_t* {
+        return buffers[i].get();
+    }
+
+    [[nodiscard]] auto count() const -> size_t {
+        return buffers.size();
+    }
+
+    [[nodiscard]] auto get_size() const -> size_t {
+        return size;
+    }
+
+private:
+    std::vector<std::unique_ptr<uint8_t, decltype(&std::free)>> buffers;
+    size_t size;
+};
+
+/**
+ * @brief An I/O queue which runs pread and pwrite on a pool of threads.
+ *
+ * This is the portable backend of the file pipeline and the fallback where io_uring is not available.
+ */
+class ThreadedIOQueue {
+public:
+    ThreadedIOQueue(size_t num_buffers, size_t buffer_size, size_t num_threads)
+            : buffers(num_buffers, buffer_size), stopping(false) {
+        for (size_t t = 0; t < std::max<size_t>(1, num_threads); ++t) {
+            threads.emplace_back([this]() { run(); });
+        }
+    }
+
+    ThreadedIOQueue(const ThreadedIOQueue&) = delete;
+    auto operator=(const ThreadedIOQueue&) -> ThreadedIOQueue& = delete;
+
+    /**
+     * @brief Finish the submitted operations and stop the threads.
+     */
+    ~ThreadedIOQueue() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+        submitted.notify_all();
+        for (auto& thread: threads) {
+            thread.join();
+        }
+    }
+
+    [[nodiscard]] auto buffer(size_t i) const -> uint8_t* {
+        return buffers.get(i);
+    }
+
+    auto submit_read(int fd, size_t buffer, size_t buffer_offset, size_t length, uint64_t file_offset) -> void {
+        submit(Operation{false, fd, buffer, buffer_offset, length, file_offset});
+    }
+
+    auto submit_write(int fd, size_t buffer, size_t buffer_offset, size_t length, uint64_t file_offset) -> void {
+        submit(Operation{true, fd, buffer, buffer_offset, length, file_offset});
+    }
+
+    /**
+     * @brief Wait for the next completed operation.
+     */
+    auto wait() -> IOCompletion {
+        std::unique_lock<std::mutex> lock{mutex};
+        completed.wait(lock, [this]() { return !completions.empty(); });
+        IOCompletion completion = completions.front();
+        completions.pop_front();
+        return completion;
+    }
+
+private:
+    struct Operation {
+        bool write;
+        int fd;
+        size_t buffer;
+        size_t buffer_offset;
+        size_t length;
+        uint64_t file_offset;
+    };
+
+    auto submit(const Operation& operation) -> void {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            operations.push_back(operation);
+        }
+        submitted.notify_one();
+    }
+
+    auto run() -> void {
+        while (true) {
+            Operation operation{};
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                submitted.wait(lock, [this]() { return stopping || !operations.empty(); });
+                if (operations.empty()) {
+                    return;
+                }
+                operation = operations.front();
+                operations.pop_front();
+            }
+            uint8_t* data = buffers.get(operation.buffer) + operation.buffer_offset;
+            ssize_t result;
+            do {
+                result = operation.write ? ::pwrite(operation.fd, data, operation.length, (off_t)operation.file_offset)
+                                         : ::pread(operation.fd, data, operation.length, (off_t)operation.file_offset);
+            } while (result < 0 && errno == EINTR);
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                completions.push_back(IOCompletion{operation.buffer, result < 0 ? -(long)errno : (long)result});
+            }
+            completed.notify_one();
+        }
+    }
+
+    ChunkBuffers buffers;
+    std::mutex mutex;
+    std::condition_variable submitted;
+    std::condition_variable completed;
+    std::deque<Operation> operations;
+    std::deque<IOCompletion> completions;
+    bool stopping;
+    std::vector<std::thread> threads;
+};
+
+#ifdef MDPC_GF4_HAS_IO_URING
+
+/**
+ * @brief An I/O queue on a Linux io_uring, driven by the raw system calls.
+ *
+ * The chunk buffers are registered with the ring, so the kernel maps them once instead of for every operation,
+ * and the reads and writes are IORING_OP_READ_FIXED and IORING_OP_WRITE_FIXED. If the registration is refused
+ * (e.g. by RLIMIT_MEMLOCK), the plain IORING_OP_READ and IORING_OP_WRITE are used. The submissions are collected
+ * in the ring and handed to the kernel by one io_uring_enter in wait.
+ */
+class IoUringQueue {
+public:
+    /**
+     * @brief Set up a ring for the given buffers.
+     *
+     * @return The queue, or nothing if the kernel does not provide io_uring or forbids it.
+     */
+    static auto create(size_t num_buffers, size_t buffer_size) -> std::unique_ptr<IoUringQueue> {
+        std::unique_ptr<IoUringQueue> queue{new IoUringQueue(num_buffers, buffer_size)};
+        if (!queue->setup()) {
+            return nullptr;
+        }
+        return queue;
+    }
+
+    IoUringQueue(const IoUringQueue&) = delete;
+    auto operator=(const IoUringQueue&) -> IoUringQueue& = delete;
+
+    /**
+     * @brief Wait for the operations in flight, which still use the buffers, and close the ring.
+     */
+    ~IoUringQueue() {
+        while (in_flight > 0 && enter(pending, 1, IORING_ENTER_GETEVENTS) >= 0) {
+            pending = 0;
+            while (pop_completion().has_value()) {
+            }
+        }
+        if (sqes != nullptr) {
+            ::munmap(sqes, sqes_size);
+        }
+        if (cq_ring != nullptr && cq_ring != sq_ring) {
+            ::munmap(cq_ring, cq_ring_size);
+        }
+        if (sq_ring != nullptr) {
+            ::munmap(sq_ring, sq_ring_size);
+        }
+        if (ring_fd >= 0) {
+            ::close(ring_fd);
+        }
+    }
+
+    [[nodiscard]] auto buffer(size_t i) const -> uint8_t* {
+        return buffers.get(i);
+    }
+
+    auto submit_read(int fd, size_t buffer, size_t buffer_offset, size_t length, uint64_t file_offset) -> void {
+        submit(registered ? IORING_OP_READ_FIXED : IORING_OP_READ, fd, buffer, buffer_offset, length, file_offset);
+    }
+
+    auto submit_write(int fd, size_t buffer, size_t buffer_offset, size_t length, uint64_t file_offset) -> void {
+        submit(registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, fd, buffer, buffer_offset, length, file_offset);
+    }
+
+    /**
+     * @brief Submit the queued operations and wait for the next completed one.
+     *
+     * @throws FileIOError if io_uring_enter fails.
+     */
+    auto wait() -> IOCompletion {
+        while (true) {
+            std::optional<IOCompletion> completion = pop_completion();
+            if (completion.has_value() && pending == 0) {
+                return *completion;
+            }
+            // new submissions are passed on even when a completion is ready, so the device is never left idle
+            int result = enter(pending, completion.has_value() ? 0 : 1, completion.has_value() ? 0 : IORING_ENTER_GETEVENTS);
+            if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                throw FileIOError{};
+            }
+            if (result > 0) {
+                pending -= std::min<unsigned>(pending, (unsigned)result);
+            }
+            if (completion.has_value()) {
+                return *completion;
+            }
+        }
+    }
+
+private:
+    IoUringQueue(size_t num_buffers, size_t buffer_size) : buffers(num_buffers, buffer_size) {}
+
+    auto setup() -> bool {
+        io_uring_params params{};
+        ring_fd = (int)::syscall(__NR_io_uring_setup, (unsigned)buffers.count(), &params);
+        if (ring_fd < 0) {
+            return false;
+        }
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+        sq_ring = map(sq_ring_size, IORING_OFF_SQ_RING);
+        cq_ring = single_mmap ? sq_ring : map(cq_ring_size, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(static_cast<void*>(map(sqes_size, IORING_OFF_SQES)));
+        if (sq_ring == nullptr || cq_ring == nullptr || sqes == nullptr) {
+            return false;
+        }
+        sq_tail = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+        cq_head = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+
+        std::vector<iovec> iovecs;
+        for (size_t i = 0; i < buffers.count(); ++i) {
+            iovecs.push_back(iovec{buffers.get(i), buffers.get_size()});
+        }
+        registered = ::syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS, iovecs.data(), (unsigned)iovecs.size()) == 0;
+        return true;
+    }
+
+    auto map(size_t size, off_t offset) -> uint8_t* {
+        void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+        return address == MAP_FAILED ? nullptr : static_cast<uint8_t*>(address);
+    }
+
+    auto enter(unsigned to_submit, unsigned min_complete, unsigned flags) -> int {
+        return (int)::syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0);
+    }
+
+    auto submit(uint8_t opcode, int fd, size_t buffer, size_t buffer_offset, size_t length, uint64_t file_offset) -> void {
+        // at most one operation per buffer is in flight, so the ring of buffers.count() entries never overflows
+        unsigned tail = *sq_tail;
+        unsigned index = tail & sq_mask;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.off = file_offset;
+        sqe.addr = (uint64_t)(uintptr_t)(buffers.get(buffer) + buffer_offset);
+        sqe.len = (uint32_t)length;
+        sqe.buf_index = (uint16_t)buffer;
+        sqe.user_data = buffer;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        ++pending;
+        ++in_flight;
+    }
+
+    auto pop_completion() -> std::optional<IOCompletion> {
+        unsigned head = *cq_head;
+        if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+            return {};
+        }
+        const io_uring_cqe& cqe = cqes[head & cq_mask];
+        IOCompletion completion{(size_t)cqe.user_data, (long)cqe.res};
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+        --in_flight;
+        return completion;
+    }
+
+    ChunkBuffers buffers;
+    int ring_fd = -1;
+    bool registered = false;
+    uint8_t* sq_ring = nullptr;
+    uint8_t* cq_ring = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+    size_t sqes_size = 0;
+    unsigned* sq_tail = nullptr;
+    unsigned sq_mask = 0;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+    unsigned pending = 0;
+    size_t in_flight = 0;
+};
+
+#endif
+
+/**
+ * @brief Stream a region of one file through a transformation into another file.
+ *
+ * The region is split into chunks of FilePipelineOptions::chunk_size bytes, and up to queue_depth chunk buffers
+ * are in flight at once: the reads are issued ahead, every chunk is transformed in order on the calling thread
+ * as soon as its read completes, and its write is issued right away, so the calling thread only waits
+ * when the device is slower than the transformation. Short reads and writes are continued.
+ *
+ * @throws FileIOError if a read or write fails or the input ends early.
+ * @param queue The I/O queue, ThreadedIOQueue or IoUringQueue, with at least one buffer of chunk_size bytes.
+ * @param num_buffers The number of buffers of the queue.
+ * @param chunk_size The bytes per chunk.
+ * @param in_fd The input file.
+ * @param in_offset The offset of the region in the input file.
+ * @param out_fd The output file.
+ * @param out_offset The offset of the region in the output file.
+ * @param length The length of the region.
+ * @param transform Called as transform(data, length) for every chunk in order, transforms it in place.
+ */
+template<typename Queue, typename Transform>
+auto pump_file(Queue& queue, size_t num_buffers, size_t chunk_size, int in_fd, uint64_t in_offset, int out_fd,
+               uint64_t out_offset, uint64_t length, Transform&& transform) -> void {
+    enum class State { free, reading, ready, writing };
+    struct Slot {
+        State state = State::free;
+        uint64_t chunk = 0;
+        size_t length = 0;
+        size_t done = 0;
+    };
+    uint64_t num_chunks = (length + chunk_size - 1) / chunk_size;
+    std::vector<Slot> slots(num_buffers);
+    std::vector<size_t> free_buffers;
+    for (size_t b = num_buffers; b > 0; --b) {
+        free_buffers.push_back(b - 1);
+    }
+    // the buffers holding the chunks between the next one to transform and the last one read, in chunk order
+    std::deque<size_t> order;
+    uint64_t next_read = 0;
+    uint64_t written = 0;
+    while (written < num_chunks) {
+        while (next_read < num_chunks && !free_buffers.empty()) {
+            size_t b = free_buffers.back();
+            free_buffers.pop_back();
+            Slot& slot = slots[b];
+            slot.state = State::reading;
+            slot.chunk = next_read;
+            slot.length = (size_t)std::min<uint64_t>(chunk_size, length - next_read * chunk_size);
+            slot.done = 0;
+            queue.submit_read(in_fd, b, 0, slot.length, in_offset + next_read * chunk_size);
+            order.push_back(b);
+            ++next_read;
+        }
+        while (!order.empty() && slots[order.front()].state == State::ready) {
+            size_t b = order.front();
+            order.pop_front();
+            Slot& slot = slots[b];
+            transform(queue.buffer(b), slot.length);
+            slot.state = State::writing;
+            slot.done = 0;
+            queue.submit_write(out_fd, b, 0, slot.length, out_offset + slot.chunk * chunk_size);
+        }
+        IOCompletion completion = queue.wait();
+        Slot& slot = slots[completion.buffer];
+        if (completion.result <= 0) {
+            // a read of 0 bytes means the input is shorter than expected
+            throw FileIOError{};
+        }
+        slot.done += (size_t)completion.result;
+        uint64_t position = slot.chunk * chunk_size + slot.done;
+        if (slot.done < slot.length) {
+            if (slot.state == State::reading) {
+                queue.submit_read(in_fd, completion.buffer, slot.done, slot.length - slot.done, in_offset + position);
+            } else {
+                queue.submit_write(out_fd, completion.buffer, slot.done, slot.length - slot.done, out_offset + position);
+            }
+        } else if (slot.state == State::reading) {
+            slot.state = State::ready;
+        } else {
+            slot.state = State::free;
+            free_buffers.push_back(completion.buffer);
+            ++written;
+        }
+    }
+}
+
+/**
+ * @brief Stream a region of one file through a transformation into another file on the selected I/O backend.
+ *
+ * See pump_file for the parameters.
+ *
+ * @throws FileIOError if an I/O operation fails, or if FileIOBackend::io_uring is requested but not available.
+ * @return The backend which was used, never FileIOBackend::automatic.
+ */
+template<typename Transform>
+auto run_file_pipeline(int in_fd, uint64_t in_offset, int out_fd, uint64_t out_offset, uint64_t length,
+                       const FilePipelineOptions& options, Transform&& transform) -> FileIOBackend {
+    size_t chunk_size = std::max<size_t>(1, options.chunk_size);
+    size_t num_buffers = (size_t)std::max<uint64_t>(1, std::min<uint64_t>(options.queue_depth, (length + chunk_size - 1) / chunk_size));
+    if (options.backend != FileIOBackend::threads) {
+#ifdef MDPC_GF4_HAS_IO_URING
+        std::unique_ptr<IoUringQueue> ring = IoUringQueue::create(num_buffers, chunk_size);
+        if (ring != nullptr) {
+            pump_file(*ring, num_buffers, chunk_size, in_fd, in_offset, out_fd, out_offset, length, transform);
+            return FileIOBackend::io_uring;
+        }
+#endif
+        if (options.backend == FileIOBackend::io_uring) {
+            throw FileIOError{};
+        }
+    }
+    ThreadedIOQueue queue{num_buffers, chunk_size, options.num_io_threads};
+    pump_file(queue, num_buffers, chunk_size, in_fd, in_offset, out_fd, out_offset, length, transform);
+    return FileIOBackend::threads;
+}
+
+/**
+ * @brief A file descriptor which is closed when it goes out of scope.
+ */
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd) : fd(fd) {}
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    auto operator=(const FileDescriptor&) -> FileDescriptor& = delete;
+
+    ~FileDescriptor() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    [[nodiscard]] auto get() const -> int {
+        return fd;
+    }
+
+private:
+    int fd;
+};
+
+/**
+ * @brief A file created next to a target path by mkstemp (O_EXCL, mode 0600), removed again unless renamed to the target.
+ */
+class TemporaryFile {
+public:
+    /**
+     * @throws FileIOError if the file cannot be created.
+     * @param target The path the file is renamed to by rename_to_target.
+     */
+    explicit TemporaryFile(const std::string& target) : target(target), path(target + ".XXXXXX"), fd(::mkstemp(path.data())) {
+        if (fd < 0) {
+            throw FileIOError{};
+        }
+    }
+
+    TemporaryFile(const TemporaryFile&) = delete;
+    auto operator=(const TemporaryFile&) -> TemporaryFile& = delete;
+
+    ~TemporaryFile() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        if (!renamed) {
+            ::unlink(path.c_str());
+        }
+    }
+
+    [[nodiscard]] auto get() const -> int {
+        return fd;
+    }
+
+    /**
+     * @brief Flush the file to the disk and rename it over the target path.
+     *
+     * @throws FileIOError if the file cannot be flushed or renamed.
+     */
+    auto rename_to_target() -> void {
+        if (::fsync(fd) != 0 || ::rename(path.c_str(), target.c_str()) != 0) {
+            throw FileIOError{};
+        }
+        renamed = true;
+    }
+
+private:
+    std::string target;
+    std::string path;
+    int fd;
+    bool renamed = false;
+};
+
+inline auto file_pipeline_size(int fd) -> uint64_t {
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        throw FileIOError{};
+    }
+    return (uint64_t)st.st_size;
+}
+
+inline auto file_pipeline_pread(int fd, uint8_t* data, size_t length, uint64_t offset) -> void {
+    if (::pread(fd, data, length, (off_t)offset) != (ssize_t)length) {
+        throw FileIOError{};
+    }
+}
+
+inline auto file_pipeline_pwrite(int fd, const uint8_t* data, size_t length, uint64_t offset) -> void {
+    if (::pwrite(fd, data, length, (off_t)offset) != (ssize_t)length) {
+        throw FileIOError{};
+    }
+}
+
+template<typename T>
+auto sealed_file_encapsulation_size(size_t block_size) -> size_t {
+    return (2 * block_size * field_bits<T>() + 63) / 64 * 8;
+}
+
+/**
+ * @brief Encrypt a file for the owner of the public key with HybridSealer.
+ *
+ * The sealed file consists of
+ *  + a header of 32 bytes: the magic "MDPCSEAL", the version, the bits per symbol, the block size
+ *    and the payload length, all little-endian, which is authenticated as additional data,
+ *  + the encapsulation ciphertext packed by pack_symbols, padded to a multiple of 8 bytes,
+ *  + the encrypted payload,
+ *  + the 16 byte tag.
+ * The payload is streamed through run_file_pipeline.
+ *
+ * @throws FileIOError if a file cannot be opened, read or written.
+ * @tparam T Finite field to be used.
+ * @param ec The encoding context of the receiver.
+ * @param error_weight The hamming weight of the error vector.
+ * @param in_path The file to encrypt.
+ * @param out_path The sealed file, created or replaced.
+ * @param options The parameters of the pipeline.
+ * @return The I/O backend which was used.
+ */
+template<typename T>
+auto seal_file(const EncodingContext<T>& ec, size_t error_weight, const std::string& in_path, const std::string& out_path,
+               const FilePipelineOptions& options = FilePipelineOptions{}) -> FileIOBackend {
+    FileDescriptor in{::open(in_path.c_str(), O_RDONLY)};
+    if (in.get() < 0) {
+        throw FileIOError{};
+    }
+    FileDescriptor out{::open(out_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)};
+    if (out.get() < 0) {
+        throw FileIOError{};
+    }
+    uint64_t length = file_pipeline_size(in.get());
+    size_t block_size = ec.get_block_size();
+
+    std::vector<uint8_t> header(SEALED_FILE_HEADER_SIZE + sealed_file_encapsulation_size<T>(block_size), 0);
+    std::memcpy(header.data(), SEALED_FILE_MAGIC, sizeof(SEALED_FILE_MAGIC));
+    key_file_store(header.data() + 8, SEALED_FILE_VERSION, 4);
+    key_file_store(header.data() + 12, field_bits<T>(), 4);
+    key_file_store(header.data() + 16, block_size, 8);
+    key_file_store(header.data() + 24, length, 8);
+    HybridSealer<T> sealer{ec, error_weight, std::vector<uint8_t>(header.begin(), header.begin() + SEALED_FILE_HEADER_SIZE)};
+    pack_symbols(sealer.get_encapsulation().ciphertext, field_bits<T>(), header.data() + SEALED_FILE_HEADER_SIZE);
+    file_pipeline_pwrite(out.get(), header.data(), header.size(), 0);
+
+    FileIOBackend backend = run_file_pipeline(in.get(), 0, out.get(), header.size(), length, options,
+                                              [&sealer](uint8_t* data, size_t count) { sealer.update(data, data, count); });
+    std::array<uint8_t, 16> tag = sealer.finalize();
+    file_pipeline_pwrite(out.get(), tag.data(), tag.size(), header.size() + length);
+    return backend;
+}
+
+/**
+ * @brief Decrypt a file sealed by seal_file.
+ *
+ * The plaintext is decrypted into a temporary file next to out_path (see TemporaryFile), which replaces out_path
+ * only after the tag is verified. On an authentication failure or an exception the temporary file is removed
+ * and out_path is left as it was, so no unauthenticated plaintext is ever found there.
+ *
+ * @throws FileIOError if a file cannot be opened, read or written.
+ * @throws InvalidSealedFile if the input is not a sealed file over T for this block size.
+ * @tparam T Finite field to be used.
+ * @param dc The decoding context of the receiver.
+ * @param in_path The sealed file.
+ * @param out_path The decrypted file, replaced or created readable by the owner only (mode 0600).
+ * @param error_weight The hamming weight of the error vector given to seal_file.
+ * @param num_iterations Number of iterations of decoding.
+ * @param options The parameters of the pipeline.
+ * @return Whether the payload is authentic, a rejected encapsulation shows as an authentication failure.
+ */
+template<typename T>
+auto open_sealed_file(const DecodingContext<T>& dc, const std::string& in_path, const std::string& out_path,
+                      size_t error_weight, size_t num_iterations,
+                      const FilePipelineOptions& options = FilePipelineOptions{}) -> OpenFileStatus {
+    FileDescriptor in{::open(in_path.c_str(), O_RDONLY)};
+    if (in.get() < 0) {
+        throw FileIOError{};
+    }
+    uint64_t file_size = file_pipeline_size(in.get());
+    size_t block_size = dc.get_block_size();
+    std::vector<uint8_t> header(SEALED_FILE_HEADER_SIZE + sealed_file_encapsulation_size<T>(block_size));
+    if (file_size < header.size() + 16) {
+        throw InvalidSealedFile{};
+    }
+    file_pipeline_pread(in.get(), header.data(), header.size(), 0);
+    uint64_t length = key_file_load(header.data() + 24, 8);
+    if (std::memcmp(header.data(), SEALED_FILE_MAGIC, sizeof(SEALED_FILE_MAGIC)) != 0 ||
+        key_file_load(header.data() + 8, 4) != SEALED_FILE_VERSION || key_file_load(header.data() + 12, 4) != field_bits<T>() ||
+        key_file_load(header.data() + 16, 8) != block_size || file_size != header.size() + length + 16) {
+        throw InvalidSealedFile{};
+    }
+    std::vector<T> ciphertext;
+    try {
+        ciphertext = unpack_symbols<T>(header.data() + SEALED_FILE_HEADER_SIZE, field_bits<T>(), 2 * block_size);
+    } catch (IncorrectValueRange&) {
+        throw InvalidSealedFile{};
+    }
+    auto opener = make_hybrid_opener(dc, ciphertext, error_weight, num_iterations,
+                                     std::vector<uint8_t>(header.begin(), header.begin() + SEALED_FILE_HEADER_SIZE));
+    std::array<uint8_t, 16> tag{};
+    file_pipeline_pread(in.get(), tag.data(), tag.size(), header.size() + length);
+
+    TemporaryFile out{out_path};
+    run_file_pipeline(in.get(), header.size(), out.get(), 0, length, options,
+                      [&opener](uint8_t* data, size_t count) { opener.update(data, data, count); });
+    if (!opener.finalize(tag)) {
+        return OpenFileStatus::authentication_failure;
+    }
+    out.rename_to_target();
+    return OpenFileStatus::success;
+}
+
+#endif //MDPC_GF4_FILE_PIPELINE_H
@@ -92,6 +92,17 @@ public:
         return value == 1;
     }
 
+    /**
+     * @brief Get the integer representation of the element.
+     *
+     * The conversion table is the same as in the conversion constructor.
+     *
+     * @return integer value from 0 to 3
+     */
+    [[nodiscard]] auto get_value() const -> uint8_t {
+        return value;
+    }
+
     /**
      * @brief Get a string representation of the element.
      *
@@ -0,0 +1,244 @@
+#ifndef MDPC_GF4_GF4_EXTENSION_H
+#define MDPC_GF4_GF4_EXTENSION_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "custom_exceptions.h"
+#include "gf4.h"
+
+/**
+ * Irreducible polynomials x^K + m(x) over GF(4) used to construct GF(4^K).
+ * GF4_EXTENSION_MODULUS[K] stores the coefficients of m(x), two bits per coefficient, the coefficient of x^0 in the lowest bits.
+ * The coefficients are encoded as in GF4 (0, 1, 2 = alpha, 3 = alpha + 1).
+ */
+static const uint32_t GF4_EXTENSION_MODULUS[9] = {
+        0x0,
+        0x1,     // x + 1
+        0x9,     // x^2 + alpha*x + 1
+        0x11,    // x^3 + x^2 + 1
+        0x91,    // x^4 + alpha*x^3 + x^2 + 1
+        0x201,   // x^5 + alpha*x^4 + 1
+        0x941,   // x^6 + alpha*x^5 + x^4 + x^3 + 1
+        0x1001,  // x^7 + x^6 + 1
+        0xc801   // x^8 + (alpha + 1)*x^7 + alpha*x^5 + 1
+};
+
+/**
+ * @brief A class representing the extension field GF(4^K) for 1 <= K <= 8.
+ *
+ * GF(4^K) = GF(4)[X] / (X^K + m(X)), where X^K + m(X) is the irreducible polynomial GF4_EXTENSION_MODULUS[K].
+ * An element c_0 + c_1 X + ... + c_{K-1} X^{K-1} is stored as an integer with two bits per coefficient,
+ * c_0 in the lowest bits. The integer representation is also used by the conversion constructor,
+ * e.g. GF4Extension<K>{1} is the one and GF4Extension<K>{4} is X.
+ *
+ * The class provides the same methods as GF4, so it can be used with PolynomialGF2N,
+ * e.g. to evaluate polynomials over GF(4) at roots of unity (see roots_of_unity).
+ *
+ * @tparam K The degree of the extension.
+ */
+template<unsigned K>
+class GF4Extension {
+    static_assert(K >= 1 && K <= 8, "GF4Extension supports degrees 1 to 8");
+public:
+    GF4Extension() : value(0) {}
+
+    /**
+     * @brief A conversion constructor from integer to an element.
+     *
+     * @throws IncorrectValueRange if the given integer is above 4^K - 1
+     * @param value integer representation of the element
+     */
+    explicit GF4Extension(size_t value) {
+        if (value > get_max_value()) {
+            throw IncorrectValueRange{};
+        }
+        this->value = value;
+    }
+
+    /**
+     * @brief Embed an element of GF(4) into GF(4^K).
+     *
+     * @param element An element of GF(4).
+     */
+    explicit GF4Extension(const GF4& element) : value(element.get_value()) {}
+
+    GF4Extension(const GF4Extension<K>& other) = default;
+
+    auto operator=(const GF4Extension<K>& other) -> GF4Extension<K>& = default;
+
+    [[nodiscard]] auto is_zero() const -> bool {
+        return value == 0;
+    }
+
+    [[nodiscard]] auto is_one() const -> bool {
+        return value == 1;
+    }
+
+    [[nodiscard]] auto get_value() const -> uint32_t {
+        return value;
+    }
+
+    [[nodiscard]] auto to_string() const -> std::string {
+        if (value == 0) {
+            return "0";
+        }
+        std::string repr;
+        std::string sep;
+        for (unsigned i = 0; i < K; ++i) {
+            GF4 c{coefficient(i)};
+            if (!c.is_zero()) {
+                repr += sep + c.to_string() + "*X^" + std::to_string(i);
+                sep = " + ";
+            }
+        }
+        return "(" + repr + ")";
+    }
+
+    auto operator==(const GF4Extension<K>& other) const -> bool {
+        return value == other.value;
+    }
+
+    auto operator!=(const GF4Extension<K>& other) const -> bool {
+        return value != other.value;
+    }
+
+    auto operator+(const GF4Extension<K>& other) const -> GF4Extension<K> {
+        return from_raw(value ^ other.value);
+    }
+
+    auto operator+=(const GF4Extension<K>& other) -> GF4Extension<K>& {
+        value ^= other.value;
+        return *this;
+    }
+
+    auto operator*(const GF4Extension<K>& other) const -> GF4Extension<K> {
+        uint8_t product[2 * K - 1] = {};
+        for (unsigned i = 0; i < K; ++i) {
+            uint8_t a = coefficient(i);
+            if (a == 0) {
+                continue;
+            }
+            for (unsigned j = 0; j < K; ++j) {
+                product[i + j] ^= GF4_MULTIPLICATION[a][other.coefficient(j)];
+            }
+        }
+        // X^K = m(X) in characteristic 2
+        for (unsigned d = 2 * K - 2; d >= K; --d) {
+            uint8_t c = product[d];
+            if (c != 0) {
+                for (unsigned i = 0; i < K; ++i) {
+                    product[d - K + i] ^= GF4_MULTIPLICATION[c][(GF4_EXTENSION_MODULUS[K] >> (2 * i)) & 3u];
+                }
+            }
+        }
+        uint32_t out = 0;
+        for (unsigned i = 0; i < K; ++i) {
+            out |= (uint32_t)product[i] << (2 * i);
+        }
+        return from_raw(out);
+    }
+
+    auto operator*=(const GF4Extension<K>& other) -> GF4Extension<K>& {
+        *this = *this * other;
+        return *this;
+    }
+
+    /**
+     * @brief Raise the element to the given power.
+     *
+     * @param exponent The exponent.
+     * @return The element raised to the exponent, 0^0 is one.
+     */
+    [[nodiscard]] auto pow(size_t exponent) const -> GF4Extension<K> {
+        GF4Extension<K> out = from_raw(1);
+        GF4Extension<K> base = *this;
+        while (exponent != 0) {
+            if (exponent & 1u) {
+                out *= base;
+            }
+            base *= base;
+            exponent >>= 1u;
+        }
+        return out;
+    }
+
+    /**
+     * @brief Get the multiplicative inverse, computed as a^(4^K - 2).
+     *
+     * @throws DivisionByZero if the element is zero
+     * @return The multiplicative inverse.
+     */
+    [[nodiscard]] auto inverse() const -> GF4Extension<K> {
+        if (is_zero()) {
+            throw DivisionByZero{};
+        }
+        return pow(get_max_value() - 1);
+    }
+
+    auto operator/(const GF4Extension<K>& other) const -> GF4Extension<K> {
+        return *this * other.inverse();
+    }
+
+    auto operator/=(const GF4Extension<K>& other) -> GF4Extension<K>& {
+        *this = *this * other.inverse();
+        return *this;
+    }
+
+    /**
+     * @brief Get the maximum integer representation of an element, i.e. 4^K - 1.
+     *
+     * @return 4^K - 1
+     */
+    [[nodiscard]] static auto get_max_value() -> size_t {
+        return (size_t{1} << (2 * K)) - 1;
+    }
+
+    /**
+     * @brief Get all nonzero elements of GF(4^K).
+     *
+     * @return A vector of the 4^K - 1 nonzero elements.
+     */
+    static auto nonzero_elements() -> std::vector<GF4Extension<K>> {
+        std::vector<GF4Extension<K>> out;
+        for (size_t v = 1; v <= get_max_value(); ++v) {
+            out.push_back(from_raw(v));
+        }
+        return out;
+    }
+
+private:
+    static auto from_raw(uint32_t raw) -> GF4Extension<K> {
+        GF4Extension<K> out;
+        out.value = raw;
+        return out;
+    }
+
+    [[nodiscard]] auto coefficient(unsigned i) const -> uint8_t {
+        return (value >> (2 * i)) & 3u;
+    }
+
+    uint32_t value;
+};
+
+/**
+ * @brief Find all n-th roots of unity in GF(4^K).
+ *
+ * There are gcd(n, 4^K - 1) of them, all of them are found by exhaustive search.
+ *
+ * @tparam K The degree of the extension.
+ * @param n The order.
+ * @return All x in GF(4^K) such that x^n = 1.
+ */
+template<unsigned K>
+auto roots_of_unity(size_t n) -> std::vector<GF4Extension<K>> {
+    std::vector<GF4Extension<K>> out;
+    for (const auto& x: GF4Extension<K>::nonzero_elements()) {
+        if (x.pow(n).is_one()) {
+            out.push_back(x);
+        }
+    }
+    return out;
+}
+
+#endif //MDPC_GF4_GF4_EXTENSION_H
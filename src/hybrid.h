@@ -0,0 +1,220 @@
+#ifndef MDPC_GF4_HYBRID_H
+#define MDPC_GF4_HYBRID_H
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include "contexts.h"
+#include "vector_utils.h"
+#include "secure_random.h"
+#include "sha256.h"
+#include "chacha20_poly1305.h"
+#include "custom_exceptions.h"
+
+/*
+ * Hybrid encryption: only a random symmetric key travels through the MDPC code, the payload itself is sealed
+ * by ChaCha20-Poly1305 (see chacha20_poly1305.h).
+ *
+ * The sender picks a random message m and a random error vector e of the given weight and sends c = mG + e.
+ * The receiver decodes c to recover e and gets m as the first block of c + e (the first block of G is the identity).
+ * Both sides derive the key as SHA-256 of a domain separation string, m and e.
+ *
+ * m and e are drawn by SecureRandom, so every key is fresh and the fixed nonce of HybridSealer is never reused.
+ *
+ * The receiver accepts e only if it has the agreed weight and c + e is a codeword, i.e. c = mG + e again.
+ * Otherwise it does not report a failure but derives a pseudorandom key from its private key and c
+ * (implicit rejection), so a forged or undecodable ciphertext only shows as a failed authentication of the payload.
+ */
+
+/**
+ * @brief The result of key encapsulation.
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+struct Encapsulation {
+    std::vector<T> ciphertext;          ///< The vector mG + e of length 2*block_size, sent to the receiver.
+    std::array<uint8_t, 32> key;        ///< The shared symmetric key, kept by the sender.
+};
+
+/**
+ * @brief Derive the symmetric key from the message and the error vector.
+ *
+ * Every symbol is hashed as 4 little-endian bytes of its value.
+ *
+ * @tparam T Finite field to be used.
+ * @param message The message m.
+ * @param error_vector The error vector e.
+ * @return The 32 byte key.
+ */
+template<typename T>
+auto derive_key(const std::vector<T>& message, const std::vector<T>& error_vector) -> std::array<uint8_t, 32> {
+    static const char domain[] = "MDPC-GF4-KEM";
+    Sha256 sha;
+    sha.update(reinterpret_cast<const uint8_t*>(domain), sizeof(domain) - 1);
+    uint8_t bytes[4];
+    for (const auto* vec: {&message, &error_vector}) {
+        for (const T& symbol: *vec) {
+            store_le32(bytes, (uint32_t)symbol.get_value());
+            sha.update(bytes, 4);
+        }
+    }
+    return sha.finalize();
+}
+
+/**
+ * @brief Derive the key returned for a rejected ciphertext from the private key and the ciphertext.
+ *
+ * Every symbol is hashed as 4 little-endian bytes of its value, under a domain separation string of its own.
+ *
+ * @tparam T Finite field to be used.
+ * @param dc The decoding context of the receiver.
+ * @param ciphertext The rejected ciphertext.
+ * @return The 32 byte key.
+ */
+template<typename T>
+auto derive_rejection_key(const DecodingContext<T>& dc, const std::vector<T>& ciphertext) -> std::array<uint8_t, 32> {
+    static const char domain[] = "MDPC-GF4-KEM-REJECT";
+    Sha256 sha;
+    sha.update(reinterpret_cast<const uint8_t*>(domain), sizeof(domain) - 1);
+    uint8_t bytes[4];
+    for (const auto* vec: {&dc.get_h0(), &dc.get_h1(), &ciphertext}) {
+        for (const T& symbol: *vec) {
+            store_le32(bytes, (uint32_t)symbol.get_value());
+            sha.update(bytes, 4);
+        }
+    }
+    return sha.finalize();
+}
+
+/**
+ * @brief Establish a fresh symmetric key for the owner of the public key.
+ *
+ * @throws RandomnessUnavailable if the operating system provides no random bytes.
+ * @tparam T Finite field to be used.
+ * @param ec The encoding context of the receiver.
+ * @param error_weight The hamming weight of the error vector.
+ * @return The ciphertext to send and the key.
+ */
+template<typename T>
+auto encapsulate(const EncodingContext<T>& ec, size_t error_weight) -> Encapsulation<T> {
+    size_t block_size = ec.get_block_size();
+    std::vector<T> message = SecureRandom::random_vector_over_GF2N<T>(block_size);
+    std::vector<T> error_vector = SecureRandom::random_weighted_vector_over_GF2N<T>(2 * block_size, error_weight);
+    std::vector<T> ciphertext = ec.encode(message);
+    for (size_t i = 0; i < ciphertext.size(); ++i) {
+        ciphertext[i] += error_vector[i];
+    }
+    return Encapsulation<T>{ciphertext, derive_key(message, error_vector)};
+}
+
+/**
+ * @brief Recover the symmetric key from the ciphertext of encapsulate.
+ *
+ * The decoding runs without post-processing, whose corrections are not needed for honest ciphertexts
+ * and would only widen the set of accepted error vectors. The decoded e is accepted only if its weight
+ * is error_weight and the syndrome of c + e is zero, which for the systematic G is the same as re-encoding
+ * m = (c + e)[0 .. block_size - 1] and comparing mG + e with c. A rejected or undecodable ciphertext
+ * gives derive_rejection_key instead of an error.
+ *
+ * @throws IncorrectInputVectorLength if the ciphertext is not of length 2*block_size.
+ * @tparam T Finite field to be used.
+ * @param dc The decoding context of the receiver.
+ * @param ciphertext The ciphertext of encapsulate.
+ * @param error_weight The hamming weight of the error vector used by encapsulate.
+ * @param num_iterations Number of iterations of decoding.
+ * @return The key, pseudorandom if the ciphertext was rejected.
+ */
+template<typename T>
+auto decapsulate(const DecodingContext<T>& dc, const std::vector<T>& ciphertext, size_t error_weight,
+                 size_t num_iterations) -> std::array<uint8_t, 32> {
+    auto error_vector = dc.decode_with_report(ciphertext, num_iterations, StagnationPolicy{},
+                                              PostProcessingPolicy::disabled()).error_vector;
+    if (!error_vector.has_value() || hamming_weight(*error_vector) != error_weight) {
+        return derive_rejection_key(dc, ciphertext);
+    }
+    std::vector<T> codeword = ciphertext;
+    for (size_t i = 0; i < codeword.size(); ++i) {
+        codeword[i] += (*error_vector)[i];
+    }
+    if (hamming_weight(dc.calculate_syndrome(codeword)) != 0) {
+        return derive_rejection_key(dc, ciphertext);
+    }
+    size_t block_size = ciphertext.size() / 2;
+    std::vector<T> message(codeword.begin(), codeword.begin() + block_size);
+    return derive_key(message, *error_vector);
+}
+
+/**
+ * @brief Streaming hybrid encryption of a payload for the owner of the public key.
+ *
+ * The constructor encapsulates a fresh key, which is then used for a single payload only,
+ * so the fixed all-zero nonce is never reused with the same key.
+ * Send get_encapsulation().ciphertext, the payload processed by update and the tag from finalize.
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+class HybridSealer {
+public:
+    /**
+     * @brief Encapsulate a fresh key.
+     *
+     * @param ec The encoding context of the receiver.
+     * @param error_weight The hamming weight of the error vector.
+     * @param aad Additional data which is authenticated but not encrypted.
+     */
+    HybridSealer(const EncodingContext<T>& ec, size_t error_weight, const std::vector<uint8_t>& aad = {})
+            : encapsulation(encapsulate(ec, error_weight)), sealer(encapsulation.key, std::array<uint8_t, 12>{}, aad.data(), aad.size()) {}
+
+    [[nodiscard]] auto get_encapsulation() const -> const Encapsulation<T>& {
+        return encapsulation;
+    }
+
+    /**
+     * @brief Encrypt the next part of the payload.
+     *
+     * @param plaintext The plaintext.
+     * @param ciphertext Output buffer of length bytes, may be the same as plaintext.
+     * @param length The number of bytes.
+     */
+    auto update(const uint8_t* plaintext, uint8_t* ciphertext, size_t length) -> void {
+        sealer.update(plaintext, ciphertext, length);
+    }
+
+    /**
+     * @brief Get the authentication tag. The object must not be used afterwards.
+     *
+     * @return The 16 byte tag.
+     */
+    auto finalize() -> std::array<uint8_t, 16> {
+        return sealer.finalize();
+    }
+
+private:
+    Encapsulation<T> encapsulation;
+    ChaCha20Poly1305Sealer sealer;
+};
+
+/**
+ * @brief Start streaming decryption of a payload sealed by HybridSealer.
+ *
+ * A ciphertext rejected by decapsulate yields an opener with a pseudorandom key, so its finalize fails.
+ *
+ * @throws IncorrectInputVectorLength if the ciphertext is not of length 2*block_size.
+ * @tparam T Finite field to be used.
+ * @param dc The decoding context of the receiver.
+ * @param ciphertext The encapsulation ciphertext sent by the HybridSealer.
+ * @param error_weight The hamming weight of the error vector given to the HybridSealer.
+ * @param num_iterations Number of iterations of decoding.
+ * @param aad Additional data given to the HybridSealer.
+ * @return The opener, see ChaCha20Poly1305Opener.
+ */
+template<typename T>
+auto make_hybrid_opener(const DecodingContext<T>& dc, const std::vector<T>& ciphertext, size_t error_weight, size_t num_iterations,
+                        const std::vector<uint8_t>& aad = {}) -> ChaCha20Poly1305Opener {
+    return ChaCha20Poly1305Opener{decapsulate(dc, ciphertext, error_weight, num_iterations), std::array<uint8_t, 12>{},
+                                  aad.data(), aad.size()};
+}
+
+#endif //MDPC_GF4_HYBRID_H
@@ -0,0 +1,439 @@
+#ifndef MDPC_GF4_KEY_FILE_H
+#define MDPC_GF4_KEY_FILE_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "contexts.h"
+#include "factorization.h"
+#include "field_traits.h"
+#include "custom_exceptions.h"
+
+static const char KEY_FILE_MAGIC[8] = {'M', 'D', 'P', 'C', 'K', 'E', 'Y', 'S'};
+static const uint32_t KEY_FILE_VERSION = 1;
+static const size_t KEY_FILE_HEADER_SIZE = 64;
+static const size_t KEY_FILE_PAGE_SIZE = 4096;
+
+inline auto key_file_store(uint8_t* dst, uint64_t value, size_t bytes) -> void {
+    for (size_t i = 0; i < bytes; ++i) {
+        dst[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+inline auto key_file_load(const uint8_t* src, size_t bytes) -> uint64_t {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= (uint64_t)src[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Pack symbols of GF(2^bits) into bytes, least significant bits first.
+ *
+ * This is the layout of the packed vectors of FieldTraits, which are used if the field has one.
+ *
+ * @param symbols The symbols.
+ * @param bits The number of bits of a symbol.
+ * @param out The output, at least ceil(symbols.size() * bits / 8) zeroed bytes.
+ */
+template<typename T>
+auto pack_symbols(const std::vector<T>& symbols, size_t bits, uint8_t* out) -> void {
+    if constexpr (FieldTraits<T>::has_packed_layout) {
+        if (bits == FieldTraits<T>::bits) {
+            typename FieldTraits<T>::PackedVector packed{symbols};
+            std::memcpy(out, packed.data(), (symbols.size() * bits + 7) / 8);
+            return;
+        }
+    }
+    size_t position = 0;
+    for (const T& symbol: symbols) {
+        uint32_t value = symbol.get_value();
+        for (size_t b = 0; b < bits; ++b, ++position) {
+            out[position / 8] |= (uint8_t)(((value >> b) & 1) << (position % 8));
+        }
+    }
+}
+
+/**
+ * @brief Unpack symbols packed by pack_symbols.
+ *
+ * @throws IncorrectValueRange if a packed value is not an element of T.
+ * @param in The packed symbols.
+ * @param bits The number of bits of a symbol.
+ * @param count The number of symbols.
+ * @return The symbols.
+ */
+template<typename T>
+auto unpack_symbols(const uint8_t* in, size_t bits, size_t count) -> std::vector<T> {
+    if constexpr (FieldTraits<T>::has_packed_layout) {
+        if (bits == FieldTraits<T>::bits) {
+            return FieldTraits<T>::PackedVector::from_bytes(in, count).to_vector();
+        }
+    }
+    std::vector<T> symbols;
+    symbols.reserve(count);
+    size_t position = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t value = 0;
+        for (size_t b = 0; b < bits; ++b, ++position) {
+            value |= (size_t)((in[position / 8] >> (position % 8)) & 1) << b;
+        }
+        symbols.emplace_back(value);
+    }
+    return symbols;
+}
+
+/**
+ * @brief A file of key pairs which is written by many threads at once and read through a memory mapping.
+ *
+ * The file consists of
+ *  + a header of 64 bytes: the magic "MDPCKEYS", the version, the bits per symbol, the block size,
+ *    the block weight, the capacity, the record size and the offset of the records, all little-endian,
+ *  + the index: one byte per slot, 1 if the record of the slot is complete, 0 otherwise,
+ *  + the records, starting at the next page boundary: one record of record size bytes per slot,
+ *    which holds the second block of G, h0 and h1 packed by pack_symbols.
+ * The record of a slot is flushed to the disk before its index byte is set, so after an interruption
+ * every slot marked complete holds a whole key pair, and provision_key_file continues with the other slots.
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+class KeyFile {
+public:
+    /**
+     * @brief Create a key file with all slots empty, or open an existing one to continue provisioning it.
+     *
+     * @throws KeyFileIOError if the file cannot be created, resized or mapped.
+     * @throws InvalidKeyFile if the file exists but is not a key file of the given parameters.
+     * @param path The path of the file.
+     * @param capacity The number of key pairs the file holds.
+     * @param block_size The size of the circulant block of the matrices.
+     * @param block_weight The hamming weight of the row of the block of the matrix H.
+     * @return The key file, writable.
+     */
+    static auto create(const std::string& path, size_t capacity, size_t block_size, size_t block_weight) -> KeyFile {
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd < 0) {
+            throw KeyFileIOError{};
+        }
+        KeyFile file{fd, true};
+        file.bits_per_symbol = field_bits<T>();
+        file.block_size = block_size;
+        file.block_weight = block_weight;
+        file.capacity = capacity;
+        file.record_size = (3 * block_size * file.bits_per_symbol + 63) / 64 * 8;
+        file.records_offset = (KEY_FILE_HEADER_SIZE + capacity + KEY_FILE_PAGE_SIZE - 1) / KEY_FILE_PAGE_SIZE * KEY_FILE_PAGE_SIZE;
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            throw KeyFileIOError{};
+        }
+        // an empty file, or one interrupted before its header was written, is started anew
+        bool fresh = (size_t)st.st_size < KEY_FILE_HEADER_SIZE;
+        if (!fresh) {
+            char magic[sizeof(KEY_FILE_MAGIC)];
+            if (::pread(fd, magic, sizeof(magic), 0) != (ssize_t)sizeof(magic)) {
+                throw KeyFileIOError{};
+            }
+            fresh = std::all_of(magic, magic + sizeof(magic), [](char c) { return c == 0; });
+        }
+        if (fresh && ::ftruncate(fd, (off_t)file.file_size()) != 0) {
+            throw KeyFileIOError{};
+        }
+        if (!fresh) {
+            KeyFile existing = open(path, false);
+            if (existing.bits_per_symbol != file.bits_per_symbol || existing.block_size != block_size ||
+                existing.block_weight != block_weight || existing.capacity != capacity) {
+                throw InvalidKeyFile{};
+            }
+        }
+        file.map();
+        if (fresh) {
+            file.write_header();
+            file.sync(0, KEY_FILE_HEADER_SIZE);
+        }
+        return file;
+    }
+
+    /**
+     * @brief Open an existing key file.
+     *
+     * @throws KeyFileIOError if the file cannot be opened or mapped.
+     * @throws InvalidKeyFile if the file is not a key file over T or is truncated.
+     * @param path The path of the file.
+     * @param writable Whether slots may be written, see provision_key_file.
+     * @return The key file.
+     */
+    static auto open(const std::string& path, bool writable = false) -> KeyFile {
+        int fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+        if (fd < 0) {
+            throw KeyFileIOError{};
+        }
+        KeyFile file{fd, writable};
+        uint8_t header[KEY_FILE_HEADER_SIZE];
+        if (::pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            throw InvalidKeyFile{};
+        }
+        if (std::memcmp(header, KEY_FILE_MAGIC, sizeof(KEY_FILE_MAGIC)) != 0 || key_file_load(header + 8, 4) != KEY_FILE_VERSION) {
+            throw InvalidKeyFile{};
+        }
+        file.bits_per_symbol = key_file_load(header + 12, 4);
+        file.block_size = key_file_load(header + 16, 8);
+        file.block_weight = key_file_load(header + 24, 8);
+        file.capacity = key_file_load(header + 32, 8);
+        file.record_size = key_file_load(header + 40, 8);
+        file.records_offset = key_file_load(header + 48, 8);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            throw KeyFileIOError{};
+        }
+        if (file.bits_per_symbol != field_bits<T>() || file.record_size * 8 < 3 * file.block_size * file.bits_per_symbol ||
+            file.records_offset < KEY_FILE_HEADER_SIZE + file.capacity || (size_t)st.st_size < file.file_size()) {
+            throw InvalidKeyFile{};
+        }
+        file.map();
+        return file;
+    }
+
+    KeyFile(const KeyFile&) = delete;
+    auto operator=(const KeyFile&) -> KeyFile& = delete;
+
+    KeyFile(KeyFile&& other) noexcept
+            : fd(other.fd), writable(other.writable), data(other.data), mapped_size(other.mapped_size),
+              bits_per_symbol(other.bits_per_symbol), block_size(other.block_size), block_weight(other.block_weight),
+              capacity(other.capacity), record_size(other.record_size), records_offset(other.records_offset) {
+        other.fd = -1;
+        other.data = nullptr;
+    }
+
+    ~KeyFile() {
+        if (data != nullptr) {
+            ::munmap(data, mapped_size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    [[nodiscard]] auto get_capacity() const -> size_t {
+        return capacity;
+    }
+
+    [[nodiscard]] auto get_block_size() const -> size_t {
+        return block_size;
+    }
+
+    [[nodiscard]] auto get_block_weight() const -> size_t {
+        return block_weight;
+    }
+
+    [[nodiscard]] auto is_complete(size_t slot) const -> bool {
+        return data[KEY_FILE_HEADER_SIZE + slot] == 1;
+    }
+
+    /**
+     * @brief Count the slots which hold a complete key pair.
+     */
+    [[nodiscard]] auto count_complete() const -> size_t {
+        return std::count(data + KEY_FILE_HEADER_SIZE, data + KEY_FILE_HEADER_SIZE + capacity, 1);
+    }
+
+    /**
+     * @brief Read the key pair of a slot.
+     *
+     * @throws KeyNotProvisioned if the slot is out of range or not complete.
+     * @param slot The slot.
+     * @return The vectors of the key pair.
+     */
+    [[nodiscard]] auto get_key_blocks(size_t slot) const -> KeyBlocks<T> {
+        if (slot >= capacity || !is_complete(slot)) {
+            throw KeyNotProvisioned{};
+        }
+        // the blocks are packed back to back, so a block may start inside a byte
+        std::vector<T> symbols = unpack_symbols<T>(data + records_offset + slot * record_size, bits_per_symbol, 3 * block_size);
+        KeyBlocks<T> blocks;
+        blocks.second_block_G.assign(symbols.begin(), symbols.begin() + block_size);
+        blocks.h0.assign(symbols.begin() + block_size, symbols.begin() + 2 * block_size);
+        blocks.h1.assign(symbols.begin() + 2 * block_size, symbols.end());
+        return blocks;
+    }
+
+    [[nodiscard]] auto get_second_block_G(size_t slot) const -> std::vector<T> {
+        return get_key_blocks(slot).second_block_G;
+    }
+
+    [[nodiscard]] auto get_encoding_context(size_t slot) const -> EncodingContext<T> {
+        return EncodingContext<T>{get_second_block_G(slot), block_size};
+    }
+
+    [[nodiscard]] auto get_decoding_context(size_t slot) const -> DecodingContext<T> {
+        KeyBlocks<T> blocks = get_key_blocks(slot);
+        return DecodingContext<T>{blocks.h0, blocks.h1, block_size, block_weight};
+    }
+
+    /**
+     * @brief Write the key pair of a slot without flushing it, the slot stays incomplete until commit.
+     *
+     * Different slots may be stored by different threads at once.
+     *
+     * @param slot The slot.
+     * @param blocks The vectors of the key pair.
+     */
+    auto store(size_t slot, const KeyBlocks<T>& blocks) -> void {
+        uint8_t* record = data + records_offset + slot * record_size;
+        std::vector<T> packed;
+        packed.reserve(3 * block_size);
+        packed.insert(packed.end(), blocks.second_block_G.begin(), blocks.second_block_G.end());
+        packed.insert(packed.end(), blocks.h0.begin(), blocks.h0.end());
+        packed.insert(packed.end(), blocks.h1.begin(), blocks.h1.end());
+        std::memset(record, 0, record_size);
+        pack_symbols(packed, bits_per_symbol, record);
+    }
+
+    /**
+     * @brief Flush the stored records of the given slots, then mark the slots complete and flush the index.
+     *
+     * The records are flushed by a single msync over the pages between the first and the last of them
+     * and the index bytes are set only afterwards, so no slot is complete on the disk before its record.
+     *
+     * @param slots Slots written by store.
+     */
+    auto commit(const std::vector<size_t>& slots) -> void {
+        if (slots.empty()) {
+            return;
+        }
+        auto [first, last] = std::minmax_element(slots.begin(), slots.end());
+        sync(records_offset + *first * record_size, (*last - *first + 1) * record_size);
+        for (size_t slot: slots) {
+            data[KEY_FILE_HEADER_SIZE + slot] = 1;
+        }
+        sync_index();
+    }
+
+    /**
+     * @brief Flush the index to the disk.
+     */
+    auto sync_index() -> void {
+        sync(KEY_FILE_HEADER_SIZE, capacity);
+    }
+
+private:
+    KeyFile(int fd, bool writable) : fd(fd), writable(writable), data(nullptr), mapped_size(0), bits_per_symbol(0),
+                                     block_size(0), block_weight(0), capacity(0), record_size(0), records_offset(0) {}
+
+    [[nodiscard]] auto file_size() const -> size_t {
+        return records_offset + capacity * record_size;
+    }
+
+    auto map() -> void {
+        mapped_size = file_size();
+        void* address = ::mmap(nullptr, mapped_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            throw KeyFileIOError{};
+        }
+        data = static_cast<uint8_t*>(address);
+    }
+
+    auto write_header() -> void {
+        std::memset(data, 0, KEY_FILE_HEADER_SIZE);
+        std::memcpy(data, KEY_FILE_MAGIC, sizeof(KEY_FILE_MAGIC));
+        key_file_store(data + 8, KEY_FILE_VERSION, 4);
+        key_file_store(data + 12, (uint32_t)bits_per_symbol, 4);
+        key_file_store(data + 16, block_size, 8);
+        key_file_store(data + 24, block_weight, 8);
+        key_file_store(data + 32, capacity, 8);
+        key_file_store(data + 40, record_size, 8);
+        key_file_store(data + 48, records_offset, 8);
+    }
+
+    auto sync(size_t offset, size_t length) -> void {
+        size_t begin = offset / KEY_FILE_PAGE_SIZE * KEY_FILE_PAGE_SIZE;
+        if (::msync(data + begin, offset + length - begin, MS_SYNC) != 0) {
+            throw KeyFileIOError{};
+        }
+    }
+
+    int fd;
+    bool writable;
+    uint8_t* data;
+    size_t mapped_size;
+    size_t bits_per_symbol;
+    size_t block_size;
+    size_t block_weight;
+    size_t capacity;
+    size_t record_size;
+    size_t records_offset;
+};
+
+/**
+ * @brief Generate key pairs for all slots of the key file which are not complete yet.
+ *
+ * The threads take the empty slots one by one and write every key pair into the mapping as soon as it is generated,
+ * so no key pair is held in memory longer than it takes to store it. An interrupted run is continued
+ * by calling this function again on the reopened file, see KeyFile::create.
+ *
+ * @tparam T Finite field to be used.
+ * @param file The writable key file.
+ * @param num_threads The number of threads, 0 uses the hardware concurrency.
+ * @param progress Called after every stored key pair with the number of stored and of empty slots of this run.
+ * @return The number of generated key pairs.
+ */
+template<typename T>
+auto provision_key_file(KeyFile<T>& file, size_t num_threads = 0,
+                        const std::function<void(size_t, size_t)>& progress = {}) -> size_t {
+    std::vector<size_t> pending;
+    for (size_t slot = 0; slot < file.get_capacity(); ++slot) {
+        if (!file.is_complete(slot)) {
+            pending.push_back(slot);
+        }
+    }
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex progress_mutex;
+
+    auto work = [&]() {
+        // the records are committed every few slots, so that an interruption loses at most that many key pairs per thread
+        const size_t sync_every = 16;
+        std::vector<size_t> stored;
+        for (size_t i = next.fetch_add(1); i < pending.size(); i = next.fetch_add(1)) {
+            file.store(pending[i], generate_key_blocks<T>(file.get_block_size(), file.get_block_weight()));
+            stored.push_back(pending[i]);
+            if (stored.size() == sync_every) {
+                file.commit(stored);
+                stored.clear();
+            }
+            size_t total = done.fetch_add(1) + 1;
+            if (progress) {
+                std::lock_guard<std::mutex> lock{progress_mutex};
+                progress(total, pending.size());
+            }
+        }
+        file.commit(stored);
+    };
+
+    if (num_threads == 0) {
+        num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    return pending.size();
+}
+
+#endif //MDPC_GF4_KEY_FILE_H
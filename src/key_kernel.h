@@ -0,0 +1,174 @@
+#ifndef MDPC_GF4_KEY_KERNEL_H
+#define MDPC_GF4_KEY_KERNEL_H
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include "custom_exceptions.h"
+#include "gf4.h"
+#include "simd.h"
+#include "packed_gf4.h"
+
+/**
+ * @brief A circulant block of H specialized for its first row h.
+ *
+ * The block is built once when the key is loaded. Only the nonzero entries of h are kept as (offset, value) pairs,
+ * so the kernels below cost O(w*n) instead of O(n^2) and never look at the zero entries of h.
+ *
+ * The entry of the block in the row r and the column c is h[(c - r) mod n].
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+class SparseCirculant {
+public:
+    SparseCirculant() : block_size(0) {}
+
+    explicit SparseCirculant(const std::vector<T>& h) : block_size(h.size()) {
+        for (size_t k = 0; k < h.size(); ++k) {
+            if (!h[k].is_zero()) {
+                offsets.push_back(k);
+                values.push_back(h[k]);
+            }
+        }
+    }
+
+    /**
+     * @brief Add the product of the block and the vector to out, i.e. out[r] += sum_k h[k] * vec[(r + k) mod n].
+     *
+     * @throws IncorrectInputVectorLength if out is not of length block_size.
+     * @param vec The vector to multiply, at least block_size elements are read.
+     * @param out The vector to add the product to.
+     */
+    auto multiply_accumulate(const T* vec, std::vector<T>& out) const -> void {
+        if (out.size() != block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            size_t k = offsets[i];
+            for (size_t r = 0; r < block_size; ++r) {
+                out[r] += values[i] * vec[(r + k) % block_size];
+            }
+        }
+    }
+
+    /**
+     * @brief Add a times the given column of the block to the syndrome.
+     *
+     * @param column The column of the block.
+     * @param a The scalar.
+     * @param syndrome The syndrome of length block_size.
+     */
+    auto add_column(size_t column, const T& a, std::vector<T>& syndrome) const -> void {
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            syndrome[(block_size + column - offsets[i]) % block_size] += a * values[i];
+        }
+    }
+
+private:
+    std::vector<size_t> offsets;
+    std::vector<T> values;
+    size_t block_size;
+};
+
+/**
+ * @brief A circulant block of H over GF(4) specialized for its first row h.
+ *
+ * The offsets of the nonzero entries of h are grouped by their value a in {1, alpha, alpha + 1}.
+ * The product of the block and a vector is then
+ *  sum_a a * (sum_{k : h[k] = a} rotate(vec, k)),
+ * i.e. the inner loops are plain XORs of contiguous windows of a doubled copy of the vector (see SimdBytes)
+ * followed by only three scalar multiplications per entry.
+ */
+template<>
+class SparseCirculant<GF4> {
+public:
+    SparseCirculant() : block_size(0) {}
+
+    explicit SparseCirculant(const std::vector<GF4>& h) : block_size(h.size()) {
+        for (size_t k = 0; k < h.size(); ++k) {
+            if (!h[k].is_zero()) {
+                groups[h[k].get_value() - 1].push_back(k);
+                offsets.push_back(k);
+                values.push_back(h[k].get_value());
+            }
+        }
+    }
+
+    /**
+     * @brief Add the product of the block and the vector to out, i.e. out[r] += sum_k h[k] * vec[(r + k) mod n].
+     *
+     * @throws IncorrectInputVectorLength if out is not of length block_size.
+     * @param vec The vector to multiply, at least block_size elements are read.
+     * @param out The vector to add the product to.
+     */
+    auto multiply_accumulate(const GF4* vec, std::vector<GF4>& out) const -> void {
+        if (out.size() != block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+        constexpr size_t width = SimdBytes::width;
+        size_t padded_size = ((block_size + width - 1) / width) * width;
+        std::vector<uint8_t> doubled;
+        doubled.resize(2 * block_size + width);
+        for (size_t i = 0; i < block_size; ++i) {
+            doubled[i] = vec[i].get_value();
+            doubled[block_size + i] = vec[i].get_value();
+        }
+        std::vector<uint8_t> accumulator;
+        accumulator.resize(padded_size);
+        for (size_t g = 0; g < groups.size(); ++g) {
+            if (groups[g].empty()) {
+                continue;
+            }
+            std::fill(accumulator.begin(), accumulator.end(), 0);
+            uint8_t* acc = accumulator.data();
+            for (size_t k: groups[g]) {
+                const uint8_t* window = doubled.data() + k;
+                for (size_t r = 0; r < padded_size; r += width) {
+                    (SimdBytes::load(acc + r) ^ SimdBytes::load(window + r)).store(acc + r);
+                }
+            }
+            const uint8_t* row = GF4_MULTIPLICATION[g + 1];
+            for (size_t r = 0; r < block_size; ++r) {
+                out[r] += GF4{row[acc[r]]};
+            }
+        }
+    }
+
+    /**
+     * @brief multiply_accumulate for vectors in the packed layout, see PackedGF4Vector::circulant_multiply_accumulate.
+     *
+     * @throws IncorrectInputVectorLength if vec or out is not of length block_size.
+     * @param vec The vector to multiply.
+     * @param out The vector to add the product to.
+     */
+    auto multiply_accumulate(const PackedGF4Vector& vec, PackedGF4Vector& out) const -> void {
+        if (vec.size() != block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+        PackedGF4Vector::circulant_multiply_accumulate(groups, vec, out);
+    }
+
+    /**
+     * @brief Add a times the given column of the block to the syndrome.
+     *
+     * @param column The column of the block.
+     * @param a The scalar.
+     * @param syndrome The syndrome of length block_size.
+     */
+    auto add_column(size_t column, const GF4& a, std::vector<GF4>& syndrome) const -> void {
+        const uint8_t* row = GF4_MULTIPLICATION[a.get_value()];
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            syndrome[(block_size + column - offsets[i]) % block_size] += GF4{row[values[i]]};
+        }
+    }
+
+private:
+    std::array<std::vector<size_t>, 3> groups;
+    std::vector<size_t> offsets;
+    std::vector<uint8_t> values;
+    size_t block_size;
+};
+
+#endif //MDPC_GF4_KEY_KERNEL_H
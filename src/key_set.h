@@ -0,0 +1,260 @@
+#ifndef MDPC_GF4_KEY_SET_H
+#define MDPC_GF4_KEY_SET_H
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include "contexts.h"
+#include "custom_exceptions.h"
+
+/**
+ * @brief The keys a service works with at one time.
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+struct KeySet {
+    std::vector<EncodingContext<T>> encoding;
+    std::vector<DecodingContext<T>> decoding;
+    uint64_t version = 0;   ///< Assigned by KeySetHolder::publish, increases with every published set.
+};
+
+/**
+ * @brief Generate a key set of fresh keys.
+ *
+ * @tparam T Finite field to be used.
+ * @param count The number of key pairs.
+ * @param block_size The size of the circulant block of the matrices.
+ * @param block_weight The hamming weight of the row of the block of the matrix H.
+ * @return The key set.
+ */
+template<typename T>
+auto generate_key_set(size_t count, size_t block_size, size_t block_weight) -> KeySet<T> {
+    KeySet<T> set;
+    for (size_t i = 0; i < count; ++i) {
+        auto [ec, dc] = generate_contexts_over_GF2N<T>(block_size, block_weight);
+        set.encoding.push_back(ec);
+        set.decoding.push_back(dc);
+    }
+    return set;
+}
+
+/**
+ * @brief Holds the current key set and replaces it while readers keep working.
+ *
+ * Readers never take a lock: a read is a store to the reader's own slot and a load of the current set.
+ * A new set is built outside of the holder and published by a pointer swap (read-copy-update).
+ * The old set is retired and freed once every reader which could still see it has finished reading,
+ * which is tracked by epochs: a reader announces the epoch in which it started reading in its slot,
+ * and a set retired in epoch e can only be held by readers which announced an epoch of at most e.
+ *
+ * Every thread which reads needs its own Reader (see register_reader). Writers are serialized by a mutex,
+ * which readers never touch.
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+class KeySetHolder {
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> active{0};   ///< The epoch in which the current read started, 0 if not reading.
+        std::atomic<bool> taken{false};
+    };
+
+public:
+    /**
+     * @brief Access to the current key set, valid until the guard is destroyed.
+     */
+    class ReadGuard {
+    public:
+        ReadGuard(const ReadGuard&) = delete;
+        auto operator=(const ReadGuard&) -> ReadGuard& = delete;
+
+        ReadGuard(ReadGuard&& other) noexcept : slot(other.slot), set(other.set) {
+            other.slot = nullptr;
+        }
+
+        ~ReadGuard() {
+            if (slot != nullptr) {
+                slot->active.store(0, std::memory_order_release);
+            }
+        }
+
+        auto operator*() const -> const KeySet<T>& {
+            return *set;
+        }
+
+        auto operator->() const -> const KeySet<T>* {
+            return set;
+        }
+
+    private:
+        friend class KeySetHolder;
+        ReadGuard(ReaderSlot* slot, const KeySet<T>* set) : slot(slot), set(set) {}
+
+        ReaderSlot* slot;
+        const KeySet<T>* set;
+    };
+
+    /**
+     * @brief A registered reader, owns one reader slot. Only one ReadGuard of a reader may exist at a time.
+     */
+    class Reader {
+    public:
+        Reader(const Reader&) = delete;
+        auto operator=(const Reader&) -> Reader& = delete;
+
+        Reader(Reader&& other) noexcept : holder(other.holder), slot(other.slot) {
+            other.slot = nullptr;
+        }
+
+        ~Reader() {
+            if (slot != nullptr) {
+                slot->taken.store(false, std::memory_order_release);
+            }
+        }
+
+        /**
+         * @brief Start reading the current key set.
+         *
+         * @return Guard which keeps the key set alive.
+         */
+        [[nodiscard]] auto lock() const -> ReadGuard {
+            slot->active.store(holder->epoch.load(), std::memory_order_seq_cst);
+            return ReadGuard{slot, holder->current.load(std::memory_order_seq_cst)};
+        }
+
+    private:
+        friend class KeySetHolder;
+        Reader(const KeySetHolder* holder, ReaderSlot* slot) : holder(holder), slot(slot) {}
+
+        const KeySetHolder* holder;
+        ReaderSlot* slot;
+    };
+
+    /**
+     * @brief Hold the initial key set.
+     *
+     * @param initial The initial key set.
+     * @param max_readers The maximum number of readers registered at once.
+     */
+    explicit KeySetHolder(KeySet<T> initial, size_t max_readers = 64)
+            : slots(new ReaderSlot[max_readers]), num_slots(max_readers), epoch(1), last_version(0) {
+        initial.version = ++last_version;
+        current.store(new KeySet<T>{std::move(initial)});
+    }
+
+    KeySetHolder(const KeySetHolder&) = delete;
+    auto operator=(const KeySetHolder&) -> KeySetHolder& = delete;
+
+    /**
+     * @brief Free all key sets. There must be no readers and no rotation in progress.
+     */
+    ~KeySetHolder() {
+        delete current.load();
+        for (auto& [set, retired_epoch]: retired) {
+            delete set;
+        }
+    }
+
+    /**
+     * @brief Register the calling thread as a reader.
+     *
+     * @throws TooManyReaders if all max_readers slots are taken.
+     * @return The reader.
+     */
+    auto register_reader() -> Reader {
+        for (size_t i = 0; i < num_slots; ++i) {
+            bool expected = false;
+            if (!slots[i].taken.load(std::memory_order_relaxed) &&
+                slots[i].taken.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return Reader{this, &slots[i]};
+            }
+        }
+        throw TooManyReaders{};
+    }
+
+    /**
+     * @brief Replace the current key set. Readers which already started reading keep the old one.
+     *
+     * @param next The new key set.
+     * @return The version assigned to the new key set.
+     */
+    auto publish(KeySet<T> next) -> uint64_t {
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        next.version = ++last_version;
+        const KeySet<T>* old = current.exchange(new KeySet<T>{std::move(next)}, std::memory_order_seq_cst);
+        retired.emplace_back(old, epoch.fetch_add(1, std::memory_order_seq_cst));
+        reclaim_locked();
+        return last_version;
+    }
+
+    /**
+     * @brief Free the retired key sets which no reader can hold anymore.
+     *
+     * @return The number of retired key sets still waiting for their readers.
+     */
+    auto reclaim() -> size_t {
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        return reclaim_locked();
+    }
+
+    /**
+     * @brief Wait until all retired key sets are freed, i.e. until all reads of them have finished.
+     */
+    auto synchronize() -> void {
+        while (reclaim() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Build a key set in a background thread, publish it and free the old one once its readers are done.
+     *
+     * The holder must outlive the returned future.
+     *
+     * @param build Builds the new key set, e.g. by generate_key_set.
+     * @return Future which is ready when the old key set is freed.
+     */
+    auto rotate_in_background(std::function<KeySet<T>()> build) -> std::future<void> {
+        return std::async(std::launch::async, [this, build = std::move(build)]() {
+            publish(build());
+            synchronize();
+        });
+    }
+
+private:
+    auto reclaim_locked() -> size_t {
+        uint64_t oldest_reader = UINT64_MAX;
+        for (size_t i = 0; i < num_slots; ++i) {
+            uint64_t active = slots[i].active.load(std::memory_order_seq_cst);
+            if (active != 0) {
+                oldest_reader = std::min(oldest_reader, active);
+            }
+        }
+        auto drained = std::stable_partition(retired.begin(), retired.end(), [&](const auto& entry) {
+            return entry.second >= oldest_reader;
+        });
+        for (auto it = drained; it != retired.end(); ++it) {
+            delete it->first;
+        }
+        retired.erase(drained, retired.end());
+        return retired.size();
+    }
+
+    std::unique_ptr<ReaderSlot[]> slots;
+    size_t num_slots;
+    std::atomic<const KeySet<T>*> current;
+    std::atomic<uint64_t> epoch;
+    std::mutex writer_mutex;
+    uint64_t last_version;
+    std::vector<std::pair<const KeySet<T>*, uint64_t>> retired;
+};
+
+#endif //MDPC_GF4_KEY_SET_H
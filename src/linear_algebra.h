@@ -0,0 +1,148 @@
+#ifndef MDPC_GF4_LINEAR_ALGEBRA_H
+#define MDPC_GF4_LINEAR_ALGEBRA_H
+
+#include <vector>
+#include <optional>
+#include "custom_exceptions.h"
+#include "gf4.h"
+#include "bitsliced_gf4.h"
+
+/**
+ * @brief Solve the linear system Ax = b using gaussian elimination.
+ *
+ * The system does not have to be square. If it has more than one solution, the free variables are set to zero.
+ *
+ * @tparam T Finite field to be used.
+ * @throws IncorrectInputVectorLength if the number of rows of A differs from the length of b or the rows differ in length.
+ * @param matrix The matrix A stored row-wise.
+ * @param rhs The right hand side b.
+ * @param rank_out If not null, receives the rank of A, the solution is unique iff it equals the number of columns.
+ * @return A solution x if the system is consistent, nothing otherwise.
+ */
+template<typename T>
+auto solve_linear_system(std::vector<std::vector<T>> matrix, std::vector<T> rhs, size_t* rank_out = nullptr) -> std::optional<std::vector<T>> {
+    if (matrix.size() != rhs.size()) {
+        throw IncorrectInputVectorLength{};
+    }
+    size_t num_columns = matrix.empty() ? 0 : matrix[0].size();
+    for (const auto& row: matrix) {
+        if (row.size() != num_columns) {
+            throw IncorrectInputVectorLength{};
+        }
+    }
+    std::vector<size_t> pivot_columns;
+    size_t rank = 0;
+    for (size_t col = 0; col < num_columns && rank < matrix.size(); ++col) {
+        size_t pivot = rank;
+        while (pivot < matrix.size() && matrix[pivot][col].is_zero()) {
+            ++pivot;
+        }
+        if (pivot == matrix.size()) {
+            continue;
+        }
+        std::swap(matrix[rank], matrix[pivot]);
+        std::swap(rhs[rank], rhs[pivot]);
+        T lead = matrix[rank][col];
+        for (size_t k = col; k < num_columns; ++k) {
+            matrix[rank][k] /= lead;
+        }
+        rhs[rank] /= lead;
+        for (size_t row = 0; row < matrix.size(); ++row) {
+            T factor = matrix[row][col];
+            if (row != rank && !factor.is_zero()) {
+                for (size_t k = col; k < num_columns; ++k) {
+                    matrix[row][k] += factor * matrix[rank][k];
+                }
+                rhs[row] += factor * rhs[rank];
+            }
+        }
+        pivot_columns.push_back(col);
+        ++rank;
+    }
+    if (rank_out != nullptr) {
+        *rank_out = rank;
+    }
+    for (size_t row = rank; row < rhs.size(); ++row) {
+        if (!rhs[row].is_zero()) {
+            return {};
+        }
+    }
+    std::vector<T> solution;
+    solution.resize(num_columns);
+    for (size_t i = 0; i < rank; ++i) {
+        solution[pivot_columns[i]] = rhs[i];
+    }
+    return solution;
+}
+
+/**
+ * @brief Solve the linear system Ax = b over GF(4) using gaussian elimination on bit-sliced rows.
+ *
+ * Each row of the augmented matrix (A | b) is packed into a BitslicedGF4Vector,
+ * so a row operation processes 64 columns per word operation.
+ *
+ * @throws IncorrectInputVectorLength if the number of rows of A differs from the length of b or the rows differ in length.
+ * @param matrix The matrix A stored row-wise.
+ * @param rhs The right hand side b.
+ * @param rank_out If not null, receives the rank of A, the solution is unique iff it equals the number of columns.
+ * @return A solution x if the system is consistent, nothing otherwise.
+ */
+inline auto solve_linear_system(const std::vector<std::vector<GF4>>& matrix, const std::vector<GF4>& rhs,
+                                size_t* rank_out = nullptr) -> std::optional<std::vector<GF4>> {
+    if (matrix.size() != rhs.size()) {
+        throw IncorrectInputVectorLength{};
+    }
+    size_t num_columns = matrix.empty() ? 0 : matrix[0].size();
+    std::vector<BitslicedGF4Vector> rows;
+    rows.reserve(matrix.size());
+    for (size_t row = 0; row < matrix.size(); ++row) {
+        if (matrix[row].size() != num_columns) {
+            throw IncorrectInputVectorLength{};
+        }
+        rows.emplace_back(num_columns + 1);
+        for (size_t col = 0; col < num_columns; ++col) {
+            if (!matrix[row][col].is_zero()) {
+                rows.back().set(col, matrix[row][col]);
+            }
+        }
+        rows.back().set(num_columns, rhs[row]);
+    }
+
+    std::vector<size_t> pivot_columns;
+    size_t rank = 0;
+    for (size_t col = 0; col < num_columns && rank < rows.size(); ++col) {
+        size_t pivot = rank;
+        while (pivot < rows.size() && rows[pivot].get(col).is_zero()) {
+            ++pivot;
+        }
+        if (pivot == rows.size()) {
+            continue;
+        }
+        std::swap(rows[rank], rows[pivot]);
+        rows[rank] *= (GF4{1} / rows[rank].get(col));
+        for (size_t row = 0; row < rows.size(); ++row) {
+            GF4 factor = rows[row].get(col);
+            if (row != rank && !factor.is_zero()) {
+                rows[row].add_multiple(rows[rank], factor, col / 64);
+            }
+        }
+        pivot_columns.push_back(col);
+        ++rank;
+    }
+    if (rank_out != nullptr) {
+        *rank_out = rank;
+    }
+    for (size_t row = rank; row < rows.size(); ++row) {
+        if (!rows[row].get(num_columns).is_zero()) {
+            return {};
+        }
+    }
+    std::vector<GF4> solution;
+    solution.resize(num_columns);
+    for (size_t i = 0; i < rank; ++i) {
+        solution[pivot_columns[i]] = rows[i].get(num_columns);
+    }
+    return solution;
+}
+
+#endif //MDPC_GF4_LINEAR_ALGEBRA_H
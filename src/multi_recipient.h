@@ -0,0 +1,218 @@
+#ifndef MDPC_GF4_MULTI_RECIPIENT_H
+#define MDPC_GF4_MULTI_RECIPIENT_H
+
+#include <vector>
+#include <array>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include "contexts.h"
+#include "gf4.h"
+#include "custom_exceptions.h"
+
+/**
+ * @brief A message prepared for encoding under many public keys.
+ *
+ * Encoding computes the second block c_1[i] = sum_k G[k] * m[(i + k) mod n], where G is the second block of the public key.
+ * Everything that depends only on the message is done once in the constructor, encode then does only the key-dependent part.
+ * The generic version only stores the message; see the GF4 specialization for the precomputed form.
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+class MessageEncoder {
+public:
+    /**
+     * @brief Prepare the message.
+     *
+     * @param message A vector of length block_size.
+     */
+    explicit MessageEncoder(const std::vector<T>& message) : message(message) {}
+
+    [[nodiscard]] auto get_block_size() const -> size_t {
+        return message.size();
+    }
+
+    /**
+     * @brief Encode the message under a public key.
+     *
+     * Gives the same result as EncodingContext::encode.
+     *
+     * @param second_block_G The second block of the public key, block_size elements.
+     * @return Encoded message stored in a vector of length 2*block_size.
+     */
+    [[nodiscard]] auto encode(const T* second_block_G) const -> std::vector<T> {
+        size_t block_size = message.size();
+        std::vector<T> encoded{message};
+        encoded.reserve(2 * block_size);
+        for (size_t i = block_size; i > 0; --i) {
+            T tmp{};
+            for (size_t j = 0; j < block_size; ++j) {
+                tmp += (message[j] * second_block_G[(i + j) % block_size]);
+            }
+            encoded.push_back(tmp);
+        }
+        return encoded;
+    }
+
+private:
+    std::vector<T> message;
+};
+
+/**
+ * @brief A message over GF(4) prepared for encoding under many public keys.
+ *
+ * The second block of the codeword is c_1 = sum_k G[k] * W_k, where W_k is the message rotated by k, W_k[i] = m[(i + k) mod n].
+ * The constructor stores the doubled message m || m in bit-sliced form (see BitslicedGF4Vector), shifted by each of 0..63 bits,
+ * so every W_k is a word-aligned window into one of the 64 copies. encode then sums the windows for each nonzero value
+ * of G[k] separately, which is only XOR of words, and multiplies the three sums by 1, alpha and alpha + 1 at the end.
+ * This is about n * n / 32 word operations per key, instead of n * n table lookups.
+ */
+template<>
+class MessageEncoder<GF4> {
+public:
+    /**
+     * @brief Prepare the message.
+     *
+     * @param message A vector of length block_size.
+     */
+    explicit MessageEncoder(const std::vector<GF4>& message) : message(message), block_size(message.size()),
+                                                               words((message.size() + 63) / 64) {
+        size_t doubled_words = (2 * block_size + 63) / 64 + 1;
+        for (size_t s = 0; s < 64; ++s) {
+            shifted_lo[s].assign(doubled_words, 0);
+            shifted_hi[s].assign(doubled_words, 0);
+            for (size_t j = 0; j + s < 2 * block_size; ++j) {
+                uint8_t value = message[(j + s) % block_size].get_value();
+                shifted_lo[s][j / 64] |= (uint64_t)(value & 1u) << (j % 64);
+                shifted_hi[s][j / 64] |= (uint64_t)((value >> 1) & 1u) << (j % 64);
+            }
+        }
+    }
+
+    [[nodiscard]] auto get_block_size() const -> size_t {
+        return block_size;
+    }
+
+    /**
+     * @brief Encode the message under a public key.
+     *
+     * Gives the same result as EncodingContext::encode.
+     *
+     * @param second_block_G The second block of the public key, block_size elements.
+     * @return Encoded message stored in a vector of length 2*block_size.
+     */
+    [[nodiscard]] auto encode(const GF4* second_block_G) const -> std::vector<GF4> {
+        // sums of the windows W_k over G[k] == 1, 2, 3
+        std::array<std::vector<uint64_t>, 4> sum_lo;
+        std::array<std::vector<uint64_t>, 4> sum_hi;
+        for (size_t g = 1; g < 4; ++g) {
+            sum_lo[g].assign(words, 0);
+            sum_hi[g].assign(words, 0);
+        }
+        for (size_t k = 0; k < block_size; ++k) {
+            uint8_t g = second_block_G[k].get_value();
+            if (g == 0) {
+                continue;
+            }
+            const uint64_t* window_lo = shifted_lo[k % 64].data() + k / 64;
+            const uint64_t* window_hi = shifted_hi[k % 64].data() + k / 64;
+            uint64_t* out_lo = sum_lo[g].data();
+            uint64_t* out_hi = sum_hi[g].data();
+            for (size_t w = 0; w < words; ++w) {
+                out_lo[w] ^= window_lo[w];
+                out_hi[w] ^= window_hi[w];
+            }
+        }
+
+        std::vector<GF4> encoded{message};
+        encoded.reserve(2 * block_size);
+        for (size_t w = 0; w < words; ++w) {
+            // 1 * (lo, hi) + alpha * (lo, hi) + (alpha + 1) * (lo, hi), see BitslicedGF4Vector
+            uint64_t lo = sum_lo[1][w] ^ sum_hi[2][w] ^ sum_lo[3][w] ^ sum_hi[3][w];
+            uint64_t hi = sum_hi[1][w] ^ sum_lo[2][w] ^ sum_hi[2][w] ^ sum_lo[3][w];
+            for (size_t i = 64 * w; i < std::min(64 * w + 64, block_size); ++i) {
+                size_t b0 = (lo >> (i % 64)) & 1u;
+                size_t b1 = (hi >> (i % 64)) & 1u;
+                encoded.push_back(GF4{b0 | (b1 << 1)});
+            }
+        }
+        return encoded;
+    }
+
+private:
+    std::vector<GF4> message;
+    size_t block_size;
+    size_t words;
+    std::array<std::vector<uint64_t>, 64> shifted_lo;
+    std::array<std::vector<uint64_t>, 64> shifted_hi;
+};
+
+/**
+ * @brief Encode one message under many public keys stored contiguously, e.g. in a memory-mapped key file.
+ *
+ * The message is prepared once (see MessageEncoder), the recipients are split into contiguous ranges among the threads.
+ *
+ * @throws IncorrectInputVectorLength if the message is not of length block_size.
+ * @param message A vector of length block_size.
+ * @param keys The second blocks of the public keys, num_recipients * block_size elements, key after key.
+ * @param num_recipients The number of public keys.
+ * @param block_size The block size of all the keys.
+ * @param num_threads The number of threads, 0 uses the hardware concurrency.
+ * @return The encoded messages in the order of the keys, each of length 2*block_size.
+ */
+template<typename T>
+auto encode_for_recipients(const std::vector<T>& message, const T* keys, size_t num_recipients, size_t block_size,
+                           size_t num_threads = 0) -> std::vector<std::vector<T>> {
+    if (message.size() != block_size) {
+        throw IncorrectInputVectorLength{};
+    }
+    MessageEncoder<T> encoder{message};
+    std::vector<std::vector<T>> out(num_recipients);
+    if (num_threads == 0) {
+        num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    num_threads = std::min(num_threads, std::max<size_t>(1, num_recipients));
+    auto work = [&](size_t first, size_t last) {
+        for (size_t r = first; r < last; ++r) {
+            out[r] = encoder.encode(keys + r * block_size);
+        }
+    };
+    std::vector<std::thread> threads;
+    size_t chunk = (num_recipients + num_threads - 1) / num_threads;
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(work, std::min(t * chunk, num_recipients), std::min((t + 1) * chunk, num_recipients));
+    }
+    work(0, std::min(chunk, num_recipients));
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    return out;
+}
+
+/**
+ * @brief Encode one message under the public keys of many encoding contexts.
+ *
+ * @throws IncorrectInputVectorLength if the message or a key is not of length block_size.
+ * @param message A vector of length block_size.
+ * @param recipients The encoding contexts, all of the same block size.
+ * @param num_threads The number of threads, 0 uses the hardware concurrency.
+ * @return The encoded messages in the order of the recipients, each of length 2*block_size.
+ */
+template<typename T>
+auto encode_for_recipients(const std::vector<T>& message, const std::vector<EncodingContext<T>>& recipients,
+                           size_t num_threads = 0) -> std::vector<std::vector<T>> {
+    size_t block_size = message.size();
+    std::vector<T> keys;
+    keys.reserve(recipients.size() * block_size);
+    for (const auto& recipient: recipients) {
+        const auto& key = recipient.get_second_block_G();
+        if (recipient.get_block_size() != block_size || key.size() != block_size) {
+            throw IncorrectInputVectorLength{};
+        }
+        keys.insert(keys.end(), key.begin(), key.end());
+    }
+    return encode_for_recipients(message, keys.data(), recipients.size(), block_size, num_threads);
+}
+
+#endif //MDPC_GF4_MULTI_RECIPIENT_H
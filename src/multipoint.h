@@ -0,0 +1,268 @@
+#ifndef MDPC_GF4_MULTIPOINT_H
+#define MDPC_GF4_MULTIPOINT_H
+
+#include <vector>
+#include <algorithm>
+#include "polynomial.h"
+#include "custom_exceptions.h"
+
+/*
+ * Below this degree of the divisor, SubproductTree divides by PolynomialGF2N::div_rem instead of multiplying
+ * by the inverse of the reversed divisor.
+ */
+#ifndef MDPC_GF4_NEWTON_DIVISION_THRESHOLD
+#define MDPC_GF4_NEWTON_DIVISION_THRESHOLD 64
+#endif
+
+/**
+ * @brief Get p mod x^precision, i.e. the first precision coefficients of p.
+ */
+template<typename T>
+auto truncate_polynomial(const PolynomialGF2N<T>& p, size_t precision) -> PolynomialGF2N<T> {
+    std::vector<T> coefficients;
+    for (size_t deg = 0; deg < precision && deg <= p.get_degree(); ++deg) {
+        coefficients.push_back(p.get_coefficient(deg));
+    }
+    return PolynomialGF2N<T>{coefficients};
+}
+
+/**
+ * @brief Get x^degree * p(1/x), i.e. the coefficients of p up to the given degree in reverse order.
+ *
+ * @param p A polynomial of degree at most the given degree.
+ */
+template<typename T>
+auto reverse_polynomial(const PolynomialGF2N<T>& p, size_t degree) -> PolynomialGF2N<T> {
+    std::vector<T> coefficients(degree + 1);
+    for (size_t deg = 0; deg <= std::min(degree, p.get_degree()); ++deg) {
+        coefficients[degree - deg] = p.get_coefficient(deg);
+    }
+    return PolynomialGF2N<T>{coefficients};
+}
+
+/**
+ * @brief Calculate the inverse of f mod x^precision by Newton iteration.
+ *
+ * If f g = 1 mod x^k, then f (f g^2) = (f g)^2 = 1 mod x^2k in characteristic 2,
+ * so every step doubles the precision at the cost of two multiplications.
+ *
+ * @param f A polynomial with a nonzero constant coefficient.
+ * @param precision The number of coefficients of the inverse, positive.
+ * @return The inverse of f mod x^precision.
+ */
+template<typename T>
+auto newton_inverse(const PolynomialGF2N<T>& f, size_t precision) -> PolynomialGF2N<T> {
+    PolynomialGF2N<T> g;
+    g.set_coefficient(0, T{1} / f.get_coefficient(0));
+    for (size_t k = 1; k < precision;) {
+        k = std::min(2 * k, precision);
+        g = truncate_polynomial(truncate_polynomial(f, k) * (g * g), k);
+    }
+    return g;
+}
+
+/**
+ * @brief Calculate a mod m by multiplying with the inverse of the reversed m.
+ *
+ * The quotient q of a by m has k = deg(a) - deg(m) + 1 coefficients and satisfies rev(a) = rev(q) rev(m) mod x^k,
+ * so rev(q) = rev(a) rev(m)^-1 mod x^k and the remainder is a - q m.
+ *
+ * @param a The dividend.
+ * @param m The divisor.
+ * @param inverse newton_inverse(reverse_polynomial(m, deg(m)), precision) for a precision of at least k.
+ * @return The remainder.
+ */
+template<typename T>
+auto remainder_by_inverse(const PolynomialGF2N<T>& a, const PolynomialGF2N<T>& m,
+                          const PolynomialGF2N<T>& inverse) -> PolynomialGF2N<T> {
+    if (a.get_degree() < m.get_degree()) {
+        return a;
+    }
+    size_t k = a.get_degree() - m.get_degree() + 1;
+    PolynomialGF2N<T> reversed_quotient = truncate_polynomial(
+            truncate_polynomial(reverse_polynomial(a, a.get_degree()), k) * truncate_polynomial(inverse, k), k);
+    PolynomialGF2N<T> quotient = reverse_polynomial(reversed_quotient, k - 1);
+    return truncate_polynomial(a + quotient * m, m.get_degree());
+}
+
+/**
+ * @brief Subproduct tree over a fixed set of points x_0, ..., x_{m-1}.
+ *
+ * The leaves are the polynomials (x - x_i), every inner node is the product of its children
+ * and the root is M(x) = prod_i (x - x_i). The tree depends only on the points, so it is built once
+ * and reused for any number of evaluations and interpolations over the same point set.
+ * The interpolation weights 1 / M'(x_i) are computed on the first interpolation and cached as well.
+ *
+ * Multipoint evaluation reduces the polynomial modulo the nodes from the root down to the leaves,
+ * interpolation combines the weighted values from the leaves up to the root.
+ * The multiplications are Karatsuba multiplications (see multiply_accumulate). The divisions multiply by the inverses
+ * of the reversed nodes (see remainder_by_inverse), which are precomputed with the tree, so a level of the tree costs
+ * a few multiplications of degree m in total. For a polynomial of degree below m, both take O(m^1.59 log m) operations
+ * instead of the O(m^2) of m Horner evaluations. Nodes of degree below MDPC_GF4_NEWTON_DIVISION_THRESHOLD are divided
+ * by the schoolbook division.
+ *
+ * @tparam T Finite field to be used, typically an extension field such as GF4Extension.
+ */
+template<typename T>
+class SubproductTree {
+public:
+    /**
+     * @brief Build the tree for the given points.
+     *
+     * @param points Pairwise distinct points.
+     */
+    explicit SubproductTree(const std::vector<T>& points) : points(points) {
+        std::vector<PolynomialGF2N<T>> leaves;
+        for (const T& x: points) {
+            PolynomialGF2N<T> leaf;
+            leaf.set_coefficient(1, T{1});
+            leaf.set_coefficient(0, x);  // x - x_i = x + x_i in characteristic 2
+            leaves.push_back(leaf);
+        }
+        levels.push_back(leaves);
+        while (levels.back().size() > 1) {
+            const auto& below = levels.back();
+            std::vector<PolynomialGF2N<T>> level;
+            for (size_t i = 0; i + 1 < below.size(); i += 2) {
+                level.push_back(below[i] * below[i + 1]);
+            }
+            if (below.size() % 2 == 1) {
+                level.push_back(below.back());
+            }
+            levels.push_back(level);
+        }
+        // the remainder passed down to a node has a lower degree than its parent, which bounds the quotient
+        for (size_t l = 0; l + 1 < levels.size(); ++l) {
+            std::vector<PolynomialGF2N<T>> level;
+            level.reserve(levels[l].size());
+            for (size_t i = 0; i < levels[l].size(); ++i) {
+                const auto& node = levels[l][i];
+                size_t precision = levels[l + 1][i / 2].get_degree() - node.get_degree();
+                if (node.get_degree() < MDPC_GF4_NEWTON_DIVISION_THRESHOLD || precision == 0) {
+                    level.emplace_back();
+                } else {
+                    level.push_back(newton_inverse(reverse_polynomial(node, node.get_degree()), precision));
+                }
+            }
+            inverses.push_back(level);
+        }
+    }
+
+    [[nodiscard]] auto get_points() const -> const std::vector<T>& {
+        return points;
+    }
+
+    /**
+     * @brief Get the product of (x - x_i) over all points.
+     *
+     * @return The root of the tree.
+     */
+    [[nodiscard]] auto get_root() const -> const PolynomialGF2N<T>& {
+        return levels.back()[0];
+    }
+
+    /**
+     * @brief Evaluate the polynomial at all points.
+     *
+     * @param p The polynomial.
+     * @return The values p(x_0), ..., p(x_{m-1}).
+     */
+    [[nodiscard]] auto evaluate(const PolynomialGF2N<T>& p) const -> std::vector<T> {
+        if (points.empty()) {
+            return {};
+        }
+        const auto& root = get_root();
+        PolynomialGF2N<T> reduced = p;
+        if (p.get_degree() >= root.get_degree()) {
+            reduced = (root.get_degree() < MDPC_GF4_NEWTON_DIVISION_THRESHOLD) ? p % root:
+                    remainder_by_inverse(p, root, newton_inverse(reverse_polynomial(root, root.get_degree()),
+                                                                 p.get_degree() - root.get_degree() + 1));
+        }
+        std::vector<PolynomialGF2N<T>> remainders{reduced};
+        for (size_t l = levels.size() - 1; l > 0; --l) {
+            const auto& below = levels[l - 1];
+            std::vector<PolynomialGF2N<T>> next;
+            next.reserve(below.size());
+            for (size_t i = 0; i < below.size(); ++i) {
+                if (inverses[l - 1][i].is_zero()) {
+                    next.push_back(remainders[i / 2] % below[i]);
+                } else {
+                    next.push_back(remainder_by_inverse(remainders[i / 2], below[i], inverses[l - 1][i]));
+                }
+            }
+            remainders = std::move(next);
+        }
+        std::vector<T> values;
+        values.reserve(points.size());
+        for (const auto& r: remainders) {
+            values.push_back(r.get_coefficient(0));
+        }
+        return values;
+    }
+
+    /**
+     * @brief Find the polynomial of degree less than the number of points with the given values at the points.
+     *
+     * This is Lagrange interpolation p(x) = sum_i y_i / M'(x_i) * M(x) / (x - x_i),
+     * where the sum is accumulated along the tree.
+     *
+     * @throws IncorrectInputVectorLength if the number of values differs from the number of points.
+     * @param values The values y_0, ..., y_{m-1}.
+     * @return The interpolating polynomial.
+     */
+    auto interpolate(const std::vector<T>& values) -> PolynomialGF2N<T> {
+        if (values.size() != points.size()) {
+            throw IncorrectInputVectorLength{};
+        }
+        if (points.empty()) {
+            return PolynomialGF2N<T>::make_zero();
+        }
+        if (weights.empty()) {
+            weights = evaluate(get_root().derivative());
+        }
+        std::vector<PolynomialGF2N<T>> partial;
+        partial.reserve(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            PolynomialGF2N<T> c;
+            c.set_coefficient(0, values[i] / weights[i]);
+            partial.push_back(c);
+        }
+        for (size_t l = 0; l + 1 < levels.size(); ++l) {
+            const auto& level = levels[l];
+            std::vector<PolynomialGF2N<T>> next;
+            for (size_t i = 0; i + 1 < level.size(); i += 2) {
+                next.push_back(partial[i] * level[i + 1] + partial[i + 1] * level[i]);
+            }
+            if (level.size() % 2 == 1) {
+                next.push_back(partial.back());
+            }
+            partial = std::move(next);
+        }
+        return partial[0];
+    }
+
+private:
+    std::vector<T> points;
+    std::vector<std::vector<PolynomialGF2N<T>>> levels;
+    std::vector<std::vector<PolynomialGF2N<T>>> inverses;   ///< inverses[l][i] for levels[l][i], zero if not used
+    std::vector<T> weights;
+};
+
+/**
+ * @brief Embed a polynomial over a field into a polynomial over its extension field.
+ *
+ * @tparam E The extension field, constructible from an element of T (e.g. GF4Extension from GF4).
+ * @tparam T The base field.
+ * @param p The polynomial over T.
+ * @return The same polynomial over E.
+ */
+template<typename E, typename T>
+auto embed_polynomial(const PolynomialGF2N<T>& p) -> PolynomialGF2N<E> {
+    PolynomialGF2N<E> out;
+    for (size_t deg = 0; deg <= p.get_degree(); ++deg) {
+        out.set_coefficient(deg, E{p.get_coefficient(deg)});
+    }
+    return out;
+}
+
+#endif //MDPC_GF4_MULTIPOINT_H
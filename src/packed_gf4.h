@@ -0,0 +1,311 @@
+#ifndef MDPC_GF4_PACKED_GF4_H
+#define MDPC_GF4_PACKED_GF4_H
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "gf4.h"
+#include "custom_exceptions.h"
+
+/**
+ * @brief Multiply all four symbols packed in a byte by a scalar of GF(4).
+ *
+ * A symbol b0 + b1*alpha is multiplied by mixing its bits as in BitslicedGF4Vector, here for the two bits
+ * of each of the four symbols at once.
+ */
+constexpr auto packed_gf4_multiply_byte(uint8_t scalar, uint8_t byte) -> uint8_t {
+    uint8_t lo = byte & 0x55u;
+    uint8_t hi = (byte >> 1) & 0x55u;
+    switch (scalar) {
+        case 0:
+            return 0;
+        case 1:
+            return byte;
+        case 2:
+            return (uint8_t)(hi | ((lo ^ hi) << 1));
+        default:  // scalar == 3
+            return (uint8_t)((lo ^ hi) | (lo << 1));
+    }
+}
+
+constexpr auto make_packed_gf4_multiplication() -> std::array<std::array<uint8_t, 256>, 4> {
+    std::array<std::array<uint8_t, 256>, 4> tables{};
+    for (size_t scalar = 0; scalar < 4; ++scalar) {
+        for (size_t byte = 0; byte < 256; ++byte) {
+            tables[scalar][byte] = packed_gf4_multiply_byte((uint8_t)scalar, (uint8_t)byte);
+        }
+    }
+    return tables;
+}
+
+/**
+ * @brief PACKED_GF4_MULTIPLICATION[a][x] is the byte x of four packed symbols multiplied by a.
+ */
+static constexpr std::array<std::array<uint8_t, 256>, 4> PACKED_GF4_MULTIPLICATION = make_packed_gf4_multiplication();
+
+/**
+ * @brief A vector over GF(4) stored as four symbols per byte.
+ *
+ * The symbol i is stored in the bits 2*(i mod 4) and 2*(i mod 4) + 1 of the byte i / 4, the lower bit is b0
+ * of the element b0 + b1*alpha (see GF4), i.e. its value 0..3. This is the wire format of the vectors
+ * and of the key file records (see pack_symbols). Addition is a XOR of 64-bit words and multiplication by a scalar
+ * is a lookup in one of the 256-entry tables PACKED_GF4_MULTIPLICATION per byte.
+ *
+ * The storage is padded to whole 64-bit words, bits beyond size() are always zero.
+ */
+class PackedGF4Vector {
+public:
+    /**
+     * @brief Construct a zero vector of the given length.
+     *
+     * @param length The number of elements.
+     */
+    explicit PackedGF4Vector(size_t length = 0) : bytes(padded_bytes(length)), length(length) {}
+
+    /**
+     * @brief Pack a vector of GF4 elements.
+     *
+     * @param vec The vector to pack.
+     */
+    explicit PackedGF4Vector(const std::vector<GF4>& vec) : PackedGF4Vector(vec.size()) {
+        for (size_t i = 0; i < vec.size(); ++i) {
+            bytes[i / 4] |= (uint8_t)(vec[i].get_value() << (2 * (i % 4)));
+        }
+    }
+
+    /**
+     * @brief Take a vector in the wire format.
+     *
+     * @param data The packed symbols, (length + 3) / 4 bytes.
+     * @param length The number of elements.
+     * @return The vector.
+     */
+    static auto from_bytes(const uint8_t* data, size_t length) -> PackedGF4Vector {
+        PackedGF4Vector vec{length};
+        std::memcpy(vec.bytes.data(), data, (length + 3) / 4);
+        vec.clear_tail();
+        return vec;
+    }
+
+    /**
+     * @brief Unpack the vector.
+     *
+     * @return A vector of GF4 elements.
+     */
+    [[nodiscard]] auto to_vector() const -> std::vector<GF4> {
+        std::vector<GF4> out;
+        out.reserve(length);
+        for (size_t i = 0; i < length; ++i) {
+            out.push_back(get(i));
+        }
+        return out;
+    }
+
+    [[nodiscard]] auto size() const -> size_t {
+        return length;
+    }
+
+    /**
+     * @brief Get the packed symbols in the wire format, the first (size() + 3) / 4 bytes are the vector.
+     */
+    [[nodiscard]] auto data() const -> const uint8_t* {
+        return bytes.data();
+    }
+
+    [[nodiscard]] auto get(size_t i) const -> GF4 {
+        return GF4{(size_t)((bytes[i / 4] >> (2 * (i % 4))) & 3u)};
+    }
+
+    auto set(size_t i, const GF4& value) -> void {
+        unsigned shift = 2 * (i % 4);
+        bytes[i / 4] = (uint8_t)((bytes[i / 4] & ~(3u << shift)) | (value.get_value() << shift));
+    }
+
+    /**
+     * @brief Add a multiple of another vector to this vector, i.e. this += scalar * other.
+     *
+     * @throws IncorrectInputVectorLength if the vectors differ in length.
+     * @param other The vector to add.
+     * @param scalar The multiple of the other vector.
+     */
+    auto add_multiple(const PackedGF4Vector& other, const GF4& scalar) -> void {
+        if (other.length != length) {
+            throw IncorrectInputVectorLength{};
+        }
+        if (scalar.get_value() == 1) {
+            xor_words(bytes.data(), other.bytes.data(), bytes.size());
+        } else if (!scalar.is_zero()) {
+            const auto& table = PACKED_GF4_MULTIPLICATION[scalar.get_value()];
+            for (size_t k = 0; k < bytes.size(); ++k) {
+                bytes[k] ^= table[other.bytes[k]];
+            }
+        }
+    }
+
+    auto operator+=(const PackedGF4Vector& other) -> PackedGF4Vector& {
+        add_multiple(other, GF4{1});
+        return *this;
+    }
+
+    auto operator*=(const GF4& scalar) -> PackedGF4Vector& {
+        const auto& table = PACKED_GF4_MULTIPLICATION[scalar.get_value()];
+        for (uint8_t& byte: bytes) {
+            byte = table[byte];
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Get the elements first, ..., first + count - 1.
+     *
+     * @param first The index of the first element.
+     * @param count The number of elements, first + count must be at most size().
+     * @return The elements.
+     */
+    [[nodiscard]] auto slice(size_t first, size_t count) const -> PackedGF4Vector {
+        PackedGF4Vector out{count};
+        size_t offset = first / 4;
+        unsigned shift = 2 * (first % 4);
+        size_t out_bytes = (count + 3) / 4;
+        for (size_t j = 0; j < out_bytes; ++j) {
+            unsigned pair = bytes[offset + j];
+            if (offset + j + 1 < bytes.size()) {
+                pair |= (unsigned)bytes[offset + j + 1] << 8;
+            }
+            out.bytes[j] = (uint8_t)(pair >> shift);
+        }
+        out.clear_tail();
+        return out;
+    }
+
+    /**
+     * @brief Append the elements of another vector.
+     *
+     * @param other The vector to append.
+     */
+    auto append(const PackedGF4Vector& other) -> void {
+        size_t offset = length / 4;
+        unsigned shift = 2 * (length % 4);
+        length += other.length;
+        bytes.resize(padded_bytes(length));
+        size_t other_bytes = (other.length + 3) / 4;
+        for (size_t j = 0; j < other_bytes; ++j) {
+            bytes[offset + j] |= (uint8_t)(other.bytes[j] << shift);
+            if (shift != 0 && offset + j + 1 < bytes.size()) {
+                bytes[offset + j + 1] |= (uint8_t)(other.bytes[j] >> (8 - shift));
+            }
+        }
+    }
+
+    /**
+     * @brief Rotate the vector cyclically, i.e. out[i] = this[(i + shift) mod n].
+     *
+     * @param shift The rotation.
+     * @return The rotated vector.
+     */
+    [[nodiscard]] auto rotate(size_t shift) const -> PackedGF4Vector {
+        if (length == 0) {
+            return *this;
+        }
+        shift %= length;
+        PackedGF4Vector out = slice(shift, length - shift);
+        out.append(slice(0, shift));
+        return out;
+    }
+
+    [[nodiscard]] auto is_zero() const -> bool {
+        return std::all_of(bytes.begin(), bytes.end(), [](uint8_t byte) { return byte == 0; });
+    }
+
+    /**
+     * @brief Get the hamming weight of the vector, i.e. the number of nonzero elements.
+     *
+     * A symbol is nonzero iff either of its two bits is set, so the weight is the population count of
+     * the OR of both bits of every pair.
+     *
+     * @return The number of nonzero elements.
+     */
+    [[nodiscard]] auto hamming_weight() const -> size_t {
+        size_t weight = 0;
+        for (size_t k = 0; k < bytes.size(); k += 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes.data() + k, 8);
+            weight += __builtin_popcountll((word | (word >> 1)) & 0x5555555555555555u);
+        }
+        return weight;
+    }
+
+    /**
+     * @brief Add sum_a a * (sum_{k in groups[a - 1]} rotate(vec, k)) to out, i.e. out[r] += sum_k h[k] * vec[(r + k) mod n]
+     * for the vector h whose offsets with value a are groups[a - 1].
+     *
+     * The doubled vector vec || vec is stored shifted by 0, 1, 2 and 3 symbols, so every rotation is a byte-aligned window
+     * into one of the four copies. The windows of each group are summed by XOR of words and the three sums are multiplied
+     * by table lookups at the end. This is the product of a circulant matrix and the vector, see SparseCirculant.
+     *
+     * @throws IncorrectInputVectorLength if the vectors differ in length.
+     * @param groups The offsets of the nonzero entries of h by their value.
+     * @param vec The vector to multiply.
+     * @param out The vector to add the product to.
+     */
+    static auto circulant_multiply_accumulate(const std::array<std::vector<size_t>, 3>& groups, const PackedGF4Vector& vec,
+                                              PackedGF4Vector& out) -> void {
+        if (out.length != vec.length) {
+            throw IncorrectInputVectorLength{};
+        }
+        size_t n = vec.length;
+        size_t window_bytes = padded_bytes(n);
+        PackedGF4Vector doubled = vec;
+        doubled.append(vec);
+        std::array<PackedGF4Vector, 4> copies;
+        for (size_t s = 0; s < 4 && s < 2 * n; ++s) {
+            copies[s] = doubled.slice(s, 2 * n - s);
+            // the last window reads up to a word beyond the doubled vector
+            copies[s].bytes.resize(window_bytes + (2 * n) / 4 + 8);
+        }
+        PackedGF4Vector accumulator{n};
+        for (size_t g = 0; g < groups.size(); ++g) {
+            if (groups[g].empty()) {
+                continue;
+            }
+            std::fill(accumulator.bytes.begin(), accumulator.bytes.end(), 0);
+            for (size_t k: groups[g]) {
+                xor_words(accumulator.bytes.data(), copies[k % 4].bytes.data() + k / 4, window_bytes);
+            }
+            // the windows extend beyond n symbols
+            accumulator.clear_tail();
+            out.add_multiple(accumulator, GF4{g + 1});
+        }
+    }
+
+private:
+    static auto padded_bytes(size_t length) -> size_t {
+        return (length + 31) / 32 * 8;
+    }
+
+    static auto xor_words(uint8_t* dst, const uint8_t* src, size_t count) -> void {
+        for (size_t k = 0; k < count; k += 8) {
+            uint64_t a;
+            uint64_t b;
+            std::memcpy(&a, dst + k, 8);
+            std::memcpy(&b, src + k, 8);
+            a ^= b;
+            std::memcpy(dst + k, &a, 8);
+        }
+    }
+
+    auto clear_tail() -> void {
+        size_t used = (length + 3) / 4;
+        std::fill(bytes.begin() + used, bytes.end(), 0);
+        if (length % 4 != 0) {
+            bytes[used - 1] &= (uint8_t)((1u << (2 * (length % 4))) - 1);
+        }
+    }
+
+    std::vector<uint8_t> bytes;
+    size_t length;
+};
+
+#endif //MDPC_GF4_PACKED_GF4_H
@@ -0,0 +1,256 @@
+#ifndef MDPC_GF4_PARAMETER_SETS_H
+#define MDPC_GF4_PARAMETER_SETS_H
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <optional>
+#include <cstdint>
+#include <cstring>
+#include "gf4.h"
+#include "contexts.h"
+#include "binary_image.h"
+#include "factorization.h"
+#include "field_traits.h"
+#include "key_file.h"
+#include "custom_exceptions.h"
+
+/**
+ * @brief A monic irreducible factor of x^n - 1.
+ */
+struct FactorTable {
+    size_t degree;
+    size_t multiplicity;
+    const uint8_t* packed;   ///< The degree + 1 coefficients, lowest first, packed by pack_symbols.
+};
+
+/**
+ * @brief The kernels chosen for a parameter set, by measuring the alternatives at its parameters.
+ */
+struct KernelChoice {
+    bool binary_first_pass;      ///< Start the decoding with BinaryImageDecoder, for fields with a binary image (see FieldTraits).
+    size_t half_gcd_threshold;   ///< The threshold of the inversion in the key generation, see PolynomialGF2N::invert.
+};
+
+/**
+ * @brief A named parameter set together with everything derived from its parameters.
+ *
+ * The factorization of x^n - 1, the decoder policies, the iteration budget and the kernel choices are computed
+ * once when the set is added (see the tables below) and compiled in, so a deployment using a registered set
+ * does no derivation work at startup.
+ */
+struct ParameterSet {
+    const char* name;
+    size_t field_size;                     ///< The size of the field of the symbols.
+    size_t block_size;
+    size_t block_weight;
+    size_t error_weight;                   ///< The hamming weight of the error vectors of the encryption.
+    size_t num_iterations;                 ///< The iteration budget of the decoder.
+    StagnationPolicy stagnation;
+    PostProcessingPolicy post_processing;
+    BinaryFlippingPolicy binary_flipping;
+    KernelChoice kernels;
+    const FactorTable* factors;            ///< The irreducible factors of x^block_size - 1 over the field, sorted by degree.
+    size_t num_factors;
+};
+
+/*
+ * x^2339 - 1 over GF(4): 2339 is prime and ord_2339(4) = 1169, so x^2339 - 1 = (x + 1) * f_1 * f_2
+ * with f_1, f_2 irreducible of degree 1169 (see factor_x_n_minus_1), which takes 0.6 s to compute.
+ */
+static constexpr uint8_t GF4_X2339_MINUS_1_FACTOR_0[] = {
+    0x05,
+};
+static constexpr uint8_t GF4_X2339_MINUS_1_FACTOR_1[] = {
+    0x8d, 0xa5, 0xbc, 0x6b, 0x4d, 0xee, 0x96, 0x57, 0xf2, 0x50, 0x3a, 0xfb, 0x6d, 0x09, 0x63, 0xe5,
+    0xcc, 0x5d, 0x36, 0x50, 0x9b, 0x21, 0xa8, 0x78, 0x77, 0x24, 0x2d, 0x73, 0x84, 0x7a, 0xa6, 0x12,
+    0xaf, 0x85, 0x2c, 0xf6, 0xed, 0xdc, 0xed, 0x75, 0xa3, 0xb8, 0x53, 0x6e, 0x6a, 0xa1, 0x34, 0x39,
+    0x0e, 0xbe, 0xcd, 0x0e, 0xdf, 0xab, 0x05, 0x0b, 0x05, 0x0e, 0xce, 0xba, 0x3d, 0xb9, 0x02, 0xac,
+    0xbd, 0x5e, 0x5e, 0xeb, 0x1e, 0xe0, 0x9d, 0xd3, 0xd1, 0x19, 0x58, 0x6f, 0xb3, 0xca, 0x21, 0x29,
+    0xd5, 0xa5, 0x95, 0xcb, 0x95, 0x3d, 0x06, 0x4f, 0xa1, 0x87, 0x31, 0xf9, 0xad, 0xda, 0x71, 0xf0,
+    0x56, 0x13, 0x92, 0x64, 0x58, 0x28, 0x45, 0x51, 0xa6, 0x08, 0xed, 0x7b, 0xee, 0xd3, 0xc1, 0x2b,
+    0xf9, 0x9a, 0xd3, 0xf7, 0x76, 0x2f, 0xa3, 0xe2, 0x39, 0xf0, 0x86, 0xbc, 0xd4, 0x99, 0x84, 0x73,
+    0x24, 0x94, 0xe6, 0xe1, 0x81, 0x03, 0x3f, 0x39, 0xd8, 0x67, 0xb9, 0x4a, 0xda, 0xf2, 0x25, 0xdd,
+    0xac, 0xbd, 0xb5, 0xf6, 0x62, 0xc6, 0xa5, 0x6c, 0x1f, 0xbf, 0xd7, 0x69, 0x83, 0x87, 0x0a, 0x38,
+    0xe4, 0xe4, 0x7d, 0xc1, 0x91, 0x38, 0x71, 0x67, 0xb1, 0x32, 0xad, 0x80, 0xe7, 0xfc, 0xc8, 0x9a,
+    0xad, 0x69, 0x78, 0xaf, 0xc7, 0x2b, 0x64, 0xe8, 0x9e, 0xeb, 0x06, 0xf3, 0x5d, 0x14, 0xc5, 0x53,
+    0xd3, 0x71, 0x4c, 0x58, 0xad, 0x90, 0x64, 0xff, 0xa6, 0x87, 0x34, 0xf9, 0x14, 0x0a, 0x8d, 0x76,
+    0x25, 0x7b, 0xf5, 0x65, 0xc5, 0xc7, 0x24, 0xbf, 0xd8, 0x5a, 0x43, 0x67, 0x64, 0x78, 0xe6, 0x40,
+    0xee, 0x5b, 0x5e, 0xbe, 0xf6, 0x02, 0xbc, 0x87, 0xb6, 0x2f, 0x0e, 0x0e, 0x05, 0x0b, 0xf5, 0x6b,
+    0x0a, 0x2e, 0xb6, 0x0e, 0x8e, 0x87, 0xf1, 0xd4, 0xdf, 0x5e, 0xb8, 0xf3, 0x98, 0xe5, 0x66, 0xe2,
+    0xa6, 0xcd, 0x32, 0xf5, 0x4a, 0xfc, 0x9d, 0x3f, 0x91, 0xc8, 0xc6, 0x91, 0x99, 0xf3, 0xc3, 0x74,
+    0x5b, 0x80, 0x5d, 0x26, 0xe2, 0xd5, 0x08, 0xd7, 0xa6, 0x8b, 0x5f, 0xa0, 0x5c, 0x79, 0xed, 0x1e,
+    0xd6, 0xbb, 0xf2, 0x35, 0x06,
+};
+static constexpr uint8_t GF4_X2339_MINUS_1_FACTOR_2[] = {
+    0xc9, 0xf5, 0xe8, 0x7e, 0x49, 0xbb, 0xd7, 0x56, 0xa3, 0x50, 0x2f, 0xae, 0x79, 0x0d, 0x72, 0xb5,
+    0x88, 0x59, 0x27, 0x50, 0xde, 0x31, 0xfc, 0x6c, 0x66, 0x34, 0x39, 0x62, 0xc4, 0x6f, 0xf7, 0x13,
+    0xfa, 0xc5, 0x38, 0xa7, 0xb9, 0x98, 0xb9, 0x65, 0xf2, 0xec, 0x52, 0x7b, 0x7f, 0xf1, 0x24, 0x2d,
+    0x0b, 0xeb, 0x89, 0x0b, 0x9a, 0xfe, 0x05, 0x0e, 0x05, 0x0b, 0x8b, 0xef, 0x29, 0xed, 0x03, 0xf8,
+    0xe9, 0x5b, 0x5b, 0xbe, 0x1b, 0xb0, 0xd9, 0x92, 0x91, 0x1d, 0x5c, 0x7a, 0xe2, 0x8f, 0x31, 0x3d,
+    0x95, 0xf5, 0xd5, 0x8e, 0xd5, 0x29, 0x07, 0x4a, 0xf1, 0xc6, 0x21, 0xad, 0xf9, 0x9f, 0x61, 0xa0,
+    0x57, 0x12, 0xd3, 0x74, 0x5c, 0x3c, 0x45, 0x51, 0xf7, 0x0c, 0xb9, 0x6e, 0xbb, 0x92, 0x81, 0x3e,
+    0xad, 0xdf, 0x92, 0xa6, 0x67, 0x3a, 0xf2, 0xb3, 0x2d, 0xa0, 0xc7, 0xe8, 0x94, 0xdd, 0xc4, 0x62,
+    0x34, 0xd4, 0xb7, 0xb1, 0xc1, 0x02, 0x2a, 0x2d, 0x9c, 0x76, 0xed, 0x4f, 0x9f, 0xa3, 0x35, 0x99,
+    0xf8, 0xe9, 0xe5, 0xa7, 0x73, 0x87, 0xf5, 0x78, 0x1a, 0xea, 0x96, 0x7d, 0xc2, 0xc6, 0x0f, 0x2c,
+    0xb4, 0xb4, 0x69, 0x81, 0xd1, 0x2c, 0x61, 0x76, 0xe1, 0x23, 0xf9, 0xc0, 0xb6, 0xa8, 0x8c, 0xdf,
+    0xf9, 0x7d, 0x6c, 0xfa, 0x86, 0x3e, 0x74, 0xbc, 0xdb, 0xbe, 0x07, 0xa2, 0x59, 0x14, 0x85, 0x52,
+    0x92, 0x61, 0x48, 0x5c, 0xf9, 0xd0, 0x74, 0xaa, 0xf7, 0xc6, 0x24, 0xad, 0x14, 0x0f, 0xc9, 0x67,
+    0x35, 0x6e, 0xa5, 0x75, 0x85, 0x86, 0x34, 0xea, 0x9c, 0x5f, 0x42, 0x76, 0x74, 0x6c, 0xb7, 0x40,
+    0xbb, 0x5e, 0x5b, 0xeb, 0xa7, 0x03, 0xe8, 0xc6, 0xe7, 0x3a, 0x0b, 0x0b, 0x05, 0x0e, 0xa5, 0x7e,
+    0x0f, 0x3b, 0xe7, 0x0b, 0xcb, 0xc6, 0xa1, 0x94, 0x9a, 0x5b, 0xec, 0xa2, 0xdc, 0xb5, 0x77, 0xb3,
+    0xf7, 0x89, 0x23, 0xa5, 0x4f, 0xa8, 0xd9, 0x2a, 0xd1, 0x8c, 0x87, 0xd1, 0xdd, 0xa2, 0x82, 0x64,
+    0x5e, 0xc0, 0x59, 0x37, 0xb3, 0x95, 0x0c, 0x96, 0xf7, 0xce, 0x5a, 0xf0, 0x58, 0x6d, 0xb9, 0x1b,
+    0x97, 0xee, 0xa3, 0x25, 0x07,
+};
+
+static constexpr FactorTable GF4_X2339_MINUS_1_FACTORS[] = {
+    {1, 1, GF4_X2339_MINUS_1_FACTOR_0},
+    {1169, 1, GF4_X2339_MINUS_1_FACTOR_1},
+    {1169, 1, GF4_X2339_MINUS_1_FACTOR_2},
+};
+
+/*
+ * gf4-2339-37: the parameters recommended in the README. Measured with 400 decodings per error weight on 20 keys:
+ *  + the decoder needs about one iteration per error, t = 84 still decodes within 100 iterations,
+ *    t = 90 fails 2 of 400; the error weight is 2 * block_weight = 74 with the budget of 100 iterations,
+ *  + no successful decoding stalled or oscillated, the windows are the calibrated ones (StagnationPolicy::calibrate)
+ *    with a margin of 3,
+ *  + the binary first pass is off: it was faster at t = 74 over 40 decodings, but that is no sample to compare
+ *    its failure rate with the one of the GF(4) decoder (see tests/binary_image_test.cpp),
+ *  + the classical inversion on bit-sliced coefficients is used, as for every block size below 131072.
+ */
+static constexpr ParameterSet PARAMETER_SETS[] = {
+    {"gf4-2339-37", 4, 2339, 37, 74, 100, StagnationPolicy{4, 4}, PostProcessingPolicy{}, BinaryFlippingPolicy{},
+     KernelChoice{false, MDPC_GF4_HALF_GCD_THRESHOLD_BITSLICED}, GF4_X2339_MINUS_1_FACTORS, 3},
+};
+
+/**
+ * @brief Get a registered parameter set by its name.
+ *
+ * @throws UnknownParameterSet if there is no set of this name.
+ * @param name The name, e.g. "gf4-2339-37".
+ * @return The parameter set.
+ */
+inline auto get_parameter_set(const std::string& name) -> const ParameterSet& {
+    for (const ParameterSet& set: PARAMETER_SETS) {
+        if (name == set.name) {
+            return set;
+        }
+    }
+    throw UnknownParameterSet{};
+}
+
+/**
+ * @brief Find the registered parameter set of the given parameters.
+ *
+ * @tparam T Finite field to be used.
+ * @param block_size The size of the circulant block of the matrices.
+ * @param block_weight The hamming weight of the row of the block of the matrix H.
+ * @return The parameter set, or nullptr if these parameters are not registered.
+ */
+template<typename T>
+auto find_parameter_set(size_t block_size, size_t block_weight) -> const ParameterSet* {
+    for (const ParameterSet& set: PARAMETER_SETS) {
+        if (set.field_size == field_size<T>() && set.block_size == block_size && set.block_weight == block_weight) {
+            return &set;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Get the factorization of x^block_size - 1 from the tables of a parameter set.
+ *
+ * @throws UnknownParameterSet if the set is not over T.
+ * @tparam T Finite field to be used.
+ * @param set The parameter set.
+ * @return Pairs (g, e) of monic irreducible g and multiplicity e, as factor_x_n_minus_1 returns them.
+ */
+template<typename T>
+auto parameter_set_factors(const ParameterSet& set) -> std::vector<std::tuple<PolynomialGF2N<T>, size_t>> {
+    if (set.field_size != field_size<T>()) {
+        throw UnknownParameterSet{};
+    }
+    std::vector<std::tuple<PolynomialGF2N<T>, size_t>> out;
+    for (size_t i = 0; i < set.num_factors; ++i) {
+        const FactorTable& factor = set.factors[i];
+        out.emplace_back(PolynomialGF2N<T>{unpack_symbols<T>(factor.packed, field_bits<T>(), factor.degree + 1)}, factor.multiplicity);
+    }
+    return out;
+}
+
+/**
+ * @brief Generate a key pair of a parameter set, see generate_contexts_over_GF2N.
+ *
+ * @throws UnknownParameterSet if the set is not over T.
+ * @tparam T Finite field to be used.
+ * @param set The parameter set.
+ * @return Instantiated classes EncodingContext and DecodingContext.
+ */
+template<typename T>
+auto generate_contexts(const ParameterSet& set) -> std::tuple<EncodingContext<T>, DecodingContext<T>> {
+    if (set.field_size != field_size<T>()) {
+        throw UnknownParameterSet{};
+    }
+    KeyBlocks<T> blocks = generate_key_blocks<T>(set.block_size, set.block_weight, set.kernels.half_gcd_threshold);
+    EncodingContext<T> ec{blocks.second_block_G, set.block_size};
+    DecodingContext<T> dc{blocks.h0, blocks.h1, set.block_size, set.block_weight};
+    return std::make_tuple(ec, dc);
+}
+
+/**
+ * @brief A decoder which runs the kernels and policies of a parameter set.
+ *
+ * The decoding context must outlive the decoder.
+ *
+ * @tparam T Finite field to be used.
+ */
+template<typename T>
+class ParameterSetDecoder {
+public:
+    /**
+     * @brief Prepare the kernels of the parameter set for a key.
+     *
+     * @throws UnknownParameterSet if the set is not over T or not of the block size of the key.
+     * @param dc The decoding context holding the private key.
+     * @param set The parameter set.
+     */
+    ParameterSetDecoder(const DecodingContext<T>& dc, const ParameterSet& set) : dc(dc), set(set) {
+        if (set.field_size != field_size<T>() || set.block_size != dc.get_block_size()) {
+            throw UnknownParameterSet{};
+        }
+        if constexpr (FieldTraits<T>::has_binary_image) {
+            if (set.kernels.binary_first_pass) {
+                binary.emplace(dc, set.binary_flipping);
+            }
+        }
+    }
+
+    /**
+     * @brief Decode with the iteration budget and the policies of the parameter set.
+     *
+     * @throws IncorrectInputVectorLength if the message is not of length 2*block_size.
+     * @param message A vector of length 2*block_size.
+     * @return The result of decoding.
+     */
+    [[nodiscard]] auto decode_with_report(const std::vector<T>& message) const -> DecodingResult<T> {
+        if constexpr (FieldTraits<T>::has_binary_image) {
+            if (binary.has_value()) {
+                return binary->decode_with_report(message, set.num_iterations, set.stagnation, set.post_processing);
+            }
+        }
+        return dc.decode_with_report(message, set.num_iterations, set.stagnation, set.post_processing);
+    }
+
+    [[nodiscard]] auto decode(const std::vector<T>& message) const -> std::optional<std::vector<T>> {
+        return decode_with_report(message).error_vector;
+    }
+
+private:
+    const DecodingContext<T>& dc;
+    const ParameterSet& set;
+    std::optional<BinaryImageDecoder> binary;
+};
+
+#endif //MDPC_GF4_PARAMETER_SETS_H
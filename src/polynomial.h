@@ -1,11 +1,14 @@
 #ifndef MDPC_GF4_POLYNOMIAL_H
 #define MDPC_GF4_POLYNOMIAL_H
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <optional>
 #include <tuple>
 #include "custom_exceptions.h"
+#include "small_vector.h"
+#include "vector_utils.h"
 #include "xgcd.h"
 
 
@@ -13,6 +16,8 @@
  * @brief An implementation of polynomial over a GF(2^N) field.
  *
  * This class provides polynomial operations for polynomials over finite fields GF(2^N) for some natural number N.
+ * Coefficients of low degree polynomials are stored inline (see SmallVector and inline_capacity),
+ * which avoids allocations in the base cases of half_gcd and full_gcd.
  *
  * @tparam T Finite field to be used, it is expected to define all methods that GF4 defines and be of type GF(2^N).
  */
@@ -50,13 +55,7 @@ public:
                     degree = i;
                 }
             }
-            if (degree != 0) {
-                coefficients = coeffs;
-                coefficients.resize(degree + 1);
-            } else {
-                coefficients = {};
-                coefficients.push_back(T{0});
-            }
+            coefficients.assign(coeffs.data(), coeffs.data() + degree + 1);
         }
     }
 
@@ -97,12 +96,8 @@ public:
                     break;
                 }
             }
-            if (degree == 0) {
-                coefficients = {};
-            } else {
-                coefficients.resize(degree + 1);
-            }
-        } else {
+            coefficients.resize(degree + 1);
+        } else if (deg <= get_degree()) {
             coefficients[deg] = value;
         }
     }
@@ -135,7 +130,7 @@ public:
      * @return A vector of coefficients of the polynomial.
      */
     [[nodiscard]] auto to_vector() const -> std::vector<T> {
-        return coefficients;
+        return coefficients.to_vector();
     }
 
     /**
@@ -181,42 +176,24 @@ public:
 
     auto operator+(const PolynomialGF2N<T>& other) const -> PolynomialGF2N<T> {
         if (get_degree() > other.get_degree()) { // DO NOT change to >=
-            PolynomialGF2N<T> out;
-            out.coefficients.resize(get_degree() + 1);
-            for (size_t i = 0; i <= get_degree(); ++i) {
-                out.coefficients[i] = coefficients[i] + other.get_coefficient(i);
-            }
+            PolynomialGF2N<T> out{*this};
+            add_multiple(out.coefficients.data(), other.coefficients.data(), other.get_degree() + 1, T{1});
             return out;
         } else {
-            PolynomialGF2N<T> out;
-            out.coefficients.resize(other.get_degree() + 1);
-            size_t degree = 0;
-            for (size_t i = 0; i <= other.get_degree(); ++i) {
-                out.coefficients[i] = get_coefficient(i) + other.coefficients[i];
-                if (!out.coefficients[i].is_zero()) {
-                    degree = i;
-                }
-            }
-            out.coefficients.resize(degree + 1);
+            PolynomialGF2N<T> out{other};
+            add_multiple(out.coefficients.data(), coefficients.data(), get_degree() + 1, T{1});
+            out.remove_leading_zeros();
             return out;
         }
     }
 
     auto operator+=(const PolynomialGF2N<T>& other) -> PolynomialGF2N<T>& {
         if (get_degree() > other.get_degree()) { // DO NOT change to >=
-            for (size_t i = 0; i <= other.get_degree(); ++i) {
-                coefficients[i] += other.coefficients[i];
-            }
+            add_multiple(coefficients.data(), other.coefficients.data(), other.get_degree() + 1, T{1});
         } else {
             coefficients.resize(other.get_degree() + 1);
-            size_t degree = 0;
-            for (size_t i = 0; i <= other.get_degree(); ++i) {
-                coefficients[i] += other.coefficients[i];
-                if (!coefficients[i].is_zero()) {
-                    degree = i;
-                }
-            }
-            coefficients.resize(degree + 1);
+            add_multiple(coefficients.data(), other.coefficients.data(), other.get_degree() + 1, T{1});
+            remove_leading_zeros();
         }
         return *this;
     }
@@ -230,61 +207,37 @@ public:
         return *this;
     }
 
+    /**
+     * @brief Multiply two polynomials.
+     *
+     * Long operands are multiplied by Karatsuba multiplication, see multiply_accumulate.
+     */
     auto operator*(const PolynomialGF2N<T>& other) const -> PolynomialGF2N<T> {
         PolynomialGF2N<T> out;
-        out.coefficients.resize(get_degree() + other.get_degree() + 1);
-        size_t degree = 0;
-        for (size_t i = 0; i <= get_degree(); ++i) {
-            for (size_t j = 0; j <= other.get_degree(); ++j) {
-                out.coefficients[i+j] += (coefficients[i] * other.coefficients[j]);
-                if (!out.coefficients[i+j].is_zero() && (i+j) > degree) {
-                    degree = i + j;
-                }
-            }
+        if (is_zero() || other.is_zero()) {
+            return out;
         }
-        out.coefficients.resize(degree + 1);
+        out.coefficients.resize(get_degree() + other.get_degree() + 1);
+        multiply_accumulate(out.coefficients.data(), coefficients.data(), get_degree() + 1,
+                            other.coefficients.data(), other.get_degree() + 1);
+        out.remove_leading_zeros();
         return out;
     }
 
     auto operator*=(const PolynomialGF2N<T>& other) -> PolynomialGF2N<T>& {
-        std::vector<T> new_coefficients;
-        new_coefficients.resize(get_degree() + other.get_degree() + 1);
-        size_t degree = 0;
-        for (size_t i = 0; i <= get_degree(); ++i) {
-            for (size_t j = 0; j <= other.degree; ++j) {
-                new_coefficients[i+j] += (coefficients[i] * other.coefficients[j]);
-                if (!coefficients[i+j].is_zero() && (i+j) > degree) {
-                    degree = i + j;
-                }
-            }
-        }
-        new_coefficients.resize(degree + 1);
-        coefficients = new_coefficients;
+        *this = *this * other;
         return *this;
     }
 
     auto operator*(const T& scalar) const -> PolynomialGF2N<T> {
         PolynomialGF2N<T> out{*this};
-        size_t max_deg = 0;
-        for (size_t deg = 0; deg <= out.degree; ++deg) {
-            out.coefficients[deg] *= scalar;
-            if (!out.coefficients[deg].is_zero()) {
-                max_deg = deg;
-            }
-        }
-        out.coefficients.resize(max_deg + 1);
+        out *= scalar;
         return out;
     }
 
     auto operator*=(const T& scalar) -> PolynomialGF2N<T>& {
-        size_t max_deg = 0;
-        for (size_t deg = 0; deg <= get_degree(); ++deg) {
-            coefficients[deg] *= scalar;
-            if (!coefficients[deg].is_zero()) {
-                max_deg = deg;
-            }
-        }
-        coefficients.resize(max_deg + 1);
+        multiply_by(coefficients.data(), get_degree() + 1, scalar);
+        remove_leading_zeros();
         return *this;
     }
 
@@ -309,16 +262,29 @@ public:
             PolynomialGF2N<T> q;
             PolynomialGF2N<T> r{*this};
 
-            T other_lead = other.coefficients[other.get_degree()];
+            size_t other_degree = other.get_degree();
+            T other_lead_inverse = T{1} / other.coefficients[other_degree];
+            q.coefficients.resize(get_degree() - other_degree + 1);
 
-            while (!r.is_zero() && r.get_degree() >= other.get_degree()) {
-                PolynomialGF2N<T> t;
-                size_t t_degree = r.get_degree() - other.get_degree();
-                t.coefficients.resize(t_degree + 1);
-                t.coefficients[t_degree] = r.coefficients[r.get_degree()] / other_lead;
-                q += t;
-                r -= (t * other);
+            // eliminate the leading coefficients of r in place, from the highest power down
+            for (size_t deg = r.get_degree(); deg >= other_degree; --deg) {
+                T c = r.coefficients[deg] * other_lead_inverse;
+                if (!c.is_zero()) {
+                    q.coefficients[deg - other_degree] = c;
+                    add_multiple(r.coefficients.data() + deg - other_degree, other.coefficients.data(), other_degree + 1, c);
+                }
+                if (deg == 0) {
+                    break;
+                }
             }
+            size_t r_degree = 0;
+            for (size_t i = std::min(r.get_degree(), other_degree); i > 0; --i) {
+                if (!r.coefficients[i].is_zero()) {
+                    r_degree = i;
+                    break;
+                }
+            }
+            r.coefficients.resize(r_degree + 1);
             return std::make_tuple(q, r);
         }
     }
@@ -333,17 +299,14 @@ public:
      * @param deg
      * @return
      */
-    auto div_x_to_deg(size_t deg) -> PolynomialGF2N<T> {
-        if (deg < get_degree()) {
+    [[nodiscard]] auto div_x_to_deg(size_t deg) const -> PolynomialGF2N<T> {
+        if (deg > get_degree()) {
+            return PolynomialGF2N<T>{};
+        } else {
             PolynomialGF2N<T> out{*this};
             out.coefficients.erase(out.coefficients.begin(), out.coefficients.begin() + deg);
             return out;
-        } else if (deg == get_degree()) {
-            return PolynomialGF2N<T>{};
-        } else {
-            return *this;
         }
-
     }
 
     auto operator/(const PolynomialGF2N<T>& other) const -> PolynomialGF2N<T> {
@@ -398,18 +361,22 @@ public:
     /**
      * @brief Calculate the multiplicative inverse of the polynomial mod the provided modulus.
      *
-     * This implements extended euclidean algorithm.
+     * This implements extended euclidean algorithm using half-gcd, see full_gcd.
      *
      * @param modulus A polynomial.
+     * @param threshold Degree below which the classical euclidean algorithm is used.
      * @return Multiplicative inverse of the polynomial if it exists, nothing otherwise.
      */
-    auto invert(const PolynomialGF2N<T>& modulus) const -> std::optional<PolynomialGF2N<T>> {
+    auto invert(const PolynomialGF2N<T>& modulus, size_t threshold = default_half_gcd_threshold<T>()) const -> std::optional<PolynomialGF2N<T>> {
         if (modulus.is_zero()) {
             throw DivisionByZero{};
         }
         PolynomialGF2N<T> a = modulus;
         PolynomialGF2N<T> b = *this % modulus;
-        auto tr = std::get<1>(full_gcd(a, b));
+        if (b.is_zero()) {
+            return {};
+        }
+        auto tr = std::get<1>(full_gcd(a, b, threshold));
         auto g = tr.a11 * a - tr.a01 * b;
         if(g.get_degree() != 0) {
             return {};
@@ -418,6 +385,35 @@ public:
         }
     }
 
+    /**
+     * @brief Evaluate the polynomial at the given point using Horner's scheme.
+     *
+     * @param x The point.
+     * @return The value of the polynomial at x.
+     */
+    [[nodiscard]] auto evaluate(const T& x) const -> T {
+        T out = coefficients[get_degree()];
+        for (size_t deg = get_degree(); deg > 0; --deg) {
+            out = out * x + coefficients[deg - 1];
+        }
+        return out;
+    }
+
+    /**
+     * @brief Calculate the formal derivative of the polynomial.
+     *
+     * In characteristic 2, the derivative of c_k x^k is c_k x^(k-1) for odd k and zero for even k.
+     *
+     * @return The formal derivative.
+     */
+    [[nodiscard]] auto derivative() const -> PolynomialGF2N<T> {
+        PolynomialGF2N<T> out;
+        for (size_t deg = 1; deg <= get_degree(); deg += 2) {
+            out.set_coefficient(deg - 1, coefficients[deg]);
+        }
+        return out;
+    }
+
     static auto make_zero() -> PolynomialGF2N<T> {
         return PolynomialGF2N<T>{};
     }
@@ -429,8 +425,24 @@ public:
         return out;
     }
 
+    /**
+     * @brief Polynomials of degree below this value store their coefficients inline, without allocating memory.
+     */
+    static constexpr size_t inline_capacity = 33;
+
 private:
-    std::vector<T> coefficients;
+    SmallVector<T, inline_capacity> coefficients;
+
+    /**
+     * @brief Drop the zero coefficients above the highest nonzero one, keeping at least the constant coefficient.
+     */
+    auto remove_leading_zeros() -> void {
+        size_t degree = get_degree();
+        while (degree > 0 && coefficients[degree].is_zero()) {
+            --degree;
+        }
+        coefficients.resize(degree + 1);
+    }
     inline static const T zero{0};
 };
 
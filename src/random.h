@@ -8,6 +8,8 @@
 
 /**
  * @brief Random class is a singleton used to generate random integers, vectors and polynomials.
+ *
+ * Every thread has its own instance with its own seed, so Random can be used from several threads at once.
  */
 class Random {
 private:
@@ -15,11 +17,11 @@ private:
     Random() = default;
 
     /**
-     * @brief Get the instance of Random.
+     * @brief Get the instance of Random of the calling thread.
      * @return Instance of Random.
      */
     static auto get() -> Random& {
-        static Random instance;
+        static thread_local Random instance;
         return instance;
     }
 
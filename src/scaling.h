@@ -0,0 +1,386 @@
+#ifndef MDPC_GF4_SCALING_H
+#define MDPC_GF4_SCALING_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <optional>
+#include <memory>
+#include <algorithm>
+#include "contexts.h"
+#include "polynomial.h"
+#include "xgcd.h"
+#include "random.h"
+
+/**
+ * @brief A kernel whose running time is measured as a function of the size n.
+ *
+ * prepare builds the inputs of size n outside of the measured time and returns the call to measure.
+ */
+struct ScalingKernel {
+    std::string name;
+    std::function<std::function<void()>(size_t n)> prepare;
+};
+
+/**
+ * @brief The measured running times of a kernel and the fitted model seconds = constant * n^exponent.
+ */
+struct ScalingFit {
+    std::string name;
+    std::vector<std::pair<size_t, double>> samples;   ///< (n, seconds per call)
+    double exponent = 0.0;
+    double constant = 0.0;
+
+    /**
+     * @brief Get the running time predicted by the model.
+     *
+     * @param n The size.
+     * @return Seconds per call.
+     */
+    [[nodiscard]] auto predict(double n) const -> double {
+        return constant * std::pow(n, exponent);
+    }
+};
+
+/**
+ * @brief Get the geometric range of sizes min_n, min_n * r, ..., max_n with the given number of steps.
+ *
+ * @param min_n The smallest size.
+ * @param max_n The largest size.
+ * @param steps The number of sizes, at least 2.
+ * @return The sizes, rounded to odd numbers (as block sizes are).
+ */
+inline auto geometric_sizes(size_t min_n, size_t max_n, size_t steps) -> std::vector<size_t> {
+    std::vector<size_t> sizes;
+    steps = std::max<size_t>(2, steps);
+    for (size_t i = 0; i < steps; ++i) {
+        double n = (double)min_n * std::pow((double)max_n / (double)min_n, (double)i / (double)(steps - 1));
+        size_t odd = ((size_t)std::llround(n)) | 1u;
+        if (sizes.empty() || odd > sizes.back()) {
+            sizes.push_back(odd);
+        }
+    }
+    return sizes;
+}
+
+/**
+ * @brief Measure the time of one call of the kernel.
+ *
+ * The call is repeated until min_seconds have passed, in rounds of doubling length, and the fastest round is taken,
+ * which filters out most of the noise from other processes.
+ *
+ * @param call The call to measure.
+ * @param min_seconds The total time to spend.
+ * @return Seconds per call.
+ */
+inline auto measure_call(const std::function<void()>& call, double min_seconds) -> double {
+    using clock = std::chrono::steady_clock;
+    double best = INFINITY;
+    double total = 0.0;
+    size_t repetitions = 1;
+    while (total < min_seconds || best == INFINITY) {
+        auto start = clock::now();
+        for (size_t i = 0; i < repetitions; ++i) {
+            call();
+        }
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        total += elapsed;
+        best = std::min(best, elapsed / (double)repetitions);
+        if (elapsed < min_seconds / 8) {
+            repetitions *= 2;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Fit seconds = constant * n^exponent by least squares on log(seconds) = log(constant) + exponent * log(n).
+ *
+ * @param fit The fit whose samples are used and whose exponent and constant are set.
+ */
+inline auto fit_power_law(ScalingFit& fit) -> void {
+    double count = (double)fit.samples.size();
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (auto [n, seconds]: fit.samples) {
+        double x = std::log((double)n);
+        double y = std::log(seconds);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double denominator = count * sxx - sx * sx;
+    fit.exponent = (denominator != 0) ? (count * sxy - sx * sy) / denominator : 0.0;
+    fit.constant = std::exp((sy - fit.exponent * sx) / count);
+}
+
+/**
+ * @brief Measure the kernels over the given sizes and fit their complexity.
+ *
+ * The measurements are interleaved: every round measures all kernels at all sizes and the fastest time
+ * of each over all rounds is kept. A slow phase of the machine then affects a single round instead of
+ * the largest sizes of one kernel, which would skew its exponent.
+ *
+ * @param kernels The kernels.
+ * @param sizes The sizes, see geometric_sizes.
+ * @param min_seconds The time spent measuring each kernel at each size in total.
+ * @param rounds The number of rounds.
+ * @return The fits in the order of the kernels.
+ */
+inline auto run_scaling(const std::vector<ScalingKernel>& kernels, const std::vector<size_t>& sizes, double min_seconds,
+                        size_t rounds = 3) -> std::vector<ScalingFit> {
+    std::vector<std::vector<std::function<void()>>> calls;
+    std::vector<ScalingFit> fits;
+    for (const auto& kernel: kernels) {
+        calls.emplace_back();
+        ScalingFit fit;
+        fit.name = kernel.name;
+        for (size_t n: sizes) {
+            calls.back().push_back(kernel.prepare(n));
+            fit.samples.emplace_back(n, INFINITY);
+        }
+        fits.push_back(fit);
+    }
+    rounds = std::max<size_t>(1, rounds);
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t k = 0; k < kernels.size(); ++k) {
+            for (size_t i = 0; i < sizes.size(); ++i) {
+                double seconds = measure_call(calls[k][i], min_seconds / (double)rounds);
+                fits[k].samples[i].second = std::min(fits[k].samples[i].second, seconds);
+            }
+        }
+    }
+    for (auto& fit: fits) {
+        fit_power_law(fit);
+    }
+    return fits;
+}
+
+/**
+ * @brief Get the kernels whose scaling is tracked: encoding, syndrome, decoding, polynomial arithmetic and gcd.
+ *
+ * The keys are random vectors of the given weight (not generated keys), so any n can be used.
+ * With a fixed block weight, calculate_syndrome is expected to be linear in n and encode quadratic.
+ * decode_setup is a decoding stopped after its first iteration, i.e. the syndrome and the scores of all candidates,
+ * while decode_iteration is one further iteration of a session prepared outside of the measured time.
+ *
+ * @tparam T Finite field to be used.
+ * @param block_weight The hamming weight of the rows of H.
+ * @param error_weight The hamming weight of the errors decoded by the decode_setup kernel.
+ * @return The kernels.
+ */
+template<typename T>
+auto standard_scaling_kernels(size_t block_weight = 37, size_t error_weight = 37) -> std::vector<ScalingKernel> {
+    auto random_polynomial = [](size_t degree) {
+        std::vector<T> coefficients = Random::random_vector_over_GF2N<T>(degree + 1);
+        coefficients[degree] = T{1};
+        return PolynomialGF2N<T>{coefficients};
+    };
+    auto x_n_minus_1 = [](size_t n) {
+        PolynomialGF2N<T> modulus;
+        modulus.set_coefficient(0, T{1});
+        modulus.set_coefficient(n, T{1});
+        return modulus;
+    };
+    std::vector<ScalingKernel> kernels;
+    kernels.push_back({"encode", [](size_t n) -> std::function<void()> {
+        EncodingContext<T> ec{Random::random_vector_over_GF2N<T>(n), n};
+        std::vector<T> message = Random::random_vector_over_GF2N<T>(n);
+        return [ec, message]() { ec.encode(message); };
+    }});
+    kernels.push_back({"calculate_syndrome", [block_weight](size_t n) -> std::function<void()> {
+        DecodingContext<T> dc{Random::random_weighted_vector_over_GF2N<T>(n, block_weight),
+                              Random::random_weighted_vector_over_GF2N<T>(n, block_weight), n, block_weight};
+        std::vector<T> vec = Random::random_vector_over_GF2N<T>(2 * n);
+        return [dc, vec]() { dc.calculate_syndrome(vec); };
+    }});
+    kernels.push_back({"decode_setup", [block_weight, error_weight](size_t n) -> std::function<void()> {
+        DecodingContext<T> dc{Random::random_weighted_vector_over_GF2N<T>(n, block_weight),
+                              Random::random_weighted_vector_over_GF2N<T>(n, block_weight), n, block_weight};
+        std::vector<T> error_vector = Random::random_weighted_vector_over_GF2N<T>(2 * n, std::min(error_weight, n));
+        return [dc, error_vector]() {
+            dc.decode_with_report(error_vector, 1, StagnationPolicy::disabled(), PostProcessingPolicy::disabled());
+        };
+    }});
+    kernels.push_back({"decode_iteration", [block_weight](size_t n) -> std::function<void()> {
+        auto dc = std::make_shared<DecodingContext<T>>(Random::random_weighted_vector_over_GF2N<T>(n, block_weight),
+                                                       Random::random_weighted_vector_over_GF2N<T>(n, block_weight),
+                                                       n, block_weight);
+        // a random vector is far from every codeword, so the session keeps running however often it is advanced
+        std::vector<T> message = Random::random_vector_over_GF2N<T>(2 * n);
+        auto session = std::make_shared<DecodingSession<T>>(dc->start_decoding(message, StagnationPolicy::disabled()));
+        // the first iteration computes the scores of all candidates, which belongs to decode_setup
+        session->advance(1);
+        auto prepared = std::make_shared<const DecodingSession<T>>(*session);
+        return [dc, session, prepared]() {
+            if (session->advance(1)) {
+                *session = *prepared;
+            }
+        };
+    }});
+    kernels.push_back({"multiply", [random_polynomial](size_t n) -> std::function<void()> {
+        PolynomialGF2N<T> a = random_polynomial(n - 1);
+        PolynomialGF2N<T> b = random_polynomial(n - 1);
+        return [a, b]() { a * b; };
+    }});
+    kernels.push_back({"div_rem", [random_polynomial, x_n_minus_1](size_t n) -> std::function<void()> {
+        PolynomialGF2N<T> a = random_polynomial(2 * n - 2);
+        PolynomialGF2N<T> modulus = x_n_minus_1(n);
+        return [a, modulus]() { a.div_rem(modulus); };
+    }});
+    kernels.push_back({"half_gcd", [random_polynomial, x_n_minus_1](size_t n) -> std::function<void()> {
+        PolynomialGF2N<T> a = x_n_minus_1(n);
+        PolynomialGF2N<T> b = random_polynomial(n - 1);
+        return [a, b]() { half_gcd(a, b); };
+    }});
+    kernels.push_back({"invert", [random_polynomial, x_n_minus_1](size_t n) -> std::function<void()> {
+        PolynomialGF2N<T> a = random_polynomial(n - 1);
+        PolynomialGF2N<T> modulus = x_n_minus_1(n);
+        return [a, modulus]() { a.invert(modulus); };
+    }});
+    return kernels;
+}
+
+/**
+ * @brief Write the fits as JSON.
+ *
+ * @param out The stream to write to.
+ * @param fits The fits.
+ */
+inline auto write_scaling_report(std::ostream& out, const std::vector<ScalingFit>& fits) -> void {
+    out.precision(17);
+    out << "{\n  \"kernels\": [\n";
+    for (size_t i = 0; i < fits.size(); ++i) {
+        const ScalingFit& fit = fits[i];
+        out << "    {\"name\": \"" << fit.name << "\", \"exponent\": " << fit.exponent << ", \"constant\": " << fit.constant
+            << ", \"samples\": [";
+        for (size_t s = 0; s < fit.samples.size(); ++s) {
+            out << (s == 0 ? "" : ", ") << "[" << fit.samples[s].first << ", " << fit.samples[s].second << "]";
+        }
+        out << "]}" << (i + 1 < fits.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+/**
+ * @brief Read fits written by write_scaling_report.
+ *
+ * Only the structure written by write_scaling_report is understood (whitespace may differ),
+ * the samples of each kernel are read as pairs of numbers.
+ *
+ * @param in The stream to read from.
+ * @return The fits, nothing if the input is malformed.
+ */
+inline auto read_scaling_report(std::istream& in) -> std::optional<std::vector<ScalingFit>> {
+    std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    std::vector<ScalingFit> fits;
+    std::optional<ScalingFit> current;
+    std::string key;
+    std::vector<double> numbers;
+    size_t depth = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '{') {
+            ++depth;
+            if (!current && depth == 2) {
+                current = ScalingFit{};
+                numbers.clear();
+            }
+            key.clear();
+        } else if (c == '}') {
+            if (current && depth == 2) {
+                if (numbers.size() % 2 != 0) {
+                    return {};
+                }
+                for (size_t s = 0; s + 1 < numbers.size(); s += 2) {
+                    current->samples.emplace_back((size_t)numbers[s], numbers[s + 1]);
+                }
+                fits.push_back(*current);
+                current.reset();
+            }
+            if (depth == 0) {
+                return {};
+            }
+            --depth;
+        } else if (c == '"') {
+            size_t end = text.find('"', i + 1);
+            if (end == std::string::npos) {
+                return {};
+            }
+            std::string value = text.substr(i + 1, end - i - 1);
+            i = end;
+            size_t next = text.find_first_not_of(" \t\r\n", i + 1);
+            if (next != std::string::npos && text[next] == ':') {
+                key = value;
+                i = next;
+            } else if (current && key == "name") {
+                current->name = value;
+            }
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            char* end = nullptr;
+            double value = std::strtod(text.c_str() + i, &end);
+            i = (size_t)(end - text.c_str()) - 1;
+            if (!current) {
+                continue;
+            }
+            if (key == "exponent") {
+                current->exponent = value;
+            } else if (key == "constant") {
+                current->constant = value;
+            } else if (key == "samples") {
+                numbers.push_back(value);
+            }
+        }
+    }
+    if (depth != 0) {
+        return {};
+    }
+    return fits;
+}
+
+/**
+ * @brief A kernel whose scaling changed between two reports.
+ */
+struct ScalingRegression {
+    std::string name;
+    double baseline_exponent;
+    double exponent;
+    double time_ratio;   ///< Predicted time at the reference size, current / baseline.
+};
+
+/**
+ * @brief Compare the fits with a baseline and flag the kernels whose scaling moved.
+ *
+ * A kernel is flagged if its exponent changed by more than exponent_tolerance, or if the time predicted at
+ * reference_n changed by more than the factor time_tolerance in either direction. Predicting at a large
+ * reference size (e.g. the production block size or beyond) catches constant factor changes and exponent changes alike.
+ *
+ * @param baseline The fits of the baseline.
+ * @param current The fits to check.
+ * @param reference_n The size at which the predicted times are compared.
+ * @param exponent_tolerance The allowed change of the exponent.
+ * @param time_tolerance The allowed factor between the predicted times.
+ * @return The flagged kernels, only the kernels present in both reports are compared.
+ */
+inline auto compare_scaling(const std::vector<ScalingFit>& baseline, const std::vector<ScalingFit>& current, double reference_n,
+                            double exponent_tolerance = 0.15, double time_tolerance = 1.5) -> std::vector<ScalingRegression> {
+    std::vector<ScalingRegression> regressions;
+    for (const auto& fit: current) {
+        auto old = std::find_if(baseline.begin(), baseline.end(), [&](const ScalingFit& f) { return f.name == fit.name; });
+        if (old == baseline.end()) {
+            continue;
+        }
+        double ratio = fit.predict(reference_n) / old->predict(reference_n);
+        if (std::abs(fit.exponent - old->exponent) > exponent_tolerance || ratio > time_tolerance || ratio * time_tolerance < 1) {
+            regressions.push_back(ScalingRegression{fit.name, old->exponent, fit.exponent, ratio});
+        }
+    }
+    return regressions;
+}
+
+#endif //MDPC_GF4_SCALING_H
@@ -0,0 +1,214 @@
+#ifndef MDPC_GF4_SCORING_H
+#define MDPC_GF4_SCORING_H
+
+#include <vector>
+#include <cstdint>
+#include "custom_exceptions.h"
+#include "gf4.h"
+#include "simd.h"
+#include "bucket_queue.h"
+
+/**
+ * @brief The scores of all flip candidates, kept up to date between the iterations of the decoder.
+ *
+ * sigma[j * q + i] is the decrease of the syndrome weight caused by flipping the position j by the i-th nonzero element
+ * (see MatchCounts), q = |T::nonzero_elements()|. The queue holds every position j with the key max_i sigma[j * q + i],
+ * so the best flip is found in O(1) and a change of a score costs O(1) (see BucketQueue).
+ */
+struct FlipScores {
+    std::vector<int32_t> sigma;
+    BucketQueue positions;
+    std::vector<size_t> value_index;   ///< value_index[a.get_value()] is the index of a in T::nonzero_elements().
+
+    [[nodiscard]] auto empty() const -> bool {
+        return sigma.empty();
+    }
+
+    /**
+     * @brief Get the index of the best nonzero element for a position, the first one among equal scores.
+     */
+    [[nodiscard]] auto best_value(size_t j, size_t q) const -> size_t {
+        size_t best = 0;
+        for (size_t i = 1; i < q; ++i) {
+            if (sigma[j * q + i] > sigma[j * q + best]) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief Update the key of a position in the queue after its scores changed.
+     */
+    auto requeue(size_t j, size_t q) -> void {
+        long key = sigma[j * q + best_value(j, q)];
+        if (key != positions.key(j)) {
+            positions.set(j, key);
+        }
+    }
+};
+
+/**
+ * @brief Match counts of a syndrome against all columns of a circulant block of H.
+ *
+ * The c-th column of a circulant block with first row h has the entry h[k] in the row (c - k) mod block_size.
+ * Flipping the position c by a adds a*h[k] to the syndrome entry s[(c - k) mod block_size] for every k in the support of h.
+ * Such a syndrome entry becomes zero iff s[(c - k) mod block_size] == a*h[k]
+ * and becomes nonzero iff s[(c - k) mod block_size] == 0. Therefore, the flip decreases the syndrome weight by
+ *  matches[i][c] - zero[c],
+ * where a = T::nonzero_elements()[i].
+ */
+struct MatchCounts {
+    std::vector<uint16_t> zero;                  ///< zero[c] = #{k in supp(h) : s[(c - k) mod n] == 0}
+    std::vector<std::vector<uint16_t>> matches;  ///< matches[i][c] = #{k in supp(h) : s[(c - k) mod n] == a_i*h[k]}
+
+    /**
+     * @brief Get the decrease of the syndrome weight caused by flipping the given column by the i-th nonzero element.
+     *
+     * @param i The index of the nonzero element in T::nonzero_elements().
+     * @param column The column of the block.
+     * @return The decrease of the syndrome weight, negative if the weight increases.
+     */
+    [[nodiscard]] auto sigma(size_t i, size_t column) const -> long {
+        return (long)matches[i][column] - (long)zero[column];
+    }
+};
+
+/**
+ * @brief Calculate the match counts of the syndrome against all columns of a circulant block.
+ *
+ * This is a sparse cyclic correlation. Instead of scanning the whole syndrome for each column (O(n^2)),
+ * the counts of all columns are accumulated at once by scattering from each nonzero h[k] (O(w*n)).
+ * This is the element-wise variant for any finite field.
+ *
+ * @tparam T Finite field to be used.
+ * @throws IncorrectInputVectorLength if the syndrome and h differ in length.
+ * @param syndrome The syndrome of length block_size.
+ * @param h The first row of the circulant block.
+ * @return The match counts of all block_size columns.
+ */
+template<typename T>
+auto match_counts(const std::vector<T>& syndrome, const std::vector<T>& h) -> MatchCounts {
+    if (syndrome.size() != h.size()) {
+        throw IncorrectInputVectorLength{};
+    }
+    size_t block_size = h.size();
+    std::vector<T> nonzero_values = T::nonzero_elements();
+    MatchCounts counts;
+    counts.zero.resize(block_size);
+    counts.matches.resize(nonzero_values.size(), std::vector<uint16_t>(block_size));
+    for (size_t k = 0; k < block_size; ++k) {
+        if (h[k].is_zero()) {
+            continue;
+        }
+        for (size_t c = 0; c < block_size; ++c) {
+            const T& s = syndrome[(block_size + c - k) % block_size];
+            if (s.is_zero()) {
+                counts.zero[c] += 1;
+                continue;
+            }
+            for (size_t i = 0; i < nonzero_values.size(); ++i) {
+                if ((s + nonzero_values[i] * h[k]).is_zero()) {
+                    counts.matches[i][c] += 1;
+                    break;
+                }
+            }
+        }
+    }
+    return counts;
+}
+
+/**
+ * @brief Calculate the match counts of the syndrome against all columns of a circulant block over GF(4).
+ *
+ * One byte per symbol variant. The syndrome is copied twice in a row into a byte buffer, so the rotation by k
+ * is a contiguous window of the buffer. The window is compared with 0 and the three constants a*h[k]
+ * SimdBytes::width columns at a time and the comparison masks are subtracted from byte counters.
+ * Byte counters cannot overflow as long as h has at most 255 nonzero entries, heavier rows use 16-bit scalar counters.
+ *
+ * @throws IncorrectInputVectorLength if the syndrome and h differ in length.
+ * @param syndrome The syndrome of length block_size.
+ * @param h The first row of the circulant block.
+ * @return The match counts of all block_size columns.
+ */
+inline auto match_counts(const std::vector<GF4>& syndrome, const std::vector<GF4>& h) -> MatchCounts {
+    if (syndrome.size() != h.size()) {
+        throw IncorrectInputVectorLength{};
+    }
+    size_t block_size = h.size();
+    constexpr size_t width = SimdBytes::width;
+    size_t padded_size = ((block_size + width - 1) / width) * width;
+    std::vector<uint8_t> doubled;
+    doubled.resize(2 * block_size + width);
+    for (size_t i = 0; i < block_size; ++i) {
+        doubled[i] = syndrome[i].get_value();
+        doubled[block_size + i] = syndrome[i].get_value();
+    }
+    size_t weight = 0;
+    for (const GF4& value: h) {
+        weight += (size_t)!value.is_zero();
+    }
+
+    MatchCounts counts;
+    counts.zero.resize(block_size);
+    counts.matches.resize(3, std::vector<uint16_t>(block_size));
+    if (weight <= 255) {
+        // counters[v * padded_size + c], v = 0 counts zeros, v = 1..3 counts matches of the nonzero element v
+        std::vector<uint8_t> counters;
+        counters.resize(4 * padded_size);
+        const SimdBytes zero = SimdBytes::broadcast(0);
+        for (size_t k = 0; k < block_size; ++k) {
+            uint8_t hk = h[k].get_value();
+            if (hk == 0) {
+                continue;
+            }
+            const SimdBytes targets[4] = {
+                zero,
+                SimdBytes::broadcast(GF4_MULTIPLICATION[1][hk]),
+                SimdBytes::broadcast(GF4_MULTIPLICATION[2][hk]),
+                SimdBytes::broadcast(GF4_MULTIPLICATION[3][hk]),
+            };
+            const uint8_t* rotated = doubled.data() + block_size - k;  // rotated[c] = s[(c - k) mod n]
+            for (size_t c = 0; c < padded_size; c += width) {
+                SimdBytes s = SimdBytes::load(rotated + c);
+                for (size_t v = 0; v < 4; ++v) {
+                    uint8_t* counter = counters.data() + v * padded_size + c;
+                    (SimdBytes::load(counter) - s.cmpeq(targets[v])).store(counter);
+                }
+            }
+        }
+        for (size_t c = 0; c < block_size; ++c) {
+            counts.zero[c] = counters[c];
+            counts.matches[0][c] = counters[padded_size + c];
+            counts.matches[1][c] = counters[2 * padded_size + c];
+            counts.matches[2][c] = counters[3 * padded_size + c];
+        }
+        return counts;
+    }
+
+    uint16_t* zero = counts.zero.data();
+    uint16_t* m1 = counts.matches[0].data();
+    uint16_t* m2 = counts.matches[1].data();
+    uint16_t* m3 = counts.matches[2].data();
+    for (size_t k = 0; k < block_size; ++k) {
+        uint8_t hk = h[k].get_value();
+        if (hk == 0) {
+            continue;
+        }
+        // nonzero_elements() of GF4 are 1, 2, 3 in this order
+        const uint8_t t1 = GF4_MULTIPLICATION[1][hk];
+        const uint8_t t2 = GF4_MULTIPLICATION[2][hk];
+        const uint8_t t3 = GF4_MULTIPLICATION[3][hk];
+        const uint8_t* rotated = doubled.data() + block_size - k;
+        for (size_t c = 0; c < block_size; ++c) {
+            uint8_t s = rotated[c];
+            zero[c] += (uint16_t)(s == 0);
+            m1[c] += (uint16_t)(s == t1);
+            m2[c] += (uint16_t)(s == t2);
+            m3[c] += (uint16_t)(s == t3);
+        }
+    }
+    return counts;
+}
+
+#endif //MDPC_GF4_SCORING_H
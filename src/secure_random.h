@@ -0,0 +1,156 @@
+#ifndef MDPC_GF4_SECURE_RANDOM_H
+#define MDPC_GF4_SECURE_RANDOM_H
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<sys/random.h>)
+#include <sys/random.h>
+#define MDPC_GF4_HAS_GETRANDOM
+#endif
+#include "custom_exceptions.h"
+
+/**
+ * @brief Random values from the cryptographically secure generator of the operating system.
+ *
+ * Random is a std::mt19937 seeded with 32 bits, so everything it generates can be reproduced by trying all seeds.
+ * It is meant for simulations. Secrets, such as the message and the error vector of encapsulate, are drawn here instead:
+ * the bytes come from getrandom(2) on Linux and from /dev/urandom elsewhere, buffered per thread.
+ * The interface mirrors Random.
+ */
+class SecureRandom {
+public:
+    /**
+     * @brief A uniform random bit generator over the bytes of the operating system, for the standard distributions.
+     */
+    class Engine {
+    public:
+        using result_type = uint64_t;
+
+        static constexpr auto min() -> result_type {
+            return 0;
+        }
+
+        static constexpr auto max() -> result_type {
+            return UINT64_MAX;
+        }
+
+        /**
+         * @throws RandomnessUnavailable if the operating system provides no random bytes.
+         */
+        auto operator()() -> result_type {
+            if (position == buffer.size()) {
+                fill(buffer.data(), buffer.size());
+                position = 0;
+            }
+            result_type value;
+            std::memcpy(&value, buffer.data() + position, sizeof(value));
+            // the used bytes are not kept in memory
+            std::memset(buffer.data() + position, 0, sizeof(value));
+            position += sizeof(value);
+            return value;
+        }
+
+    private:
+        static auto fill(uint8_t* out, size_t length) -> void {
+            size_t done = 0;
+#ifdef MDPC_GF4_HAS_GETRANDOM
+            while (done < length) {
+                ssize_t result = ::getrandom(out + done, length - done, 0);
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    break;
+                }
+                done += (size_t)result;
+            }
+#endif
+            if (done < length) {
+                int fd = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    throw RandomnessUnavailable{};
+                }
+                while (done < length) {
+                    ssize_t result = ::read(fd, out + done, length - done);
+                    if (result < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (result <= 0) {
+                        ::close(fd);
+                        throw RandomnessUnavailable{};
+                    }
+                    done += (size_t)result;
+                }
+                ::close(fd);
+            }
+        }
+
+        std::array<uint8_t, 256> buffer{};
+        size_t position = 256;
+    };
+
+    /**
+     * @brief Generate a random unsigned integer from the range [inclusive_low_bound, inclusive_high_bound].
+     *
+     * @throws RandomnessUnavailable if the operating system provides no random bytes.
+     */
+    template<typename T>
+    static auto integer(T inclusive_low_bound, T inclusive_high_bound) -> T {
+        return std::uniform_int_distribution<T>{inclusive_low_bound, inclusive_high_bound}(engine());
+    }
+
+    /**
+     * @brief Generate a random vector with given hamming weight, see Random::random_weighted_vector_over_GF2N.
+     *
+     * @throws ImpossibleHammingWeight if length < weight.
+     * @throws RandomnessUnavailable if the operating system provides no random bytes.
+     */
+    template<typename T>
+    static auto random_weighted_vector_over_GF2N(size_t length, size_t weight) -> std::vector<T> {
+        if (weight > length) {
+            throw ImpossibleHammingWeight{};
+        }
+        std::vector<T> out;
+        out.resize(length);
+        for (size_t i = 0; i < weight; ++i) {
+            out[i] = T{integer<size_t>(1, T::get_max_value())};
+        }
+        for (size_t i = 0; i < length; ++i) {
+            size_t j = integer(i, length - 1);
+            if (i != j) {
+                std::iter_swap(out.begin() + i, out.begin() + j);
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @brief Generate a random vector with values drawn from GF(2^n) uniformly at random.
+     *
+     * @throws RandomnessUnavailable if the operating system provides no random bytes.
+     */
+    template<typename T>
+    static auto random_vector_over_GF2N(size_t length) -> std::vector<T> {
+        std::vector<T> out;
+        out.reserve(length);
+        for (size_t i = 0; i < length; ++i) {
+            out.push_back(T{integer<size_t>(0, T::get_max_value())});
+        }
+        return out;
+    }
+
+private:
+    static auto engine() -> Engine& {
+        static thread_local Engine instance;
+        return instance;
+    }
+};
+
+#endif //MDPC_GF4_SECURE_RANDOM_H
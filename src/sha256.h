@@ -0,0 +1,140 @@
+#ifndef MDPC_GF4_SHA256_H
+#define MDPC_GF4_SHA256_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+/**
+ * @brief SHA-256 hash function (FIPS 180-4), used to derive symmetric keys (see hybrid.h).
+ *
+ * Data is absorbed by update in any number of parts, finalize returns the digest.
+ */
+class Sha256 {
+public:
+    Sha256() : state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+               buffer{}, buffered(0), total_length(0) {}
+
+    /**
+     * @brief Absorb data.
+     *
+     * @param data The data.
+     * @param length The number of bytes.
+     */
+    auto update(const uint8_t* data, size_t length) -> void {
+        total_length += length;
+        if (buffered != 0) {
+            size_t take = std::min(length, 64 - buffered);
+            std::memcpy(buffer.data() + buffered, data, take);
+            buffered += take;
+            data += take;
+            length -= take;
+            if (buffered < 64) {
+                return;
+            }
+            compress(buffer.data());
+            buffered = 0;
+        }
+        while (length >= 64) {
+            compress(data);
+            data += 64;
+            length -= 64;
+        }
+        std::memcpy(buffer.data(), data, length);
+        buffered = length;
+    }
+
+    /**
+     * @brief Pad the data and get the digest. The object must not be used afterwards.
+     *
+     * @return The 32 byte digest.
+     */
+    auto finalize() -> std::array<uint8_t, 32> {
+        uint64_t bit_length = total_length * 8;
+        uint8_t padding[72] = {0x80};
+        size_t padding_length = (buffered < 56) ? 56 - buffered : 120 - buffered;
+        for (size_t i = 0; i < 8; ++i) {
+            padding[padding_length + i] = (uint8_t)(bit_length >> (56 - 8 * i));
+        }
+        update(padding, padding_length + 8);
+        std::array<uint8_t, 32> digest{};
+        for (size_t i = 0; i < 8; ++i) {
+            for (size_t j = 0; j < 4; ++j) {
+                digest[4 * i + j] = (uint8_t)(state[i] >> (24 - 8 * j));
+            }
+        }
+        return digest;
+    }
+
+    /**
+     * @brief Hash data in one call.
+     *
+     * @param data The data.
+     * @param length The number of bytes.
+     * @return The 32 byte digest.
+     */
+    static auto hash(const uint8_t* data, size_t length) -> std::array<uint8_t, 32> {
+        Sha256 sha;
+        sha.update(data, length);
+        return sha.finalize();
+    }
+
+private:
+    static auto rotate_right(uint32_t x, unsigned n) -> uint32_t {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    auto compress(const uint8_t* block) -> void {
+        static const uint32_t k[64] = {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        uint32_t w[64];
+        for (size_t i = 0; i < 16; ++i) {
+            w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16) |
+                   ((uint32_t)block[4 * i + 2] << 8) | (uint32_t)block[4 * i + 3];
+        }
+        for (size_t i = 16; i < 64; ++i) {
+            uint32_t s0 = rotate_right(w[i - 15], 7) ^ rotate_right(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotate_right(w[i - 2], 17) ^ rotate_right(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (size_t i = 0; i < 64; ++i) {
+            uint32_t t1 = h + (rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    std::array<uint32_t, 8> state;
+    std::array<uint8_t, 64> buffer;
+    size_t buffered;
+    uint64_t total_length;
+};
+
+#endif //MDPC_GF4_SHA256_H
@@ -0,0 +1,238 @@
+#ifndef MDPC_GF4_SIMD_H
+#define MDPC_GF4_SIMD_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+/*
+ * The width of SimdBytes is selected by the instruction set the translation unit is compiled for,
+ * e.g. -mavx2 gives 32 byte vectors. Kernels written against SimdBytes are therefore compiled per ISA
+ * simply by compiling them with the corresponding flags. MDPC_GF4_SIMD_WIDTH may also be defined manually.
+ *
+ * With GCC and Clang, the vectors are backed by the vector extensions and compile to native instructions.
+ * Otherwise (or if MDPC_GF4_SIMD_EMULATE is defined), every operation is emulated by a loop over the bytes.
+ */
+#ifndef MDPC_GF4_SIMD_WIDTH
+#if defined(__AVX512BW__)
+#define MDPC_GF4_SIMD_WIDTH 64
+#elif defined(__AVX2__)
+#define MDPC_GF4_SIMD_WIDTH 32
+#else
+#define MDPC_GF4_SIMD_WIDTH 16
+#endif
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(MDPC_GF4_SIMD_EMULATE)
+#define MDPC_GF4_SIMD_NATIVE 1
+#else
+#define MDPC_GF4_SIMD_NATIVE 0
+#endif
+
+#if MDPC_GF4_SIMD_NATIVE
+template<size_t N>
+struct SimdNative;
+
+template<>
+struct SimdNative<16> {
+    typedef uint8_t type __attribute__((vector_size(16)));
+};
+
+template<>
+struct SimdNative<32> {
+    typedef uint8_t type __attribute__((vector_size(32)));
+};
+
+template<>
+struct SimdNative<64> {
+    typedef uint8_t type __attribute__((vector_size(64)));
+};
+#endif
+
+/**
+ * @brief A fixed-width vector of N bytes.
+ *
+ * Provides the operations needed by the GF(4) kernels: bitwise logic, byte-wise comparison,
+ * 16-entry table lookup (shuffle), byte-wise rotation of bits, element rotation and population count.
+ * Comparisons return masks with 0xFF in the matching bytes and 0x00 elsewhere.
+ *
+ * @tparam N The number of bytes, 16, 32 or 64.
+ */
+template<size_t N>
+class SimdU8 {
+public:
+    static constexpr size_t width = N;
+
+    SimdU8() : v{} {}
+
+    static auto load(const uint8_t* src) -> SimdU8<N> {
+        SimdU8<N> out;
+        std::memcpy(&out.v, src, N);
+        return out;
+    }
+
+    auto store(uint8_t* dst) const -> void {
+        std::memcpy(dst, &v, N);
+    }
+
+    static auto broadcast(uint8_t value) -> SimdU8<N> {
+        SimdU8<N> out;
+        for (size_t i = 0; i < N; ++i) {
+            out.v[i] = value;
+        }
+        return out;
+    }
+
+    [[nodiscard]] auto get(size_t i) const -> uint8_t {
+        return v[i];
+    }
+
+    auto operator^(const SimdU8<N>& other) const -> SimdU8<N> {
+#if MDPC_GF4_SIMD_NATIVE
+        return SimdU8<N>{v ^ other.v};
+#else
+        SimdU8<N> out;
+        for (size_t i = 0; i < N; ++i) {
+            out.v[i] = v[i] ^ other.v[i];
+        }
+        return out;
+#endif
+    }
+
+    auto operator&(const SimdU8<N>& other) const -> SimdU8<N> {
+#if MDPC_GF4_SIMD_NATIVE
+        return SimdU8<N>{v & other.v};
+#else
+        SimdU8<N> out;
+        for (size_t i = 0; i < N; ++i) {
+            out.v[i] = v[i] & other.v[i];
+        }
+        return out;
+#endif
+    }
+
+    auto operator|(const SimdU8<N>& other) const -> SimdU8<N> {
+#if MDPC_GF4_SIMD_NATIVE
+        return SimdU8<N>{v | other.v};
+#else
+        SimdU8<N> out;
+        for (size_t i = 0; i < N; ++i) {
+            out.v[i] = v[i] | other.v[i];
+        }
+        return out;
+#endif
+    }
+
+    auto operator^=(const SimdU8<N>& other) -> SimdU8<N>& {
+        *this = *this ^ other;
+        return *this;
+    }
+
+    /**
+     * @brief Subtract byte-wise (modulo 256).
+     *
+     * Subtracting a comparison mask increments the bytes where the comparison matched.
+     */
+    auto operator-(const SimdU8<N>& other) const -> SimdU8<N> {
+#if MDPC_GF4_SIMD_NATIVE
+        return SimdU8<N>{(native)(v - other.v)};
+#else
+        SimdU8<N> out;
+        for (size_t i = 0; i < N; ++i) {
+            out.v[i] = (uint8_t)(v[i] - other.v[i]);
+        }
+        return out;
+#endif
+    }
+
+    /**
+     * @brief Compare byte-wise for equality.
+     *
+     * @return 0xFF in the bytes that are equal, 0x00 elsewhere.
+     */
+    [[nodiscard]] auto cmpeq(const SimdU8<N>& other) const -> SimdU8<N> {
+#if MDPC_GF4_SIMD_NATIVE
+        return SimdU8<N>{(native)(v == other.v)};
+#else
+        SimdU8<N> out;
+        for (size_t i = 0; i < N; ++i) {
+            out.v[i] = (v[i] == other.v[i]) ? 0xFF : 0x00;
+        }
+        return out;
+#endif
+    }
+
+    /**
+     * @brief Look up each byte in a table of 16 entries, i.e. out[i] = table[v[i] & 15].
+     *
+     * @param table Table of 16 bytes.
+     * @return Vector of looked up values.
+     */
+    [[nodiscard]] auto shuffle(const uint8_t* table) const -> SimdU8<N> {
+        SimdU8<N> out;
+        for (size_t i = 0; i < N; ++i) {
+            out.v[i] = table[v[i] & 15u];
+        }
+        return out;
+    }
+
+    /**
+     * @brief Rotate the bits of each byte to the left.
+     *
+     * @param bits Number of bits to rotate by, from 1 to 7.
+     * @return Vector of rotated bytes.
+     */
+    [[nodiscard]] auto rotate_bits_left(unsigned bits) const -> SimdU8<N> {
+#if MDPC_GF4_SIMD_NATIVE
+        return SimdU8<N>{(native)((v << bits) | (v >> (8 - bits)))};
+#else
+        SimdU8<N> out;
+        for (size_t i = 0; i < N; ++i) {
+            out.v[i] = (uint8_t)((v[i] << bits) | (v[i] >> (8 - bits)));
+        }
+        return out;
+#endif
+    }
+
+    /**
+     * @brief Rotate the elements of the vector, i.e. out[i] = v[(i + k) mod N].
+     *
+     * @param k Number of elements to rotate by.
+     * @return Rotated vector.
+     */
+    [[nodiscard]] auto rotate_elements(size_t k) const -> SimdU8<N> {
+        SimdU8<N> out;
+        for (size_t i = 0; i < N; ++i) {
+            out.v[i] = v[(i + k) % N];
+        }
+        return out;
+    }
+
+    /**
+     * @brief Count the set bits of the whole vector.
+     *
+     * @return The number of set bits.
+     */
+    [[nodiscard]] auto popcount() const -> size_t {
+        size_t count = 0;
+        for (size_t i = 0; i < N; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, reinterpret_cast<const uint8_t*>(&v) + i, 8);
+            count += __builtin_popcountll(word);
+        }
+        return count;
+    }
+
+private:
+#if MDPC_GF4_SIMD_NATIVE
+    typedef typename SimdNative<N>::type native;
+    explicit SimdU8(native v) : v(v) {}
+    native v;
+#else
+    uint8_t v[N];
+#endif
+};
+
+using SimdBytes = SimdU8<MDPC_GF4_SIMD_WIDTH>;
+
+#endif //MDPC_GF4_SIMD_H
@@ -0,0 +1,192 @@
+#ifndef MDPC_GF4_SMALL_VECTOR_H
+#define MDPC_GF4_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief A vector with inline storage for up to N elements.
+ *
+ * As long as the size stays at most N, the elements live in an inline array and no memory is allocated.
+ * When the size grows above N, the elements are moved into a std::vector (spilled to the heap)
+ * and stay there until the vector is cleared or assigned a small content again.
+ *
+ * Only the subset of the std::vector interface needed by PolynomialGF2N is provided.
+ *
+ * @tparam T Element type, must be default constructible and copyable.
+ * @tparam N Inline capacity.
+ */
+template<typename T, size_t N>
+class SmallVector {
+public:
+    SmallVector() : inline_data{}, length(0), on_heap(false) {}
+
+    SmallVector(const SmallVector<T, N>& other) : SmallVector() {
+        assign(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector<T, N>&& other) noexcept : inline_data{other.inline_data}, heap_data(std::move(other.heap_data)),
+                                                      length(other.length), on_heap(other.on_heap) {
+        other.length = 0;
+        other.on_heap = false;
+    }
+
+    explicit SmallVector(const std::vector<T>& vec) : SmallVector() {
+        assign(vec.data(), vec.data() + vec.size());
+    }
+
+    auto operator=(const SmallVector<T, N>& other) -> SmallVector<T, N>& {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    auto operator=(SmallVector<T, N>&& other) noexcept -> SmallVector<T, N>& {
+        if (this != &other) {
+            inline_data = other.inline_data;
+            heap_data = std::move(other.heap_data);
+            length = other.length;
+            on_heap = other.on_heap;
+            other.length = 0;
+            other.on_heap = false;
+        }
+        return *this;
+    }
+
+    auto operator=(const std::vector<T>& vec) -> SmallVector<T, N>& {
+        assign(vec.data(), vec.data() + vec.size());
+        return *this;
+    }
+
+    /**
+     * @brief Replace the content by a copy of the range [first, last).
+     *
+     * The range must not point into this vector.
+     */
+    auto assign(const T* first, const T* last) -> void {
+        size_t count = last - first;
+        if (count <= N) {
+            std::copy(first, last, inline_data.begin());
+            heap_data.clear();
+            on_heap = false;
+        } else {
+            heap_data.assign(first, last);
+            on_heap = true;
+        }
+        length = count;
+    }
+
+    [[nodiscard]] auto size() const -> size_t {
+        return length;
+    }
+
+    [[nodiscard]] auto empty() const -> bool {
+        return length == 0;
+    }
+
+    /**
+     * @brief Test whether the elements were spilled to the heap.
+     *
+     * @return true if the elements are stored on the heap, false if inline.
+     */
+    [[nodiscard]] auto is_on_heap() const -> bool {
+        return on_heap;
+    }
+
+    [[nodiscard]] auto data() -> T* {
+        return on_heap ? heap_data.data() : inline_data.data();
+    }
+
+    [[nodiscard]] auto data() const -> const T* {
+        return on_heap ? heap_data.data() : inline_data.data();
+    }
+
+    auto begin() -> T* {
+        return data();
+    }
+
+    auto end() -> T* {
+        return data() + length;
+    }
+
+    [[nodiscard]] auto begin() const -> const T* {
+        return data();
+    }
+
+    [[nodiscard]] auto end() const -> const T* {
+        return data() + length;
+    }
+
+    auto operator[](size_t i) -> T& {
+        return data()[i];
+    }
+
+    auto operator[](size_t i) const -> const T& {
+        return data()[i];
+    }
+
+    auto clear() -> void {
+        heap_data.clear();
+        on_heap = false;
+        length = 0;
+    }
+
+    /**
+     * @brief Resize the vector, new elements are value initialized.
+     *
+     * @param new_length The new size.
+     */
+    auto resize(size_t new_length) -> void {
+        if (on_heap) {
+            heap_data.resize(new_length);
+        } else if (new_length <= N) {
+            for (size_t i = length; i < new_length; ++i) {
+                inline_data[i] = T{};
+            }
+        } else {
+            heap_data.reserve(new_length);
+            heap_data.assign(inline_data.begin(), inline_data.begin() + length);
+            heap_data.resize(new_length);
+            on_heap = true;
+        }
+        length = new_length;
+    }
+
+    auto push_back(const T& value) -> void {
+        resize(length + 1);
+        data()[length - 1] = value;
+    }
+
+    /**
+     * @brief Remove the elements in the range [first, last).
+     *
+     * @return Pointer to the element following the removed ones.
+     */
+    auto erase(T* first, T* last) -> T* {
+        size_t offset = first - begin();
+        std::copy(last, end(), first);
+        resize(length - (last - first));
+        return begin() + offset;
+    }
+
+    /**
+     * @brief Copy the elements into a std::vector.
+     *
+     * @return A vector of the elements.
+     */
+    [[nodiscard]] auto to_vector() const -> std::vector<T> {
+        return std::vector<T>(begin(), end());
+    }
+
+private:
+    std::array<T, N> inline_data;
+    std::vector<T> heap_data;
+    size_t length;
+    bool on_heap;
+};
+
+#endif //MDPC_GF4_SMALL_VECTOR_H
@@ -0,0 +1,147 @@
+#ifndef MDPC_GF4_STAGNATION_H
+#define MDPC_GF4_STAGNATION_H
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief The reason why decoding stopped.
+ */
+enum class DecodingStatus {
+    Success,              ///< The syndrome is zero, the error vector was found.
+    Stalled,              ///< The syndrome weight did not reach a new minimum for too long.
+    Oscillating,          ///< The syndrome weight keeps alternating between two values.
+    IterationsExhausted   ///< The iteration budget was used up.
+};
+
+/**
+ * @brief Parameters of the early failure detection in the decoder.
+ *
+ * The decoder records the syndrome weight after every iteration. Decoding is declared a failure
+ * as soon as either of the following happens:
+ *  + the syndrome weight has not reached a new minimum for stall_window consecutive iterations,
+ *  + the syndrome weight has been alternating between two values (w, w', w, w', ...) for oscillation_window iterations.
+ * A window of zero disables the corresponding rule.
+ *
+ * Both windows are zero by default: how long a successful decoding may stall or oscillate depends on the parameters,
+ * so early stopping stays off until a policy calibrated for them is passed (see calibrate and ParameterSet).
+ */
+struct StagnationPolicy {
+    size_t stall_window = 0;
+    size_t oscillation_window = 0;
+
+    /**
+     * @brief Get a policy which never stops the decoder early.
+     *
+     * @return Policy with both rules disabled.
+     */
+    static auto disabled() -> StagnationPolicy {
+        return StagnationPolicy{0, 0};
+    }
+
+    /**
+     * @brief Calibrate the policy from syndrome weight trajectories of successful decodings.
+     *
+     * The trajectories are typically collected by a DFR simulation (see DecodingResult::syndrome_weights).
+     * The windows are set to the longest stall (resp. oscillation) that still ended in a successful decoding,
+     * plus the given safety margin. Therefore, none of the given decodings would have been stopped early.
+     *
+     * @param successful_trajectories Syndrome weights after each iteration of successful decodings.
+     * @param margin Number of iterations added to both windows.
+     * @return Calibrated policy.
+     */
+    static auto calibrate(const std::vector<std::vector<size_t>>& successful_trajectories, size_t margin) -> StagnationPolicy {
+        size_t longest_stall = 0;
+        size_t longest_oscillation = 0;
+        for (const auto& trajectory: successful_trajectories) {
+            size_t stall = 0;
+            size_t oscillation = 0;
+            for (size_t i = 0; i < trajectory.size(); ++i) {
+                if (i == 0 || trajectory[i] < minimum_before(trajectory, i)) {
+                    stall = 0;
+                } else {
+                    stall += 1;
+                }
+                if (is_alternating(trajectory, i)) {
+                    oscillation += 1;
+                } else {
+                    oscillation = 0;
+                }
+                longest_stall = std::max(longest_stall, stall);
+                longest_oscillation = std::max(longest_oscillation, oscillation);
+            }
+        }
+        return StagnationPolicy{longest_stall + margin + 1, longest_oscillation + margin + 1};
+    }
+
+private:
+    static auto minimum_before(const std::vector<size_t>& trajectory, size_t i) -> size_t {
+        size_t minimum = trajectory[0];
+        for (size_t k = 1; k < i; ++k) {
+            minimum = std::min(minimum, trajectory[k]);
+        }
+        return minimum;
+    }
+
+    static auto is_alternating(const std::vector<size_t>& trajectory, size_t i) -> bool {
+        return i >= 2 && trajectory[i] == trajectory[i - 2] && trajectory[i] != trajectory[i - 1];
+    }
+
+    friend class StagnationDetector;
+};
+
+/**
+ * @brief Track the syndrome weight trajectory of a single decoding and decide when to give up.
+ */
+class StagnationDetector {
+public:
+    explicit StagnationDetector(const StagnationPolicy& policy) : policy(policy) {}
+
+    /**
+     * @brief Record the syndrome weight after an iteration.
+     *
+     * @param syndrome_weight The hamming weight of the current syndrome.
+     * @return Stalled or Oscillating if the decoder should give up, IterationsExhausted otherwise (i.e. keep going).
+     */
+    auto update(size_t syndrome_weight) -> DecodingStatus {
+        if (trajectory.empty() || syndrome_weight < best) {
+            best = syndrome_weight;
+            stall = 0;
+        } else {
+            stall += 1;
+        }
+        trajectory.push_back(syndrome_weight);
+        if (StagnationPolicy::is_alternating(trajectory, trajectory.size() - 1)) {
+            oscillation += 1;
+        } else {
+            oscillation = 0;
+        }
+
+        if (policy.stall_window != 0 && stall >= policy.stall_window) {
+            return DecodingStatus::Stalled;
+        }
+        if (policy.oscillation_window != 0 && oscillation >= policy.oscillation_window) {
+            return DecodingStatus::Oscillating;
+        }
+        return DecodingStatus::IterationsExhausted;
+    }
+
+    /**
+     * @brief Get the recorded syndrome weights.
+     *
+     * @return Syndrome weights in the order they were recorded.
+     */
+    [[nodiscard]] auto get_trajectory() const -> const std::vector<size_t>& {
+        return trajectory;
+    }
+
+private:
+    StagnationPolicy policy;
+    std::vector<size_t> trajectory;
+    size_t best = 0;
+    size_t stall = 0;
+    size_t oscillation = 0;
+};
+
+#endif //MDPC_GF4_STAGNATION_H
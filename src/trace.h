@@ -0,0 +1,429 @@
+#ifndef MDPC_GF4_TRACE_H
+#define MDPC_GF4_TRACE_H
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <istream>
+#include <ostream>
+#include <algorithm>
+#include <cstdint>
+#include "contexts.h"
+#include "multi_recipient.h"
+#include "random.h"
+
+/**
+ * @brief The kind of a traced request.
+ */
+enum class TraceOperation : uint8_t {
+    Encode,            ///< EncodingContext::encode
+    EncodeBatch,       ///< encode_for_recipients, batch_size recipients
+    Decode             ///< DecodingContext::decode_with_report
+};
+
+/**
+ * @brief The metadata of one request. Neither keys nor messages nor error vectors are recorded.
+ */
+struct TraceRecord {
+    uint64_t time_ns = 0;            ///< Start of the request since the start of the recording.
+    TraceOperation operation = TraceOperation::Encode;
+    uint32_t key_id = 0;             ///< Keys are numbered in the order of their first use, see TraceRecorder.
+    uint32_t block_size = 0;
+    uint32_t batch_size = 1;         ///< The number of recipients of EncodeBatch, 1 otherwise.
+    DecodingStatus status = DecodingStatus::Success;   ///< The outcome of Decode, Success otherwise.
+    uint32_t iterations = 0;         ///< The decoder iterations of Decode.
+    uint64_t duration_ns = 0;        ///< The time the request took.
+};
+
+/*
+ * Trace file format: the magic "MDPCTRC" and a version byte, then the records one after another.
+ * Every record is the varint (7 bits per byte, least significant first) of the time since the previous record,
+ * the operation byte, the varints of key_id, block_size and batch_size, the status byte
+ * and the varints of iterations and duration_ns. A typical record takes about 10 bytes.
+ */
+static constexpr char TRACE_MAGIC[7] = {'M', 'D', 'P', 'C', 'T', 'R', 'C'};
+static constexpr uint8_t TRACE_VERSION = 1;
+
+inline auto write_varint(std::ostream& out, uint64_t value) -> void {
+    while (value >= 0x80) {
+        out.put((char)(uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.put((char)(uint8_t)value);
+}
+
+inline auto read_varint(std::istream& in, uint64_t& value) -> bool {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if (c == std::char_traits<char>::eof()) {
+            return false;
+        }
+        value |= (uint64_t)(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Records the metadata of encode and decode requests to a binary trace.
+ *
+ * The recorder can be shared by many threads. Use the recorded_* functions below in place of the plain calls.
+ * Keys are identified by the address of their context, so a context must not be destroyed and replaced
+ * by another one at the same address during the recording.
+ */
+class TraceRecorder {
+public:
+    /**
+     * @brief Start a recording. The header is written immediately.
+     *
+     * @param out The stream to write the trace to, it must outlive the recorder.
+     */
+    explicit TraceRecorder(std::ostream& out) : out(out), start(std::chrono::steady_clock::now()), last_time_ns(0) {
+        out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        out.put((char)TRACE_VERSION);
+    }
+
+    /**
+     * @brief Get the time since the start of the recording.
+     */
+    [[nodiscard]] auto now_ns() const -> uint64_t {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * @brief Get the number of the key with the given context.
+     *
+     * @param context The address of the encoding or decoding context.
+     * @return The key number, in the order of first use.
+     */
+    auto key_id(const void* context) -> uint32_t {
+        std::lock_guard<std::mutex> lock{mutex};
+        return key_id_locked(context);
+    }
+
+    /**
+     * @brief Append a record. The records are written in the order of their start times as far as they arrive in order,
+     * a record which arrives late gets the time of the previous one.
+     *
+     * @param record The record.
+     */
+    auto record(const TraceRecord& record) -> void {
+        std::lock_guard<std::mutex> lock{mutex};
+        uint64_t time_ns = std::max(record.time_ns, last_time_ns);
+        write_varint(out, time_ns - last_time_ns);
+        last_time_ns = time_ns;
+        out.put((char)record.operation);
+        write_varint(out, record.key_id);
+        write_varint(out, record.block_size);
+        write_varint(out, record.batch_size);
+        out.put((char)record.status);
+        write_varint(out, record.iterations);
+        write_varint(out, record.duration_ns);
+    }
+
+private:
+    auto key_id_locked(const void* context) -> uint32_t {
+        auto [it, inserted] = key_ids.emplace(context, (uint32_t)key_ids.size());
+        return it->second;
+    }
+
+    std::ostream& out;
+    std::chrono::steady_clock::time_point start;
+    uint64_t last_time_ns;
+    std::mutex mutex;
+    std::map<const void*, uint32_t> key_ids;
+};
+
+/**
+ * @brief Read a trace written by TraceRecorder.
+ *
+ * @param in The stream to read from.
+ * @return The records, nothing if the trace is malformed.
+ */
+inline auto read_trace(std::istream& in) -> std::optional<std::vector<TraceRecord>> {
+    char magic[sizeof(TRACE_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), TRACE_MAGIC) || in.get() != TRACE_VERSION) {
+        return {};
+    }
+    std::vector<TraceRecord> records;
+    uint64_t time_ns = 0;
+    while (in.peek() != std::char_traits<char>::eof()) {
+        TraceRecord record;
+        uint64_t delta, key_id, block_size, batch_size, iterations, duration_ns;
+        if (!read_varint(in, delta)) {
+            return {};
+        }
+        int operation = in.get();
+        if (!read_varint(in, key_id) || !read_varint(in, block_size) || !read_varint(in, batch_size)) {
+            return {};
+        }
+        int status = in.get();
+        if (!read_varint(in, iterations) || !read_varint(in, duration_ns)) {
+            return {};
+        }
+        if (operation > (int)TraceOperation::Decode || status < 0 || status > (int)DecodingStatus::IterationsExhausted) {
+            return {};
+        }
+        time_ns += delta;
+        record.time_ns = time_ns;
+        record.operation = (TraceOperation)operation;
+        record.key_id = (uint32_t)key_id;
+        record.block_size = (uint32_t)block_size;
+        record.batch_size = (uint32_t)batch_size;
+        record.status = (DecodingStatus)status;
+        record.iterations = (uint32_t)iterations;
+        record.duration_ns = duration_ns;
+        records.push_back(record);
+    }
+    return records;
+}
+
+/**
+ * @brief EncodingContext::encode with recording.
+ */
+template<typename T>
+auto recorded_encode(TraceRecorder& recorder, const EncodingContext<T>& ec, const std::vector<T>& message) -> std::vector<T> {
+    TraceRecord record;
+    record.operation = TraceOperation::Encode;
+    record.key_id = recorder.key_id(&ec);
+    record.block_size = (uint32_t)ec.get_block_size();
+    record.time_ns = recorder.now_ns();
+    std::vector<T> encoded = ec.encode(message);
+    record.duration_ns = recorder.now_ns() - record.time_ns;
+    recorder.record(record);
+    return encoded;
+}
+
+/**
+ * @brief encode_for_recipients with recording. The key of the first recipient is recorded.
+ */
+template<typename T>
+auto recorded_encode_for_recipients(TraceRecorder& recorder, const std::vector<T>& message, const std::vector<EncodingContext<T>>& recipients,
+                                    size_t num_threads = 0) -> std::vector<std::vector<T>> {
+    TraceRecord record;
+    record.operation = TraceOperation::EncodeBatch;
+    record.key_id = recipients.empty() ? 0 : recorder.key_id(&recipients.front());
+    record.block_size = (uint32_t)message.size();
+    record.batch_size = (uint32_t)recipients.size();
+    record.time_ns = recorder.now_ns();
+    auto encoded = encode_for_recipients(message, recipients, num_threads);
+    record.duration_ns = recorder.now_ns() - record.time_ns;
+    recorder.record(record);
+    return encoded;
+}
+
+/**
+ * @brief DecodingContext::decode_with_report with recording.
+ */
+template<typename T>
+auto recorded_decode_with_report(TraceRecorder& recorder, const DecodingContext<T>& dc, const std::vector<T>& message, size_t num_iterations,
+                                 const StagnationPolicy& policy, const PostProcessingPolicy& post_processing = PostProcessingPolicy{}) -> DecodingResult<T> {
+    TraceRecord record;
+    record.operation = TraceOperation::Decode;
+    record.key_id = recorder.key_id(&dc);
+    record.block_size = (uint32_t)dc.get_block_size();
+    record.time_ns = recorder.now_ns();
+    DecodingResult<T> result = dc.decode_with_report(message, num_iterations, policy, post_processing);
+    record.duration_ns = recorder.now_ns() - record.time_ns;
+    record.status = result.status;
+    record.iterations = (uint32_t)result.iterations;
+    recorder.record(record);
+    return result;
+}
+
+/**
+ * @brief DecodingContext::decode with recording.
+ */
+template<typename T>
+auto recorded_decode(TraceRecorder& recorder, const DecodingContext<T>& dc, const std::vector<T>& message, size_t num_iterations) -> std::optional<std::vector<T>> {
+    return recorded_decode_with_report(recorder, dc, message, num_iterations, StagnationPolicy{}).error_vector;
+}
+
+/**
+ * @brief Parameters of replay_trace.
+ */
+struct ReplayOptions {
+    size_t block_weight = 37;      ///< The weight of the locally generated keys.
+    size_t error_weight = 37;      ///< The weight of the errors of decodings which succeeded in the trace.
+    size_t num_iterations = 100;
+    double speed = 1.0;            ///< Requests are started at their recorded times divided by speed, 0 starts them as fast as possible.
+    size_t max_keys = 16;          ///< Key numbers of the trace are mapped to this many local keys per block size.
+    size_t num_threads = 0;        ///< The number of threads, 0 uses the hardware concurrency.
+};
+
+/**
+ * @brief Latency percentiles of one kind of requests.
+ */
+struct LatencySummary {
+    size_t count = 0;
+    double p50 = 0.0;   ///< in seconds
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/**
+ * @brief The outcome of replay_trace.
+ */
+struct ReplayReport {
+    double wall_seconds = 0.0;        ///< From the dispatch of the first request to the end of the last one.
+    double throughput = 0.0;          ///< Requests per second.
+    LatencySummary encode;            ///< Encode and EncodeBatch.
+    LatencySummary decode;
+    size_t decode_failures = 0;
+    LatencySummary recorded_encode;   ///< The durations in the trace, for comparison.
+    LatencySummary recorded_decode;
+    size_t recorded_decode_failures = 0;
+};
+
+inline auto summarize_latencies(std::vector<double> latencies) -> LatencySummary {
+    LatencySummary summary;
+    summary.count = latencies.size();
+    if (latencies.empty()) {
+        return summary;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, (size_t)(p * (double)latencies.size()))];
+    };
+    summary.p50 = percentile(0.5);
+    summary.p90 = percentile(0.9);
+    summary.p99 = percentile(0.99);
+    summary.max = latencies.back();
+    return summary;
+}
+
+/**
+ * @brief Drive the library with the requests of a trace against locally generated keys.
+ *
+ * Every request is started at its recorded time (scaled by ReplayOptions::speed) by the first free thread,
+ * so queueing shows up in the latency, which is measured from the scheduled start to the end of the request.
+ * Encodings get random messages. Decodings which succeeded in the trace get an error of weight
+ * ReplayOptions::error_weight, decodings which failed get a random vector, so that the decoder goes through
+ * the same failure path. The inputs are prepared before the scheduled start and are not part of the latency.
+ *
+ * @tparam T Finite field to be used.
+ * @param records The trace.
+ * @param options The parameters of the replay.
+ * @return Latency and throughput.
+ */
+template<typename T>
+auto replay_trace(const std::vector<TraceRecord>& records, const ReplayOptions& options) -> ReplayReport {
+    // local keys per block size, generated before the replay
+    std::map<uint32_t, std::vector<std::tuple<EncodingContext<T>, DecodingContext<T>>>> keys;
+    for (const auto& record: records) {
+        auto& pool = keys[record.block_size];
+        size_t needed = std::min<size_t>(options.max_keys, std::max<size_t>(record.key_id + 1, record.batch_size));
+        while (pool.size() < needed) {
+            pool.push_back(generate_contexts_over_GF2N<T>(record.block_size, options.block_weight));
+        }
+    }
+    std::map<uint32_t, std::vector<EncodingContext<T>>> recipients;
+    for (const auto& [block_size, pool]: keys) {
+        for (const auto& key: pool) {
+            recipients[block_size].push_back(std::get<0>(key));
+        }
+    }
+
+    std::vector<double> latencies(records.size());
+    std::vector<char> failed(records.size());
+    std::vector<std::chrono::steady_clock::time_point> dispatched(records.size());
+    std::atomic<size_t> next{0};
+    // the recorded times are scheduled from a moment shortly ahead, so that all threads are up by the first request
+    auto schedule_start = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    auto work = [&]() {
+        while (true) {
+            size_t i = next.fetch_add(1);
+            if (i >= records.size()) {
+                return;
+            }
+            const TraceRecord& record = records[i];
+            const auto& pool = keys.at(record.block_size);
+            const auto& [ec, dc] = pool[record.key_id % pool.size()];
+            std::vector<T> input;
+            if (record.operation == TraceOperation::Decode) {
+                if (record.status == DecodingStatus::Success) {
+                    // the decoder only sees the syndrome, so the error of the zero codeword is as good as any codeword
+                    input = Random::random_weighted_vector_over_GF2N<T>(2 * record.block_size, options.error_weight);
+                } else {
+                    input = Random::random_vector_over_GF2N<T>(2 * record.block_size);
+                }
+            } else {
+                input = Random::random_vector_over_GF2N<T>(record.block_size);
+            }
+
+            auto scheduled = std::chrono::steady_clock::now();
+            if (options.speed > 0) {
+                scheduled = schedule_start + std::chrono::nanoseconds((uint64_t)((double)record.time_ns / options.speed));
+                std::this_thread::sleep_until(scheduled);
+            }
+            dispatched[i] = std::chrono::steady_clock::now();
+            switch (record.operation) {
+                case TraceOperation::Encode:
+                    ec.encode(input);
+                    break;
+                case TraceOperation::EncodeBatch: {
+                    const auto& all = recipients.at(record.block_size);
+                    std::vector<EncodingContext<T>> batch;
+                    for (size_t r = 0; r < record.batch_size; ++r) {
+                        batch.push_back(all[(record.key_id + r) % all.size()]);
+                    }
+                    encode_for_recipients(input, batch, 1);
+                    break;
+                }
+                case TraceOperation::Decode:
+                    failed[i] = !dc.decode_with_report(input, options.num_iterations, StagnationPolicy{}).error_vector.has_value();
+                    break;
+            }
+            latencies[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - scheduled).count();
+        }
+    };
+
+    size_t num_threads = options.num_threads;
+    if (num_threads == 0) {
+        num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    // the wall time runs from the dispatch of the first request, not from the schedule start
+    auto end = std::chrono::steady_clock::now();
+    auto first_dispatch = records.empty() ? end : *std::min_element(dispatched.begin(), dispatched.end());
+    ReplayReport report;
+    report.wall_seconds = std::chrono::duration<double>(end - first_dispatch).count();
+    report.throughput = (report.wall_seconds > 0) ? (double)records.size() / report.wall_seconds : 0;
+    std::vector<double> encode_latencies, recorded_encode;
+    std::vector<double> decode_latencies, recorded_decode;
+    for (size_t i = 0; i < records.size(); ++i) {
+        double recorded = (double)records[i].duration_ns * 1e-9;
+        if (records[i].operation == TraceOperation::Decode) {
+            decode_latencies.push_back(latencies[i]);
+            recorded_decode.push_back(recorded);
+            report.decode_failures += (size_t)failed[i];
+            report.recorded_decode_failures += (size_t)(records[i].status != DecodingStatus::Success);
+        } else {
+            encode_latencies.push_back(latencies[i]);
+            recorded_encode.push_back(recorded);
+        }
+    }
+    report.encode = summarize_latencies(encode_latencies);
+    report.decode = summarize_latencies(decode_latencies);
+    report.recorded_encode = summarize_latencies(recorded_encode);
+    report.recorded_decode = summarize_latencies(recorded_decode);
+    return report;
+}
+
+#endif //MDPC_GF4_TRACE_H
@@ -1,6 +1,11 @@
 #ifndef MDPC_GF4_VECTOR_UTILS_H
 #define MDPC_GF4_VECTOR_UTILS_H
 
+#include <vector>
+#include <cstdint>
+#include "gf4.h"
+#include "simd.h"
+
 template<typename T>
 auto is_vector_zero(const std::vector<T>& vec) -> bool {
     for (const T& t: vec) {
@@ -23,6 +28,138 @@ auto hamming_weight(const std::vector<T>& vec) -> size_t {
     return weight;
 }
 
+/**
+ * @brief Get the hamming weight of a vector over GF(4).
+ *
+ * Counts the zero bytes SimdBytes::width elements at a time.
+ *
+ * @param vec The vector.
+ * @return The number of nonzero elements.
+ */
+inline auto hamming_weight(const std::vector<GF4>& vec) -> size_t {
+    constexpr size_t width = SimdBytes::width;
+    static_assert(sizeof(GF4) == 1, "GF4 is expected to be stored in a single byte");
+    const auto* bytes = reinterpret_cast<const uint8_t*>(vec.data());
+    const SimdBytes zero = SimdBytes::broadcast(0);
+    size_t zeros = 0;
+    size_t i = 0;
+    for (; i + width <= vec.size(); i += width) {
+        zeros += SimdBytes::load(bytes + i).cmpeq(zero).popcount() / 8;
+    }
+    for (; i < vec.size(); ++i) {
+        zeros += (size_t)(bytes[i] == 0);
+    }
+    return vec.size() - zeros;
+}
+
+/**
+ * @brief Multiply SimdBytes::width symbols of GF(4), one per byte, by a constant.
+ *
+ * With the symbol b0 + b1*alpha stored as the bits b0, b1 of a byte, multiplication by alpha maps it to
+ * b1 + (b0 + b1)*alpha and multiplication by alpha^2 = alpha + 1 maps it to (b0 + b1) + b0*alpha,
+ * so a product is a few bit rotations and masks per vector.
+ *
+ * @param v The symbols, values 0 to 3.
+ * @param scalar The value of the constant, 0 to 3.
+ * @return The products.
+ */
+inline auto multiply_gf4_bytes(const SimdBytes& v, uint8_t scalar) -> SimdBytes {
+    const SimdBytes bit0 = SimdBytes::broadcast(1);
+    const SimdBytes bit1 = SimdBytes::broadcast(2);
+    switch (scalar) {
+        case 1:
+            return v;
+        case 2:
+            return (v.rotate_bits_left(7) & bit0) | ((v ^ v.rotate_bits_left(1)) & bit1);
+        case 3:
+            return ((v ^ v.rotate_bits_left(7)) & bit0) | (v.rotate_bits_left(1) & bit1);
+        default:
+            return SimdBytes{};
+    }
+}
+
+/**
+ * @brief Calculate out[i] += scalar * in[i] for all i < n.
+ *
+ * @param out The buffer to add to.
+ * @param in The buffer to add the multiple of.
+ * @param n The number of elements.
+ * @param scalar The multiplier.
+ */
+template<typename T>
+auto add_multiple(T* out, const T* in, size_t n, const T& scalar) -> void {
+    if (scalar.is_zero()) {
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        out[i] += scalar * in[i];
+    }
+}
+
+/**
+ * @brief add_multiple over GF(4), SimdBytes::width elements at a time (see multiply_gf4_bytes).
+ *
+ * @param out The buffer to add to.
+ * @param in The buffer to add the multiple of.
+ * @param n The number of elements.
+ * @param scalar The multiplier.
+ */
+inline auto add_multiple(GF4* out, const GF4* in, size_t n, const GF4& scalar) -> void {
+    constexpr size_t width = SimdBytes::width;
+    static_assert(sizeof(GF4) == 1, "GF4 is expected to be stored in a single byte");
+    uint8_t s = scalar.get_value();
+    if (s == 0) {
+        return;
+    }
+    auto* dst = reinterpret_cast<uint8_t*>(out);
+    const auto* src = reinterpret_cast<const uint8_t*>(in);
+    size_t i = 0;
+    for (; i + width <= n; i += width) {
+        (SimdBytes::load(dst + i) ^ multiply_gf4_bytes(SimdBytes::load(src + i), s)).store(dst + i);
+    }
+    for (; i < n; ++i) {
+        dst[i] ^= GF4_MULTIPLICATION[s][src[i]];
+    }
+}
+
+/**
+ * @brief Calculate data[i] *= scalar for all i < n.
+ *
+ * @param data The buffer to multiply.
+ * @param n The number of elements.
+ * @param scalar The multiplier.
+ */
+template<typename T>
+auto multiply_by(T* data, size_t n, const T& scalar) -> void {
+    for (size_t i = 0; i < n; ++i) {
+        data[i] *= scalar;
+    }
+}
+
+/**
+ * @brief multiply_by over GF(4), SimdBytes::width elements at a time (see multiply_gf4_bytes).
+ *
+ * @param data The buffer to multiply.
+ * @param n The number of elements.
+ * @param scalar The multiplier.
+ */
+inline auto multiply_by(GF4* data, size_t n, const GF4& scalar) -> void {
+    constexpr size_t width = SimdBytes::width;
+    static_assert(sizeof(GF4) == 1, "GF4 is expected to be stored in a single byte");
+    uint8_t s = scalar.get_value();
+    if (s == 1) {
+        return;
+    }
+    auto* bytes = reinterpret_cast<uint8_t*>(data);
+    size_t i = 0;
+    for (; i + width <= n; i += width) {
+        multiply_gf4_bytes(SimdBytes::load(bytes + i), s).store(bytes + i);
+    }
+    for (; i < n; ++i) {
+        bytes[i] = GF4_MULTIPLICATION[s][bytes[i]];
+    }
+}
+
 template<typename T>
 auto sum(const std::vector<T>& v) -> T {
     T s;
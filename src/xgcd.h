@@ -4,9 +4,40 @@
 #ifndef MDPC_GF4_XGCD_H
 #define MDPC_GF4_XGCD_H
 
+#include <algorithm>
 #include <array>
-#include "polynomial.h"
+#include <vector>
+#include <tuple>
+#include <utility>
 #include "custom_exceptions.h"
+#include "gf4.h"
+#include "bitsliced_gf4.h"
+#include "field_traits.h"
+#include "vector_utils.h"
+
+/*
+ * Below this degree, half_gcd runs the classical euclidean algorithm instead of recursing.
+ * The best value depends on the field and the machine, it may be tuned by defining the macro
+ * or by passing the threshold to half_gcd, full_gcd and PolynomialGF2N::invert explicitly.
+ *
+ * Fields with a bit-sliced layout (see FieldTraits) have their own threshold, as their classical algorithm runs
+ * on bit-sliced coefficients (see classical_reduce)
+ * and beats the half-gcd recursion on schoolbook/Karatsuba multiplication at least up to degree 80000.
+ */
+#ifndef MDPC_GF4_HALF_GCD_THRESHOLD
+#define MDPC_GF4_HALF_GCD_THRESHOLD 128
+#endif
+
+#ifndef MDPC_GF4_HALF_GCD_THRESHOLD_BITSLICED
+#define MDPC_GF4_HALF_GCD_THRESHOLD_BITSLICED 131072
+#endif
+
+/*
+ * Below this length, multiply_accumulate uses the schoolbook multiplication instead of Karatsuba.
+ */
+#ifndef MDPC_GF4_KARATSUBA_THRESHOLD
+#define MDPC_GF4_KARATSUBA_THRESHOLD 32
+#endif
 
 template<typename T>
 class PolynomialGF2N; // forward declaration
@@ -18,7 +49,7 @@ struct TransformMatrixGF2N {
     TransformMatrixGF2N(const PolynomialGF2N<T> &a00, const PolynomialGF2N<T> &a01, const PolynomialGF2N<T> &a10,
                         const PolynomialGF2N<T> &a11) : a00(a00), a01(a01), a10(a10), a11(a11) {}
 
-    auto operator*(const TransformMatrixGF2N<T>& other) -> TransformMatrixGF2N<T> {
+    auto operator*(const TransformMatrixGF2N<T>& other) const -> TransformMatrixGF2N<T> {
         return TransformMatrixGF2N<T>{
             a00*other.a00 + a01*other.a10,
             a00*other.a01 + a01*other.a11,
@@ -27,78 +58,469 @@ struct TransformMatrixGF2N {
         };
     }
 
-    auto adjugate() -> TransformMatrixGF2N<T> {
+    /**
+     * @brief Get the adjugate matrix, which is the inverse of the matrices produced by half_gcd as their determinant is one.
+     */
+    auto adjugate() const -> TransformMatrixGF2N<T> {
         return TransformMatrixGF2N<T>{
-            a11, a01, a10, a11,
+            a11, a01, a10, a00,
         };
     }
 
-    auto transform(PolynomialGF2N<T> a, PolynomialGF2N<T> b) -> std::tuple<PolynomialGF2N<T>, PolynomialGF2N<T>>{
+    auto transform(PolynomialGF2N<T> a, PolynomialGF2N<T> b) const -> std::tuple<PolynomialGF2N<T>, PolynomialGF2N<T>>{
         return std::make_tuple(a00*a + a01*b, a10*a + a11*b);
     }
 };
 
+/**
+ * @brief Get the default degree below which the classical euclidean algorithm is used for the field T.
+ */
+template<typename T>
+auto default_half_gcd_threshold() -> size_t {
+    if constexpr (FieldTraits<T>::has_bitsliced_layout) {
+        return MDPC_GF4_HALF_GCD_THRESHOLD_BITSLICED;
+    } else {
+        return MDPC_GF4_HALF_GCD_THRESHOLD;
+    }
+}
+
+// PolynomialGF2N uses default_half_gcd_threshold, so it is included only after its definition
+#include "polynomial.h"
+
+/*
+ * The functions below work on raw coefficient buffers: a polynomial is a std::vector<T> of its coefficients
+ * without trailing zeros, so the zero polynomial is the empty vector. Results are accumulated into buffers
+ * owned by the caller, which are reused across the steps of the algorithm.
+ */
+
+template<typename T>
+auto trim_coefficients(std::vector<T>& p) -> void {
+    while (!p.empty() && p.back().is_zero()) {
+        p.pop_back();
+    }
+}
+
+/**
+ * @brief Calculate out[0 .. na + nb - 2] += a * b, using Karatsuba multiplication for long operands.
+ *
+ * In characteristic 2, a * b = a0 b0 + x^h ((a0 + a1)(b0 + b1) + a0 b0 + a1 b1) + x^(2h) a1 b1.
+ *
+ * @param out Output buffer of at least na + nb - 1 coefficients.
+ * @param a The first operand.
+ * @param na The number of coefficients of a, positive.
+ * @param b The second operand.
+ * @param nb The number of coefficients of b, positive.
+ */
+template<typename T>
+auto multiply_accumulate(T* out, const T* a, size_t na, const T* b, size_t nb) -> void {
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (nb < MDPC_GF4_KARATSUBA_THRESHOLD) {
+        for (size_t j = 0; j < nb; ++j) {
+            add_multiple(out + j, a, na, b[j]);
+        }
+        return;
+    }
+    size_t h = (na + 1) / 2;
+    if (nb <= h) {
+        multiply_accumulate(out, a, h, b, nb);
+        multiply_accumulate(out + h, a + h, na - h, b, nb);
+        return;
+    }
+    std::vector<T> low(2 * h - 1);
+    std::vector<T> high(na + nb - 2 * h - 1);
+    std::vector<T> middle(2 * h - 1);
+    multiply_accumulate(low.data(), a, h, b, h);
+    multiply_accumulate(high.data(), a + h, na - h, b + h, nb - h);
+    std::vector<T> sum_a(a, a + h);
+    std::vector<T> sum_b(b, b + h);
+    for (size_t i = h; i < na; ++i) {
+        sum_a[i - h] += a[i];
+    }
+    for (size_t i = h; i < nb; ++i) {
+        sum_b[i - h] += b[i];
+    }
+    multiply_accumulate(middle.data(), sum_a.data(), h, sum_b.data(), h);
+    for (size_t i = 0; i < low.size(); ++i) {
+        middle[i] += low[i];
+        out[i] += low[i];
+    }
+    for (size_t i = 0; i < high.size(); ++i) {
+        middle[i] += high[i];
+        out[2 * h + i] += high[i];
+    }
+    for (size_t i = 0; i < middle.size(); ++i) {
+        out[h + i] += middle[i];
+    }
+}
+
+/**
+ * @brief Calculate out += a * b on trimmed coefficient buffers.
+ */
+template<typename T>
+auto multiply_accumulate(std::vector<T>& out, const std::vector<T>& a, const std::vector<T>& b) -> void {
+    if (a.empty() || b.empty()) {
+        return;
+    }
+    if (out.size() < a.size() + b.size() - 1) {
+        out.resize(a.size() + b.size() - 1);
+    }
+    multiply_accumulate(out.data(), a.data(), a.size(), b.data(), b.size());
+    trim_coefficients(out);
+}
+
+/**
+ * @brief A 2x2 matrix of polynomials stored in coefficient buffers, used by half_gcd and full_gcd.
+ *
+ * The matrix R maps the input pair (A, B) to the current pair of remainders, (A', B') = R (A, B).
+ * A euclidean step with quotient q multiplies it by [[0, 1], [1, q]] from the left, which has determinant one.
+ */
+template<typename T>
+struct CofactorMatrix {
+    std::array<std::array<std::vector<T>, 2>, 2> r;
+
+    static auto identity() -> CofactorMatrix<T> {
+        CofactorMatrix<T> out;
+        out.r[0][0].push_back(T{1});
+        out.r[1][1].push_back(T{1});
+        return out;
+    }
+
+    /**
+     * @brief Apply a euclidean step with the quotient q in place: (row0, row1) = (row1, row0 + q row1).
+     */
+    auto step(const std::vector<T>& q) -> void {
+        multiply_accumulate(r[0][0], q, r[1][0]);
+        multiply_accumulate(r[0][1], q, r[1][1]);
+        std::swap(r[0], r[1]);
+    }
+
+    /**
+     * @brief Calculate (A, B) = this (A, B), reusing the scratch buffers.
+     */
+    auto apply(std::vector<T>& A, std::vector<T>& B, std::vector<T>& scratch_a, std::vector<T>& scratch_b) const -> void {
+        scratch_a.clear();
+        scratch_b.clear();
+        multiply_accumulate(scratch_a, r[0][0], A);
+        multiply_accumulate(scratch_a, r[0][1], B);
+        multiply_accumulate(scratch_b, r[1][0], A);
+        multiply_accumulate(scratch_b, r[1][1], B);
+        std::swap(A, scratch_a);
+        std::swap(B, scratch_b);
+    }
+
+    /**
+     * @brief Calculate the product left * right.
+     */
+    static auto product(const CofactorMatrix<T>& left, const CofactorMatrix<T>& right) -> CofactorMatrix<T> {
+        CofactorMatrix<T> out;
+        for (size_t i = 0; i < 2; ++i) {
+            for (size_t j = 0; j < 2; ++j) {
+                multiply_accumulate(out.r[i][j], left.r[i][0], right.r[0][j]);
+                multiply_accumulate(out.r[i][j], left.r[i][1], right.r[1][j]);
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @brief Convert to the transformation matrix T of the quotients, T = R^-1 = adj(R).
+     */
+    auto to_transform_matrix() const -> TransformMatrixGF2N<T> {
+        return TransformMatrixGF2N<T>{
+            PolynomialGF2N<T>{r[1][1]},
+            PolynomialGF2N<T>{r[0][1]},
+            PolynomialGF2N<T>{r[1][0]},
+            PolynomialGF2N<T>{r[0][0]},
+        };
+    }
+};
+
+
+/**
+ * @brief Perform one euclidean step in place: (A, B) = (B, A mod B), q = A div B.
+ *
+ * @param A The dividend, replaced by B.
+ * @param B A nonzero divisor of degree at most deg(A), replaced by the remainder.
+ * @param q Output buffer for the quotient.
+ */
+template<typename T>
+auto euclidean_step(std::vector<T>& A, std::vector<T>& B, std::vector<T>& q) -> void {
+    size_t nb = B.size();
+    T lead_inverse = T{1} / B.back();
+    q.assign(A.size() - nb + 1, T{});
+    for (size_t deg = A.size(); deg >= nb; --deg) {
+        T c = A[deg - 1] * lead_inverse;
+        if (!c.is_zero()) {
+            q[deg - nb] = c;
+            add_multiple(A.data() + deg - nb, B.data(), nb, c);
+        }
+    }
+    A.resize(nb - 1);
+    trim_coefficients(A);
+    std::swap(A, B);
+}
+
+/**
+ * @brief Run the classical euclidean algorithm on (A, B) until deg(B) < m, updating A, B and R in place.
+ *
+ * @param A Remainder of degree at least deg(B), updated in place.
+ * @param B Remainder, updated in place.
+ * @param m The degree bound, m = 0 runs the algorithm until B is zero.
+ * @param R Cofactor matrix, multiplied by the steps from the left.
+ * @param quotients If not null, the quotients of the steps are appended to it.
+ */
 template<typename T>
-auto half_gcd(PolynomialGF2N<T> A, PolynomialGF2N<T> B) -> std::tuple<std::vector<PolynomialGF2N<T>>, TransformMatrixGF2N<T>> {
+auto classical_reduce(std::vector<T>& A, std::vector<T>& B, size_t m, CofactorMatrix<T>& R,
+                      std::vector<std::vector<T>>* quotients) -> void {
+    std::vector<T> q;
+    while (B.size() > m) {
+        euclidean_step(A, B, q);
+        R.step(q);
+        if (quotients != nullptr) {
+            quotients->push_back(q);
+        }
+    }
+}
+
+/**
+ * @brief Run the classical euclidean algorithm over GF(4) on bit-sliced coefficients.
+ *
+ * Same as the generic classical_reduce. The remainders and the cofactors are kept in BitslicedGF4Vector,
+ * so every elimination of a leading coefficient is a shifted XOR of 64 coefficients per word.
+ */
+inline auto classical_reduce(std::vector<GF4>& A, std::vector<GF4>& B, size_t m, CofactorMatrix<GF4>& R,
+                             std::vector<std::vector<GF4>>* quotients) -> void {
+    if (B.size() <= m) {
+        return;
+    }
+    size_t length = A.size();
+    size_t row_length = length;
+    for (const auto& row: R.r) {
+        for (const auto& entry: row) {
+            row_length = std::max(row_length, entry.size() + length);
+        }
+    }
+    auto pack = [](const std::vector<GF4>& vec, size_t length) {
+        BitslicedGF4Vector out{length};
+        for (size_t i = 0; i < vec.size(); ++i) {
+            out.set(i, vec[i]);
+        }
+        return out;
+    };
+    BitslicedGF4Vector a = pack(A, length);
+    BitslicedGF4Vector b = pack(B, length);
+    std::array<std::array<BitslicedGF4Vector, 2>, 2> r;
+    std::array<std::array<size_t, 2>, 2> r_size{};
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            r[i][j] = pack(R.r[i][j], row_length);
+            r_size[i][j] = R.r[i][j].size();
+        }
+    }
+    // sizes are degree + 1, zero for the zero polynomial
+    size_t a_size = A.size();
+    size_t b_size = B.size();
+    std::vector<GF4> q;
+    while (b_size > m) {
+        GF4 lead_inverse = GF4{1} / b.get(b_size - 1);
+        q.assign(a_size - b_size + 1, GF4{});
+        while (a_size >= b_size) {
+            GF4 c = a.get(a_size - 1) * lead_inverse;
+            size_t shift = a_size - b_size;
+            q[shift] = c;
+            a.add_shifted_multiple(b, c, shift, b_size);
+            for (size_t j = 0; j < 2; ++j) {
+                if (r_size[1][j] != 0) {
+                    r[0][j].add_shifted_multiple(r[1][j], c, shift, r_size[1][j]);
+                    r_size[0][j] = std::max(r_size[0][j], r_size[1][j] + shift);
+                }
+            }
+            size_t last = a.last_nonzero(a_size - 1);
+            a_size = (last == length) ? 0 : last + 1;
+        }
+        std::swap(a, b);
+        std::swap(a_size, b_size);
+        std::swap(r[0], r[1]);
+        std::swap(r_size[0], r_size[1]);
+        if (quotients != nullptr) {
+            quotients->push_back(q);
+        }
+    }
+
+    auto unpack = [](const BitslicedGF4Vector& vec, size_t size) {
+        std::vector<GF4> out;
+        out.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            out.push_back(vec.get(i));
+        }
+        trim_coefficients(out);
+        return out;
+    };
+    A = unpack(a, a_size);
+    B = unpack(b, b_size);
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            R.r[i][j] = unpack(r[i][j], r_size[i][j]);
+        }
+    }
+}
+
+/**
+ * @brief Reduce (A, B) until deg(B) < m.
+ *
+ * Runs the classical euclidean algorithm below the threshold, otherwise uses the half-gcd recursion
+ * on the upper halves of the remainders. The first half is reduced by a recursive call, the second half
+ * by the next iteration of the loop, so only one recursive call is on the stack per level.
+ * All steps update A, B and R in place.
+ *
+ * @param A Remainder of degree at least deg(B), updated in place.
+ * @param B Remainder, updated in place.
+ * @param m The degree bound, m >= 1.
+ * @param R Cofactor matrix, multiplied by the steps from the left.
+ * @param threshold Degree below which the classical algorithm is used.
+ * @param quotients If not null, the quotients of the steps are appended to it.
+ */
+template<typename T>
+auto reduce_below_degree(std::vector<T>& A, std::vector<T>& B, size_t m, CofactorMatrix<T>& R, size_t threshold,
+                         std::vector<std::vector<T>>* quotients) -> void {
+    std::vector<T> scratch_a;
+    std::vector<T> scratch_b;
+    bool first = true;
+    while (B.size() > m) {
+        if (A.size() <= threshold) {
+            classical_reduce(A, B, m, R, quotients);
+            return;
+        }
+        // the first half reduces the top m coefficients, the second one reduces the rest below m
+        size_t k = first ? m : (2 * m > A.size() - 1 ? 2 * m - (A.size() - 1) : 0);
+        first = false;
+        if (k > 0 && B.size() > k + 1) {
+            std::vector<T> A_high(A.begin() + k, A.end());
+            std::vector<T> B_high(B.begin() + k, B.end());
+            CofactorMatrix<T> S = CofactorMatrix<T>::identity();
+            reduce_below_degree(A_high, B_high, A_high.size() / 2, S, threshold, quotients);
+            S.apply(A, B, scratch_a, scratch_b);
+            R = CofactorMatrix<T>::product(S, R);
+        }
+        if (B.size() > m) {
+            // exactly one step
+            classical_reduce(A, B, B.size() - 1, R, quotients);
+        }
+    }
+}
+
+/**
+ * @brief Calculate the half-gcd of A and B.
+ *
+ * Finds the transformation matrix T of the euclidean steps that reduce (A, B) to remainders (A', B') with deg(B') < ceil(deg(A) / 2),
+ * i.e. (A, B) = T (A', B') and T is the product of the matrices [[q_i, 1], [1, 0]].
+ *
+ * @throws IncorrectPolynomialDegree if deg(A) < deg(B).
+ * @param A The first polynomial.
+ * @param B The second polynomial.
+ * @param threshold Degree below which the classical euclidean algorithm is used.
+ * @return The quotients of the steps and the transformation matrix.
+ */
+template<typename T>
+auto half_gcd(const PolynomialGF2N<T>& A, const PolynomialGF2N<T>& B, size_t threshold = default_half_gcd_threshold<T>())
+        -> std::tuple<std::vector<PolynomialGF2N<T>>, TransformMatrixGF2N<T>> {
     if (A.get_degree() < B.get_degree()) {
         throw IncorrectPolynomialDegree{};
     }
+    std::vector<T> a = A.to_vector();
+    std::vector<T> b = B.to_vector();
+    trim_coefficients(a);
+    trim_coefficients(b);
+    std::vector<std::vector<T>> quotients;
+    CofactorMatrix<T> R = CofactorMatrix<T>::identity();
     size_t m = (A.get_degree() + 1) / 2;
-    if(B.get_degree() < m) {
-        return std::make_tuple(
-            std::vector<PolynomialGF2N<T>>{},
-            TransformMatrixGF2N<T>{
-                PolynomialGF2N<T>::make_one(),
-                PolynomialGF2N<T>::make_zero(),
-                PolynomialGF2N<T>::make_zero(),
-                PolynomialGF2N<T>::make_one()
-            }
-        );
+    reduce_below_degree(a, b, m == 0 ? 1 : m, R, threshold, &quotients);
+    return {std::vector<PolynomialGF2N<T>>(quotients.begin(), quotients.end()), R.to_transform_matrix()};
+}
+
+/**
+ * @brief Run one stage of full_gcd on (A, B) with B nonzero: the whole classical algorithm below the threshold,
+ * otherwise a half-gcd reduction or a single step, whichever the degrees call for.
+ */
+template<typename T>
+auto reduce_stage(std::vector<T>& A, std::vector<T>& B, CofactorMatrix<T>& R, size_t threshold,
+                  std::vector<std::vector<T>>* quotients) -> void {
+    if (A.size() <= threshold) {
+        classical_reduce(A, B, 0, R, quotients);
+    } else if (2 * (B.size() - 1) > A.size() - 1) {
+        reduce_below_degree(A, B, A.size() / 2, R, threshold, quotients);
     } else {
-        auto [ar, Tr] = half_gcd(A.div_x_to_deg(m), B.div_x_to_deg(m));
-        std::tie(A, B) = Tr.adjugate().transform(A, B);
-        if(B.get_degree() < m) {
-            return {ar, Tr};
-        } else {
-            auto [ai, R] = A.div_rem(B);
-            std::tie(A, B) = std::make_pair(B, R);
-            size_t k = 2 * m - B.get_degree();
-            auto [as, Ts] = half_gcd(A.div_x_to_deg(k), B.div_x_to_deg(k));
-            ar.push_back(ai);
-            ar.insert(ar.end(), as.begin(), as.end());
-            return {ar, Tr * TransformMatrixGF2N<T>{ai, PolynomialGF2N<T>::make_one(), PolynomialGF2N<T>::make_one(), PolynomialGF2N<T>::make_zero()} * Ts};
-        }
+        classical_reduce(A, B, B.size() - 1, R, quotients);
+    }
+}
+
+/**
+ * @brief Calculate the last nonzero remainder of the euclidean algorithm on a and b, i.e. gcd(a, b) up to a scalar.
+ *
+ * Runs the stages of full_gcd with a zero cofactor matrix and without collecting the quotients, so only
+ * the remainders are computed. Over GF(4) this is the classical algorithm on bit-sliced coefficients.
+ *
+ * @throws IncorrectPolynomialDegree if deg(a) < deg(b).
+ * @param a The first polynomial.
+ * @param b The second polynomial of degree at most deg(a).
+ * @param threshold Degree below which the classical euclidean algorithm is used.
+ * @return The last nonzero remainder, zero if a and b are zero.
+ */
+template<typename T>
+auto gcd_remainder(const PolynomialGF2N<T>& a, const PolynomialGF2N<T>& b, size_t threshold = default_half_gcd_threshold<T>())
+        -> PolynomialGF2N<T> {
+    if (a.get_degree() < b.get_degree()) {
+        throw IncorrectPolynomialDegree{};
+    }
+    std::vector<T> A = a.to_vector();
+    std::vector<T> B = b.to_vector();
+    trim_coefficients(A);
+    trim_coefficients(B);
+    // the zero matrix stays zero under the steps, which skip empty cofactors
+    CofactorMatrix<T> none;
+    while (!B.empty()) {
+        reduce_stage<T>(A, B, none, threshold, nullptr);
     }
+    return PolynomialGF2N<T>{A};
 }
 
+/**
+ * @brief Run the extended euclidean algorithm on a and b.
+ *
+ * @param a The first polynomial.
+ * @param b The second polynomial of degree at most deg(a).
+ * @param threshold Degree below which the classical euclidean algorithm is used.
+ * @return The quotients of all the steps and the transformation matrix T such that (a, b) = T (gcd(a, b), 0).
+ */
 template<typename T>
-auto full_gcd(PolynomialGF2N<T> a, PolynomialGF2N<T> b) -> std::tuple<std::vector<PolynomialGF2N<T>>, TransformMatrixGF2N<T>> {
-    std::vector<PolynomialGF2N<T>> ak;
-    std::vector<TransformMatrixGF2N<T>> trs;
-    while(!b.is_zero()) {
-        if(2 * b.get_degree() > a.get_degree()) {
-            auto [tmp, tr] = half_gcd(a, b);
-            ak.insert(ak.end(), tmp.begin(), tmp.end());
-            trs.push_back(tr);
-            std::tie(a, b) = trs.back().adjugate().transform(a, b);
-        } else {
-            auto [d, r] = a.div_rem(b);
-            ak.push_back(d);
-            trs.push_back(TransformMatrixGF2N<T>{d, PolynomialGF2N<T>::make_one(), PolynomialGF2N<T>::make_one(), PolynomialGF2N<T>::make_zero()});
-            std::tie(a, b) = std::make_tuple(b, r);
+auto full_gcd(const PolynomialGF2N<T>& a, const PolynomialGF2N<T>& b, size_t threshold = default_half_gcd_threshold<T>())
+        -> std::tuple<std::vector<PolynomialGF2N<T>>, TransformMatrixGF2N<T>> {
+    if (a.get_degree() < b.get_degree()) {
+        throw IncorrectPolynomialDegree{};
+    }
+    std::vector<T> A = a.to_vector();
+    std::vector<T> B = b.to_vector();
+    trim_coefficients(A);
+    trim_coefficients(B);
+    std::vector<std::vector<T>> quotients;
+    // every stage gets its own matrix and the product is taken from the end, where the matrices are small,
+    // so the large matrices of the first stages are multiplied only once
+    std::vector<CofactorMatrix<T>> stages;
+    while (!B.empty()) {
+        stages.push_back(CofactorMatrix<T>::identity());
+        reduce_stage(A, B, stages.back(), threshold, &quotients);
+    }
+    CofactorMatrix<T> R = CofactorMatrix<T>::identity();
+    if (!stages.empty()) {
+        R = std::move(stages.back());
+        for (size_t i = stages.size() - 1; i > 0; --i) {
+            R = CofactorMatrix<T>::product(R, stages[i - 1]);
         }
     }
-    trs.emplace_back(TransformMatrixGF2N<T>{
-        PolynomialGF2N<T>::make_one(),
-        PolynomialGF2N<T>::make_zero(),
-        PolynomialGF2N<T>::make_zero(),
-        PolynomialGF2N<T>::make_one()
-    });
-    while(trs.size() >= 2) {
-        trs[trs.size() - 2] = trs[trs.size() - 2] * trs[trs.size() - 1];
-        trs.pop_back();
-    }
-    return {ak, trs.back()};
+    return {std::vector<PolynomialGF2N<T>>(quotients.begin(), quotients.end()), R.to_transform_matrix()};
 }
 
-#endif //MDPC_GF4_XGCD_H
\ No newline at end of file
+#endif //MDPC_GF4_XGCD_H
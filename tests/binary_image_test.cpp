@@ -0,0 +1,47 @@
+#include "../src/gf4.h"
+#include "../src/binary_image.h"
+#include "check.h"
+
+#include <iostream>
+
+/*
+ * Decodes the same noisy codewords with DecodingContext::decode_with_report and BinaryImageDecoder
+ * and checks that the binary first pass never fails where the GF(4) decoder alone succeeds.
+ */
+int main() {
+    auto [ec, dc] = generate_contexts_over_GF2N<GF4>(2339, 37);
+    BinaryImageDecoder binary{dc};
+    for (size_t error_weight: {74, 84, 90}) {
+        size_t plain_failures = 0;
+        size_t binary_failures = 0;
+        size_t fallbacks = 0;
+        size_t trials = 40;
+        for (size_t trial = 0; trial < trials; ++trial) {
+            auto codeword = ec.encode(Random::random_vector_over_GF2N<GF4>(2339));
+            auto error = Random::random_weighted_vector_over_GF2N<GF4>(2 * 2339, error_weight);
+            for (size_t j = 0; j < codeword.size(); ++j) {
+                codeword[j] += error[j];
+            }
+            auto is_error = [&error](const DecodingResult<GF4>& result) {
+                if (!result.error_vector) {
+                    return false;
+                }
+                auto difference = result.error_vector.value();
+                for (size_t j = 0; j < difference.size(); ++j) {
+                    difference[j] += error[j];
+                }
+                return is_vector_zero(difference);
+            };
+            bool plain = is_error(dc.decode_with_report(codeword, 100, StagnationPolicy::disabled()));
+            DecodingResult<GF4> result = binary.decode_with_report(codeword, 100, StagnationPolicy::disabled());
+            MDPC_GF4_CHECK(!plain || is_error(result));
+            plain_failures += !plain;
+            binary_failures += !is_error(result);
+            fallbacks += result.binary_fallback;
+        }
+        std::cout << "t = " << error_weight << ": GF(4) decoder failed " << plain_failures << "/" << trials
+                  << ", binary first pass failed " << binary_failures << "/" << trials << " with " << fallbacks
+                  << " fallbacks" << std::endl;
+    }
+    return 0;
+}
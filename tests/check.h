@@ -0,0 +1,18 @@
+#ifndef MDPC_GF4_TESTS_CHECK_H
+#define MDPC_GF4_TESTS_CHECK_H
+
+#include <iostream>
+#include <cstdlib>
+
+/*
+ * The tests are plain executables run by ctest: a failed check prints its location and exits with a nonzero status.
+ */
+#define MDPC_GF4_CHECK(condition)                                                                   \
+    do {                                                                                            \
+        if (!(condition)) {                                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            std::exit(1);                                                                           \
+        }                                                                                           \
+    } while (false)
+
+#endif //MDPC_GF4_TESTS_CHECK_H
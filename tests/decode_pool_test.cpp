@@ -0,0 +1,77 @@
+#include "../src/gf4.h"
+#include "../src/decode_pool.h"
+#include "check.h"
+
+#include <iostream>
+
+/*
+ * Decodes a batch with most requests on one key, so that the other workers have to steal, and checks every result
+ * of the pool against DecodingContext::decode_with_report called directly on the same message.
+ */
+int main() {
+    const size_t block_size = 307;
+    const size_t block_weight = 15;
+    const size_t num_iterations = 60;
+    std::vector<EncodingContext<GF4>> encoding;
+    std::vector<DecodingContext<GF4>> decoding;
+    for (size_t k = 0; k < 3; ++k) {
+        auto [ec, dc] = generate_contexts_over_GF2N<GF4>(block_size, block_weight);
+        encoding.push_back(ec);
+        decoding.push_back(dc);
+    }
+
+    std::vector<std::pair<size_t, std::vector<GF4>>> requests;
+    for (size_t i = 0; i < 48; ++i) {
+        size_t key_id = (i % 4 == 3) ? i % 3 : 0;
+        // every fourth error is too heavy to be decoded
+        size_t error_weight = (i % 4 == 1) ? 80 : 6;
+        auto codeword = encoding[key_id].encode(Random::random_vector_over_GF2N<GF4>(block_size));
+        auto error = Random::random_weighted_vector_over_GF2N<GF4>(2 * block_size, error_weight);
+        for (size_t j = 0; j < codeword.size(); ++j) {
+            codeword[j] += error[j];
+        }
+        requests.emplace_back(key_id, codeword);
+    }
+
+    DecodePoolOptions options;
+    options.num_threads = 4;
+    options.group_size = 2;
+    DecodePool<GF4> pool{decoding, options};
+    for (size_t key_id = 0; key_id < 8; ++key_id) {
+        MDPC_GF4_CHECK(pool.home_worker(key_id) < pool.get_num_workers());
+    }
+    bool thrown = false;
+    try {
+        pool.submit(decoding.size(), requests[0].second, num_iterations);
+    } catch (const IncorrectValueRange&) {
+        thrown = true;
+    }
+    MDPC_GF4_CHECK(thrown);
+
+    auto results = pool.decode_batch(requests, num_iterations, StagnationPolicy::disabled());
+    MDPC_GF4_CHECK(results.size() == requests.size());
+    size_t successes = 0;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const auto& [key_id, message] = requests[i];
+        auto direct = decoding[key_id].decode_with_report(message, num_iterations, StagnationPolicy::disabled());
+        MDPC_GF4_CHECK(results[i].status == direct.status);
+        MDPC_GF4_CHECK(results[i].iterations == direct.iterations);
+        MDPC_GF4_CHECK(results[i].syndrome_weights == direct.syndrome_weights);
+        MDPC_GF4_CHECK(results[i].error_vector.has_value() == direct.error_vector.has_value());
+        if (direct.error_vector) {
+            auto difference = results[i].error_vector.value();
+            for (size_t j = 0; j < difference.size(); ++j) {
+                difference[j] += direct.error_vector.value()[j];
+            }
+            MDPC_GF4_CHECK(is_vector_zero(difference));
+            ++successes;
+        }
+    }
+    MDPC_GF4_CHECK(successes > 0 && successes < requests.size());
+
+    DecodePoolStatistics statistics = pool.get_statistics();
+    MDPC_GF4_CHECK(statistics.executed == requests.size());
+    std::cout << successes << "/" << requests.size() << " decoded, " << statistics.stolen << " requests stolen"
+              << std::endl;
+    return 0;
+}
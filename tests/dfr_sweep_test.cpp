@@ -0,0 +1,52 @@
+#include "../src/gf4.h"
+#include "../src/dfr_sweep.h"
+#include "check.h"
+
+#include <cmath>
+#include <iostream>
+
+/*
+ * Checks the Wilson interval and runs a small sweep whose points stop for each of the three reasons,
+ * checking that every estimate stays within the trial budget and inside its own interval.
+ */
+int main() {
+    MDPC_GF4_CHECK(std::fabs(normal_critical_value(0.05) - 1.959964) < 1e-5);
+    for (auto [trials, failures]: {std::pair<size_t, size_t>{100, 0}, {100, 7}, {50, 50}, {1, 1}}) {
+        auto [lower, upper] = wilson_interval(trials, failures, 1.96);
+        double p = (double)failures / (double)trials;
+        MDPC_GF4_CHECK(0.0 <= lower && lower <= p && p <= upper && upper <= 1.0);
+    }
+
+    SweepTarget target;
+    target.relative_precision = 0.2;
+    target.dfr_floor = 0.1;
+    target.min_trials = 32;
+    target.max_trials = 128;
+    target.batch_size = 8;
+    std::vector<SweepPoint> points = {
+            {307, 15, 2, 20},     // always decoded, stops below the floor
+            {307, 15, 200, 20},   // never decoded, the interval around 1 is narrow at once
+    };
+    auto estimates = run_dfr_sweep<GF4>(points, target, 2, StagnationPolicy::disabled());
+
+    target.dfr_floor = 0.0;
+    target.max_trials = 40;
+    auto budget = run_dfr_sweep<GF4>({{307, 15, 2, 20}}, target, 2, StagnationPolicy::disabled());
+    estimates.push_back(budget[0]);
+
+    for (const SweepEstimate& estimate: estimates) {
+        std::cout << "t = " << estimate.point.error_weight << ": " << estimate.failures << "/" << estimate.trials
+                  << " failures, interval [" << estimate.lower << ", " << estimate.upper << "]" << std::endl;
+        MDPC_GF4_CHECK(estimate.trials >= target.min_trials || estimate.reason == SweepStopReason::TrialBudget);
+        MDPC_GF4_CHECK(estimate.trials <= 128);
+        MDPC_GF4_CHECK(estimate.failures <= estimate.trials);
+        MDPC_GF4_CHECK(estimate.lower <= estimate.dfr && estimate.dfr <= estimate.upper);
+    }
+    MDPC_GF4_CHECK(estimates[0].reason == SweepStopReason::BelowFloor);
+    MDPC_GF4_CHECK(estimates[0].failures == 0 && estimates[0].upper < 0.1);
+    MDPC_GF4_CHECK(estimates[1].reason == SweepStopReason::PrecisionReached);
+    MDPC_GF4_CHECK(estimates[1].failures == estimates[1].trials);
+    MDPC_GF4_CHECK(estimates[2].reason == SweepStopReason::TrialBudget);
+    MDPC_GF4_CHECK(estimates[2].trials == 40);
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include "../src/gf4.h"
+#include "../src/factorization.h"
+#include "check.h"
+
+#include <iostream>
+
+/*
+ * Checks the bit-sliced GF(4) distinct-degree factorization against the generic one
+ * and the products of the factors returned by factor against the factored polynomial.
+ */
+int main() {
+    for (size_t trial = 0; trial < 60; ++trial) {
+        size_t degree = 2 + 3 * trial;
+        auto coefficients = Random::random_vector_over_GF2N<GF4>(degree + 1);
+        coefficients[degree] = GF4{1};
+        PolynomialGF2N<GF4> f{coefficients};
+        for (auto& [g, e]: squarefree_factorization(f)) {
+            auto bitsliced = distinct_degree_factorization(g);
+            auto generic = distinct_degree_factorization<GF4>(g);
+            MDPC_GF4_CHECK(bitsliced.size() == generic.size());
+            for (size_t i = 0; i < generic.size(); ++i) {
+                MDPC_GF4_CHECK(std::get<1>(bitsliced[i]) == std::get<1>(generic[i]));
+                MDPC_GF4_CHECK(polynomials_equal(std::get<0>(bitsliced[i]), std::get<0>(generic[i])));
+            }
+        }
+        auto product = PolynomialGF2N<GF4>::make_one();
+        for (auto& [g, e]: factor(f)) {
+            for (size_t i = 0; i < e; ++i) {
+                product = product * g;
+            }
+        }
+        MDPC_GF4_CHECK(polynomials_equal(product, f));
+    }
+    std::cout << "factorization: ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "../src/gf4.h"
+#include "../src/key_set.h"
+#include "check.h"
+
+#include <iostream>
+
+/*
+ * Rotates the key set many times while reader threads keep using it. Every reader checks that the version
+ * it sees never decreases and that the set it holds is intact, i.e. its encoding and decoding keys still match.
+ */
+int main() {
+    const size_t block_size = 307;
+    const size_t block_weight = 15;
+    std::vector<KeySet<GF4>> sets;
+    for (size_t i = 0; i < 4; ++i) {
+        sets.push_back(generate_key_set<GF4>(1, block_size, block_weight));
+    }
+
+    const size_t num_readers = 4;
+    KeySetHolder<GF4> holder{sets[0], num_readers};
+    std::atomic<bool> done{false};
+    std::atomic<size_t> reads{0};
+    std::atomic<size_t> broken{0};
+    std::atomic<size_t> registered{0};
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < num_readers; ++r) {
+        readers.emplace_back([&]() {
+            auto reader = holder.register_reader();
+            ++registered;
+            uint64_t last_version = 0;
+            while (!done.load()) {
+                auto guard = reader.lock();
+                auto codeword = guard->encoding[0].encode(Random::random_vector_over_GF2N<GF4>(block_size));
+                if (guard->version < last_version || !is_vector_zero(guard->decoding[0].calculate_syndrome(codeword))) {
+                    ++broken;
+                }
+                last_version = guard->version;
+                ++reads;
+            }
+        });
+    }
+
+    uint64_t last_published = 1;
+    for (size_t rotation = 0; rotation < 32; ++rotation) {
+        size_t seen = reads.load();
+        while (reads.load() < seen + num_readers) {
+            std::this_thread::yield();
+        }
+        uint64_t version = holder.publish(sets[(rotation + 1) % sets.size()]);
+        MDPC_GF4_CHECK(version == last_published + 1);
+        last_published = version;
+    }
+    holder.rotate_in_background([&]() { return sets[0]; }).get();
+
+    // every slot is taken, so one more reader is refused
+    while (registered.load() < num_readers) {
+        std::this_thread::yield();
+    }
+    bool refused = false;
+    try {
+        holder.register_reader();
+    } catch (const TooManyReaders&) {
+        refused = true;
+    }
+    MDPC_GF4_CHECK(refused);
+
+    done.store(true);
+    for (auto& thread: readers) {
+        thread.join();
+    }
+    holder.synchronize();
+    MDPC_GF4_CHECK(holder.reclaim() == 0);
+    MDPC_GF4_CHECK(broken.load() == 0);
+    auto reader = holder.register_reader();
+    MDPC_GF4_CHECK(reader.lock()->version == last_published + 1);
+    std::cout << reads.load() << " reads during 33 rotations" << std::endl;
+    return 0;
+}
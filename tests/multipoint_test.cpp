@@ -0,0 +1,78 @@
+#include "../src/gf4.h"
+#include "../src/gf4_extension.h"
+#include "../src/multipoint.h"
+#include "../src/random.h"
+#include "check.h"
+
+#include <iostream>
+
+using Field = GF4Extension<5>;
+
+/*
+ * Evaluates random polynomials over GF(4^5) at all points of subproduct trees with and without the Newton division,
+ * compares the values with Horner evaluation (PolynomialGF2N::evaluate) and interpolates them back.
+ */
+static auto random_polynomial(size_t degree) -> PolynomialGF2N<Field> {
+    std::vector<Field> coefficients = Random::random_vector_over_GF2N<Field>(degree + 1);
+    coefficients[degree] = Field{1};
+    return PolynomialGF2N<Field>{coefficients};
+}
+
+static auto same_polynomial(const PolynomialGF2N<Field>& a, const PolynomialGF2N<Field>& b) -> bool {
+    return (a + b).is_zero();
+}
+
+int main() {
+    for (size_t num_points: {5, 64, 300}) {
+        std::vector<Field> points;
+        for (size_t i = 0; i < num_points; ++i) {
+            points.emplace_back(3 * i + 1);
+        }
+        SubproductTree<Field> tree{points};
+        MDPC_GF4_CHECK(tree.get_root().get_degree() == num_points);
+
+        // below the number of points, at the number of points and beyond the root
+        for (size_t degree: {num_points - 1, num_points, 2 * num_points + 5}) {
+            PolynomialGF2N<Field> p = random_polynomial(degree);
+            std::vector<Field> values = tree.evaluate(p);
+            MDPC_GF4_CHECK(values.size() == num_points);
+            for (size_t i = 0; i < num_points; ++i) {
+                MDPC_GF4_CHECK(values[i] == p.evaluate(points[i]));
+            }
+            if (degree < num_points) {
+                MDPC_GF4_CHECK(same_polynomial(tree.interpolate(values), p));
+            }
+        }
+
+        // the interpolation weights are cached by the first interpolation, a second one must agree
+        std::vector<Field> values = Random::random_vector_over_GF2N<Field>(num_points);
+        PolynomialGF2N<Field> q = tree.interpolate(values);
+        MDPC_GF4_CHECK(q.get_degree() < num_points);
+        for (size_t i = 0; i < num_points; ++i) {
+            MDPC_GF4_CHECK(q.evaluate(points[i]) == values[i]);
+        }
+
+        bool thrown = false;
+        try {
+            tree.interpolate(std::vector<Field>(num_points + 1));
+        } catch (const IncorrectInputVectorLength&) {
+            thrown = true;
+        }
+        MDPC_GF4_CHECK(thrown);
+        std::cout << num_points << " points: evaluation and interpolation match Horner" << std::endl;
+    }
+
+    // a polynomial over GF(4) evaluated in the extension
+    std::vector<GF4> base = Random::random_vector_over_GF2N<GF4>(100);
+    PolynomialGF2N<GF4> p{base};
+    PolynomialGF2N<Field> embedded = embed_polynomial<Field>(p);
+    std::vector<Field> points;
+    for (size_t i = 0; i < 100; ++i) {
+        points.emplace_back(i + 7);
+    }
+    std::vector<Field> values = SubproductTree<Field>{points}.evaluate(embedded);
+    for (size_t i = 0; i < points.size(); ++i) {
+        MDPC_GF4_CHECK(values[i] == embedded.evaluate(points[i]));
+    }
+    return 0;
+}